@@ -1,7 +1,12 @@
-#version 330 core
+#version 430 core
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in mat4 aInstanceMatrix;
+layout (location = 7) in uint aInstanceIndex; // written by the cull pass, offset per LOD by baseInstance
+
+layout (std430, binding = 0) readonly buffer InstanceTransforms
+{
+    mat4 modelMatrices[];
+};
 
 out vec2 TexCoords;
 
@@ -11,5 +16,5 @@ uniform mat4 view;
 void main()
 {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0f); 
-}
\ No newline at end of file
+    gl_Position = projection * view * modelMatrices[aInstanceIndex] * vec4(aPos, 1.0f); 
+}
@@ -0,0 +1,62 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct DrawElementsIndirectCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 1) readonly buffer InstanceBounds
+{
+    vec4 bounds[]; // xyz = world space center, w = world space radius
+};
+
+layout (std430, binding = 2) writeonly buffer VisibleInstances
+{
+    uint visibleIndices[];
+};
+
+layout (std430, binding = 3) buffer DrawCommands
+{
+    DrawElementsIndirectCommand commands[];
+};
+
+uniform int instanceCount;
+uniform vec4 frustumPlanes[6];
+uniform vec3 cameraPos;
+uniform int lodCount;
+uniform float lodDistances[4];
+uniform int lodFirstCommands[4]; // a command per mesh of the LOD, all drawing its list
+uniform int lodCommandCounts[4];
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(instanceCount))
+        return;
+
+    vec4 sphere = bounds[id];
+    for (int i = 0; i < 6; i++)
+    {
+        if (dot(frustumPlanes[i].xyz, sphere.xyz) + frustumPlanes[i].w < -sphere.w)
+            return;
+    }
+
+    // pick the first LOD whose range still covers the instance, past the last one it is not drawn at all
+    float dist = distance(cameraPos, sphere.xyz) - sphere.w;
+    int lod = 0;
+    while (lod < lodCount && dist > lodDistances[lod])
+        lod++;
+    if (lod == lodCount)
+        return;
+
+    int first = lodFirstCommands[lod];
+    uint slot = atomicAdd(commands[first].instanceCount, 1u);
+    for (int i = 1; i < lodCommandCounts[lod]; i++)
+        atomicAdd(commands[first + i].instanceCount, 1u);
+    visibleIndices[commands[first].baseInstance + slot] = id;
+}
@@ -10,6 +10,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/instance_culler.h>
 
 #include <iostream>
 
@@ -37,7 +38,7 @@ int main()
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // compute shaders and indirect draws
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -117,39 +118,27 @@ int main()
         modelMatrices[i] = model;
     }
 
-    // configure instanced array
-    // -------------------------
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-
-    // set transformation matrices as an instance vertex attribute (with divisor 1)
-    // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
-    // normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
-    // -----------------------------------------------------------------------------------------------------------------------------------
+    // configure gpu culling
+    // ----------------------
+    // bounding sphere of the rock in model space
+    glm::vec3 rockMin(std::numeric_limits<float>::max()), rockMax(-std::numeric_limits<float>::max());
     for (unsigned int i = 0; i < rock.meshes.size(); i++)
     {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
+        for (unsigned int j = 0; j < rock.meshes[i].vertices.size(); j++)
+        {
+            rockMin = glm::min(rockMin, rock.meshes[i].vertices[j].Position);
+            rockMax = glm::max(rockMax, rock.meshes[i].vertices[j].Position);
+        }
     }
 
+    // the transforms live in a shader storage buffer now, the cull pass writes the indices of the visible
+    // rocks into a compacted list that replaces the per-instance matrix attribute
+    InstanceCuller culler("instance_cull.cs", modelMatrices, amount, (rockMin + rockMax) * 0.5f, glm::length(rockMax - rockMin) * 0.5f);
+    culler.addLod(rock.meshes, 1000.0f); // the rock only ships one LOD, finer ones go first when available
+    delete[] modelMatrices;
+
+    float lastStatsTime = 0.0f;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -186,16 +175,19 @@ int main()
         planetShader.setMat4("model", model);
         planet.Draw(planetShader);
 
-        // draw meteorites
+        // cull and draw meteorites, the cull pass binds its own compute program
+        culler.cull(projection, view, camera.Position);
         asteroidShader.use();
         asteroidShader.setInt("texture_diffuse1", 0);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
-        for (unsigned int i = 0; i < rock.meshes.size(); i++)
+        culler.draw();
+
+        // visible / total statistics, reading them back stalls on the cull pass so only do it once a second
+        if (currentFrame - lastStatsTime >= 1.0f)
         {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
-            glBindVertexArray(0);
+            std::cout << "asteroids visible: " << culler.readVisibleCount() << " / " << culler.getTotalCount() << std::endl;
+            lastStatsTime = currentFrame;
         }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -0,0 +1,5 @@
+#version 330 core
+
+// occluders only write depth
+void main() {
+}
@@ -0,0 +1,98 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct Bounds
+{
+    vec4 minCorner;
+    vec4 maxCorner;
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBounds
+{
+    Bounds bounds[];
+};
+
+layout (std430, binding = 1) writeonly buffer ObjectVisibility
+{
+    uint visibility[];
+};
+
+layout (std430, binding = 2) buffer OcclusionStats
+{
+    uint occludedCount;
+};
+
+layout (binding = 0) uniform sampler2D hiZ;
+
+uniform mat4 viewProjection;
+uniform int objectCount;
+uniform int hiZLevels;
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(objectCount))
+        return;
+
+    vec3 minCorner = bounds[id].minCorner.xyz;
+    vec3 maxCorner = bounds[id].maxCorner.xyz;
+
+    // screen space rectangle and nearest depth of the box
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float nearestDepth = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = vec3((i & 1) != 0 ? maxCorner.x : minCorner.x,
+                           (i & 2) != 0 ? maxCorner.y : minCorner.y,
+                           (i & 4) != 0 ? maxCorner.z : minCorner.z);
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+        // crossing the camera plane, we can't bound it on screen so it is always visible
+        if (clip.w <= 0.0)
+        {
+            visibility[id] = 1u;
+            return;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+    uvMin = clamp(uvMin, 0.0, 1.0);
+    uvMax = clamp(uvMax, 0.0, 1.0);
+
+    // texels are picked in level 0 and shifted down: hiz_reduce folds an odd last row/column into the last texel
+    // of the next level, so the clamped shift lands on the texel that really covers the box, where scaling the
+    // uv by an odd level's size can round down one texel short of it
+    ivec2 baseSize = textureSize(hiZ, 0);
+    ivec2 baseMin = min(ivec2(uvMin * vec2(baseSize)), baseSize - 1);
+    ivec2 baseMax = min(ivec2(uvMax * vec2(baseSize)), baseSize - 1);
+
+    // pick the level where the rectangle covers about 2x2 texels, then step up until it really does.
+    // level sizes follow the mip rule rather than textureSize(hiZ, level): llvmpipe returns one lane's size
+    // for the whole group when the level differs between invocations
+    vec2 size = (uvMax - uvMin) * vec2(baseSize);
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, hiZLevels - 1);
+    ivec2 levelSize = max(baseSize >> level, ivec2(1));
+    ivec2 texelMin = min(baseMin >> level, levelSize - 1);
+    ivec2 texelMax = min(baseMax >> level, levelSize - 1);
+    while (level < hiZLevels - 1 && any(greaterThan(texelMax - texelMin, ivec2(1))))
+    {
+        level++;
+        levelSize = max(baseSize >> level, ivec2(1));
+        texelMin = min(baseMin >> level, levelSize - 1);
+        texelMax = min(baseMax >> level, levelSize - 1);
+    }
+
+    float occluderDepth = 0.0;
+    for (int y = texelMin.y; y <= texelMax.y; y++)
+    {
+        for (int x = texelMin.x; x <= texelMax.x; x++)
+            occluderDepth = max(occluderDepth, texelFetch(hiZ, ivec2(x, y), level).r);
+    }
+
+    bool occluded = nearestDepth > occluderDepth;
+    visibility[id] = occluded ? 0u : 1u;
+    if (occluded)
+        atomicAdd(occludedCount, 1u);
+}
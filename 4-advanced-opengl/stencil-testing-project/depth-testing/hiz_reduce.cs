@@ -0,0 +1,49 @@
+#version 430 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// level 0 is copied from the depth pre-pass, every other level reduces the 2x2 (or 3x3 on odd edges) texels below it
+layout (binding = 0) uniform sampler2D depthMap;
+layout (r32f, binding = 0) uniform readonly image2D srcLevel;
+layout (r32f, binding = 1) uniform writeonly image2D dstLevel;
+
+uniform bool copyDepth;
+uniform bool reduceMax; // max keeps the farthest occluder depth (GL_LESS), min is for reversed depth
+
+float reduce(float a, float b)
+{
+    return reduceMax ? max(a, b) : min(a, b);
+}
+
+void main()
+{
+    ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dstSize = imageSize(dstLevel);
+    if (dst.x >= dstSize.x || dst.y >= dstSize.y)
+        return;
+
+    if (copyDepth)
+    {
+        imageStore(dstLevel, dst, vec4(texelFetch(depthMap, dst, 0).r));
+        return;
+    }
+
+    ivec2 srcSize = imageSize(srcLevel);
+    ivec2 src = dst * 2;
+    // an odd source size leaves a row/column that would otherwise be skipped by the last texel of this level
+    ivec2 extent = ivec2(2);
+    if (dst.x == dstSize.x - 1 && (srcSize.x & 1) == 1)
+        extent.x = 3;
+    if (dst.y == dstSize.y - 1 && (srcSize.y & 1) == 1)
+        extent.y = 3;
+
+    float depth = imageLoad(srcLevel, src).r;
+    for (int y = 0; y < extent.y; y++)
+    {
+        for (int x = 0; x < extent.x; x++)
+        {
+            ivec2 texel = min(src + ivec2(x, y), srcSize - 1);
+            depth = reduce(depth, imageLoad(srcLevel, texel).r);
+        }
+    }
+    imageStore(dstLevel, dst, vec4(depth));
+}
@@ -9,6 +9,9 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/occlusion_culler.h>
+#include <learnopengl/occlusion_rasterizer.h>
 
 #include <irrklang/irrKlang.h>
 using namespace irrklang;
@@ -20,6 +23,7 @@ using namespace irrklang;
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 unsigned int loadTexture(const char* path);
 void processInput(GLFWwindow* window);
 
@@ -42,6 +46,10 @@ float lastFrame = 0.0f;
 // gun selection
 int gun_selected = 1;
 
+// occlusion culling (O: toggle culling, C: toggle cpu fallback)
+bool occlusion_culling = true;
+bool cpu_occlusion = false;
+
 
 /// Audio
 
@@ -84,7 +92,7 @@ audio_stop_cb* eventReceiver = new audio_stop_cb();
 
 int main() {
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // compute shaders for the hi-z pyramid
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -101,6 +109,7 @@ int main() {
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -117,6 +126,7 @@ int main() {
 	Shader normalShader("shader.vert", "shader.frag");
 	Shader gunShader("shader.vert", "shader_gun.frag");
 	Shader outlineShader("shader.vert", "shader_outline.frag");
+	Shader depthShader("shader.vert", "depth_prepass.frag");
 
 	Model wallModel ("../../resources/fps-scene/wall/wall_offset.obj");
 	Model floorModel ("../../resources/fps-scene/floor/floor_offset.obj");
@@ -125,6 +135,30 @@ int main() {
 	std::vector<Model> guns (3, gun_path);
 	std::vector<glm::vec4> gun_colors = {glm::vec4(0.0), glm::vec4(0.5, 0.1, 0.9, 1.0), glm::vec4(0.6, 0.3, 0.1, 1.0)};
 
+	// occlusion culling: the walls and floor are the occluders, the guns are tested against them
+	HiZOcclusionCuller occlusionCuller("hiz_reduce.cs", "hiz_cull.cs", SCR_WIDTH / 2, SCR_HEIGHT / 2);
+	JobSystem occlusionJobs; // the rasterizer's workers, created once
+	OcclusionRasterizer occlusionRasterizer(SCR_WIDTH / 4, SCR_HEIGHT / 4, occlusionJobs);
+
+	std::vector<Entity> gunEntities;
+	gunEntities.reserve(guns.size());
+	for (unsigned int i = 0; i < guns.size(); i++) {
+		gunEntities.emplace_back(guns[i]);
+		gunEntities[i].transform.setLocalPosition(glm::vec3(0.0, 1.0 + i, 0.2));
+		gunEntities[i].transform.setLocalRotation(glm::vec3(0.0, 90.0, 0.0));
+		gunEntities[i].transform.setLocalScale(glm::vec3(0.2));
+		gunEntities[i].updateSelfAndChild();
+
+		AABB bounds = gunEntities[i].getGlobalAABB();
+		occlusionCuller.addObject(bounds.center - bounds.extents, bounds.center + bounds.extents);
+	}
+	std::vector<bool> gun_visible(guns.size(), true);
+
+	// stats
+	float statsTime = 0.0f;
+	float cullTime = 0.0f;
+	int statsFrames = 0;
+
 	glEnable(GL_STENCIL_TEST); // enable stencil testing
 	glStencilFunc(GL_ALWAYS, 0, 0xFF); // always pass, ref=0
 	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE); // if both depth and stencil test pass, set stencil_value = 1
@@ -143,8 +177,6 @@ int main() {
 
 		glStencilMask(0x00); // disable stencil buffer writing
 
-		normalShader.use();
-
 		glm::mat4 model, view, projection;
 		model = view = projection = glm::mat4(1.0);
 
@@ -153,6 +185,38 @@ int main() {
 		view = camera.GetViewMatrix();
 		projection = glm::perspective(glm::radians(camera.Zoom), (float)CURR_SCR_WIDTH / (float)CURR_SCR_HEIGHT, 0.1f, 100.0f);
 
+		// occlusion pass: occluder depth -> hi-z pyramid -> gun boxes (or the cpu buffer when the fallback is selected)
+		if (occlusion_culling && !cpu_occlusion) {
+			occlusionCuller.beginOccluderPass();
+			depthShader.use();
+			depthShader.setMat4("model", model);
+			depthShader.setMat4("view", view);
+			depthShader.setMat4("projection", projection);
+			floorModel.Draw(depthShader);
+			wallModel.Draw(depthShader);
+			occlusionCuller.endOccluderPass(CURR_SCR_WIDTH, CURR_SCR_HEIGHT);
+			occlusionCuller.cull(projection * view);
+
+			for (unsigned int i = 0; i < guns.size(); i++)
+				gun_visible[i] = occlusionCuller.isVisible(i);
+			cullTime += occlusionCuller.getGpuTimeMs();
+		}
+		else if (occlusion_culling) {
+			float cullStart = static_cast<float>(glfwGetTime());
+			occlusionRasterizer.beginFrame(projection * view);
+			occlusionRasterizer.addOccluder(floorModel, model);
+			occlusionRasterizer.addOccluder(wallModel, model);
+			occlusionRasterizer.rasterize();
+
+			for (unsigned int i = 0; i < guns.size(); i++)
+				gun_visible[i] = occlusionRasterizer.isVisible(gunEntities[i]);
+			cullTime += (static_cast<float>(glfwGetTime()) - cullStart) * 1000.0f;
+		}
+		else {
+			std::fill(gun_visible.begin(), gun_visible.end(), true);
+		}
+
+		normalShader.use();
 		normalShader.setMat4("model", model);
 		normalShader.setMat4("view", view);
 		normalShader.setMat4("projection", projection);
@@ -170,10 +234,12 @@ int main() {
 		float selected_offset_y = 0;
 		
 		for (int i = 0; i < guns.size(); i++) {
-			model = glm::mat4(1.0);
-			model = glm::translate(model, glm::vec3(0.0, 1.0 + gun_offset_y, 0.2));
-			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0, 1.0, 0.0));
-			model = glm::scale(model, glm::vec3(0.2));
+			if (!gun_visible[i]) {
+				gun_offset_y += 1.0;
+				continue;
+			}
+
+			model = gunEntities[i].transform.getModelMatrix();
 
 			gunShader.setMat4("model", model);
 			gunShader.setVec4("gun_color", gun_colors[i]);
@@ -215,10 +281,24 @@ int main() {
 
 		outlineShader.setMat4("model", model);
 
-		guns[selected_index].Draw(outlineShader);
+		if (gun_visible[selected_index])
+			guns[selected_index].Draw(outlineShader);
 
 		glStencilFunc(GL_ALWAYS, 0, 0xFF); // always pass, ref=0
 
+		// print the occlusion stats and the frame time about once a second, toggle culling to compare
+		statsFrames++;
+		if (currentTime - statsTime >= 1.0f) {
+			int occluded = static_cast<int>(std::count(gun_visible.begin(), gun_visible.end(), false));
+			std::cout << "occlusion " << (occlusion_culling ? (cpu_occlusion ? "cpu" : "hi-z") : "off")
+				<< " | occluded: " << occluded << " / " << guns.size()
+				<< " | cull: " << cullTime / statsFrames << " ms"
+				<< " | frame: " << (currentTime - statsTime) * 1000.0f / statsFrames << " ms" << std::endl;
+			statsTime = currentTime;
+			cullTime = 0.0f;
+			statsFrames = 0;
+		}
+
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
@@ -286,6 +366,13 @@ void processInput(GLFWwindow* window) {
 	}
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (key == GLFW_KEY_O && action == GLFW_PRESS)
+		occlusion_culling = !occlusion_culling;
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+		cpu_occlusion = !cpu_occlusion;
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 	glViewport(0, 0, width, height);
 	CURR_SCR_HEIGHT = height;
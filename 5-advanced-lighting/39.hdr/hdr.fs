@@ -7,6 +7,8 @@ in vec2 TexCoords;
 uniform sampler2D hdrBuffer; // floating point color texture
 uniform bool hdr;
 uniform float exposure;
+uniform bool autoExposure;         // measured on the GPU (see auto_exposure.h) instead of keyed in
+uniform sampler2D exposureTexture; // 1x1: exposure, adapted luminance
 
 float map(float value, float min1, float max1, float min2, float max2) {
     return min2 + (value - min1) * (max2 - min2) / (max1 - min1);
@@ -52,7 +54,7 @@ void main() {
         if(luminance > lum_limit) // ignore too bright spots
             luminance = lum_limit;
         
-        float exposure_val = map(luminance, 0.015, lum_limit, 3.5, 0.2);
+        float exposure_val = autoExposure ? texelFetch(exposureTexture, ivec2(0), 0).r : map(luminance, 0.015, lum_limit, 3.5, 0.2);
         // float exposure_val = pow(base, map(luminance, 0.015, lum_limit, lg(3.5, base), lg(0.2, base)));
 
         const float gamma = 2.2;
@@ -0,0 +1,76 @@
+#version 430 core
+layout (local_size_x = 256) in;
+
+// second pass of auto_exposure.h: one invocation per bin averages the log luminance between two percentiles of
+// the histogram and adapts the exposure towards it
+layout (std430, binding = 0) buffer Histogram
+{
+    uint histogram[256];
+};
+layout (rg32f, binding = 0) uniform image2D exposure; // (exposure, adapted luminance)
+
+uniform float minLogLuminance;
+uniform float logRange;
+uniform float lowPercentile;
+uniform float highPercentile;
+uniform float speedUp;
+uniform float speedDown;
+uniform float keyValue;
+uniform float deltaTime;
+
+shared float counts[256];
+shared float weights[256];
+
+void main()
+{
+    uint bin = gl_LocalInvocationIndex;
+    float count = bin == 0u ? 0.0 : float(histogram[bin]); // black pixels don't count
+    histogram[bin] = 0u; // ready for the next frame
+
+    // inclusive prefix sum over the bins: how many pixels are darker than or in this bin
+    counts[bin] = count;
+    barrier();
+    for (uint stride = 1u; stride < 256u; stride *= 2u)
+    {
+        float previous = bin >= stride ? counts[bin - stride] : 0.0;
+        barrier();
+        counts[bin] += previous;
+        barrier();
+    }
+    float total = counts[255];
+    float below = counts[bin] - count;
+
+    // the part of this bin between the percentiles, weighted by the log luminance of the bin's center
+    float kept = max(min(counts[bin], highPercentile * total) - max(below, lowPercentile * total), 0.0);
+    float binLogLuminance = minLogLuminance + (float(bin) - 0.5) / 254.0 * logRange;
+    barrier();
+    counts[bin] = kept;
+    weights[bin] = kept * binLogLuminance;
+    barrier();
+    for (uint stride = 128u; stride > 0u; stride /= 2u)
+    {
+        if (bin < stride)
+        {
+            counts[bin] += counts[bin + stride];
+            weights[bin] += weights[bin + stride];
+        }
+        barrier();
+    }
+
+    if (bin == 0u)
+    {
+        // an empty (black) frame keeps the current exposure
+        vec2 previous = imageLoad(exposure, ivec2(0)).rg;
+        float adapted = previous.g;
+        if (counts[0] > 0.0)
+        {
+            float luminance = exp2(weights[0] / counts[0]);
+            if (adapted <= 0.0)
+                adapted = luminance;
+            else
+                adapted += (luminance - adapted) * (1.0 - exp(-deltaTime * (luminance > adapted ? speedUp : speedDown)));
+        }
+        if (adapted > 0.0)
+            imageStore(exposure, ivec2(0), vec4(keyValue / adapted, adapted, 0.0, 0.0));
+    }
+}
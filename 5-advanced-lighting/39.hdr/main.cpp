@@ -9,8 +9,10 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/auto_exposure.h>
 
 #include <iostream>
+#include <memory>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -28,6 +30,9 @@ const unsigned int SCR_HEIGHT = 600;
 bool hdr = true;
 bool hdrKeyPressed = false;
 float exposure = 1.0f;
+// x switches between the keyed exposure and one adapted to a histogram of the hdr buffer (see auto_exposure.h)
+bool autoExposure = true;
+bool autoExposureKeyPressed = false;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
@@ -44,12 +49,16 @@ int main()
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // compute shaders for the auto exposure; macOS stops at 4.1, where only the keyed exposure is left
 #ifdef __APPLE__
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 #endif
 
     // glfw window creation
@@ -85,6 +94,11 @@ int main()
     // -------------------------
     Shader shader("lighting.vs", "lighting.fs");
     Shader hdrShader("hdr.vs", "hdr.fs");
+    std::unique_ptr<AutoExposure> exposureMeter;
+    if (GLAD_GL_VERSION_4_3)
+        exposureMeter.reset(new AutoExposure("luminance_histogram.cs", "luminance_average.cs"));
+    else
+        autoExposure = false;
 
     // load textures
     // -------------
@@ -138,6 +152,7 @@ int main()
     shader.setInt("diffuseTexture", 0);
     hdrShader.use();
     hdrShader.setInt("hdrBuffer", 0);
+    hdrShader.setInt("exposureTexture", 1);
 
     // render loop
     // -----------
@@ -193,6 +208,10 @@ int main()
         // bind default fbo
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+        // measure the frame and adapt the exposure to it, it stays on the GPU for the tonemapping below
+        if (autoExposure)
+            exposureMeter->update(colorBuffer, SCR_WIDTH, SCR_HEIGHT, deltaTime);
+
         // 2. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
         
@@ -206,6 +225,12 @@ int main()
         glBindTexture(GL_TEXTURE_2D, colorBuffer); 
         hdrShader.setInt("hdr", hdr);
         hdrShader.setFloat("exposure", exposure);
+        hdrShader.setBool("autoExposure", autoExposure);
+        if (exposureMeter)
+        {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, exposureMeter->getExposureTexture());
+        }
         renderQuad();
 
         // std::cout << "exposure = " << exposure << std::endl;
@@ -354,6 +379,18 @@ void processInput(GLFWwindow *window)
         hdrKeyPressed = false;
     }
 
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS && !autoExposureKeyPressed)
+    {
+        autoExposure = !autoExposure && GLAD_GL_VERSION_4_3;
+        autoExposureKeyPressed = true;
+
+        std::cout << "exposure: " << (autoExposure ? "auto" : "keyed") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_RELEASE)
+    {
+        autoExposureKeyPressed = false;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
     {
         if (exposure > 0.0f)
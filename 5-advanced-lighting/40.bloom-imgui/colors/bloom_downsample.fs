@@ -0,0 +1,61 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source; // the hdr scene for the first mip, the previous mip after that
+uniform bool firstMip;
+uniform float threshold;
+uniform float knee;
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// soft threshold: nothing below threshold - knee, a quadratic ramp up to threshold + knee, all above
+vec3 prefilter(vec3 color) {
+    float brightness = luminance(color);
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 0.0001);
+    return color * max(soft, brightness - threshold) / max(brightness, 0.0001);
+}
+
+void main() {
+    // 13 bilinear taps around this pixel, in texels of the source (which is twice the size of the target):
+    // a - b - c
+    // - j - k -
+    // d - e - f
+    // - l - m -
+    // g - h - i
+    vec2 texel = 1.0 / textureSize(source, 0);
+    vec3 a = texture(source, TexCoords + texel * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(source, TexCoords + texel * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(source, TexCoords + texel * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(source, TexCoords + texel * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(source, TexCoords).rgb;
+    vec3 f = texture(source, TexCoords + texel * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(source, TexCoords + texel * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(source, TexCoords + texel * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(source, TexCoords + texel * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(source, TexCoords + texel * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(source, TexCoords + texel * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(source, TexCoords + texel * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(source, TexCoords + texel * vec2( 1.0, -1.0)).rgb;
+
+    // five overlapping 2x2 boxes: the four corner ones weigh 0.125, the center one 0.5
+    vec3 boxes[5] = vec3[](
+        (a + b + d + e) * 0.25, (b + c + e + f) * 0.25, (d + e + g + h) * 0.25, (e + f + h + i) * 0.25, (j + k + l + m) * 0.25);
+    float weights[5] = float[](0.125, 0.125, 0.125, 0.125, 0.5);
+    vec3 result = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int box = 0; box < 5; ++box)
+    {
+        // Karis average on the first mip: bright boxes count less, so a single bright pixel can't dominate
+        float weight = firstMip ? weights[box] / (1.0 + luminance(boxes[box])) : weights[box];
+        result += boxes[box] * weight;
+        totalWeight += weight;
+    }
+    result /= totalWeight;
+
+    FragColor = firstMip ? prefilter(result) : result;
+}
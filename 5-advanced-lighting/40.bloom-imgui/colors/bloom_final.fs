@@ -6,7 +6,10 @@ in vec2 TexCoords;
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform bool bloom;
+uniform float bloomStrength; // 1 for the gaussian blurs, 1 / mips for the mip chain
 uniform float exposure;
+uniform bool autoExposure;         // measured on the GPU (see auto_exposure.h) instead of keyed in
+uniform sampler2D exposureTexture; // 1x1: exposure, adapted luminance
 
 void main() {
     const float gamma = 2.2;
@@ -14,10 +17,11 @@ void main() {
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
 
     if(bloom)
-        hdrColor += bloomColor;
+        hdrColor += bloomColor * bloomStrength;
 
     // tone mapping
-    vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
+    float sceneExposure = autoExposure ? texelFetch(exposureTexture, ivec2(0), 0).r : exposure;
+    vec3 result = vec3(1.0) - exp(-hdrColor * sceneExposure);
     result = pow(result, vec3(1.0 / gamma)); // gamma correction
 
     FragColor = vec4(result, 1.0);
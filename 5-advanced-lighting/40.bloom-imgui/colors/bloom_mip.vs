@@ -0,0 +1,9 @@
+#version 330 core
+out vec2 TexCoords;
+
+// one triangle covering the screen, made from the vertex index so no vertex buffer is needed
+void main() {
+    vec2 position = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    TexCoords = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;   // the next smaller mip, already holding everything below it
+uniform float filterRadius; // in texels of source
+
+void main() {
+    // 3x3 tent, added to this mip's own downsample by blending
+    vec2 texel = filterRadius / textureSize(source, 0);
+    vec3 result = texture(source, TexCoords).rgb * 4.0;
+    result += texture(source, TexCoords + vec2(-texel.x, 0.0)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2( texel.x, 0.0)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(0.0, -texel.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(0.0,  texel.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(-texel.x, -texel.y)).rgb;
+    result += texture(source, TexCoords + vec2( texel.x, -texel.y)).rgb;
+    result += texture(source, TexCoords + vec2(-texel.x,  texel.y)).rgb;
+    result += texture(source, TexCoords + vec2( texel.x,  texel.y)).rgb;
+    FragColor = result / 16.0;
+}
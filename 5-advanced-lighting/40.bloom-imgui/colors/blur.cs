@@ -0,0 +1,60 @@
+#version 430 core
+#define TILE 128
+#define MAX_RADIUS 32
+layout (local_size_x = TILE) in;
+
+// one workgroup blurs one whole row (or column) of the image, TILE pixels at a time (see separable_blur.h)
+uniform sampler2D source;
+layout (binding = 0) uniform writeonly image2D destination; // no format: it's bound with the texture's own
+
+uniform vec2 direction; // (1, 0) blurs the rows, (0, 1) the columns
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+// the pixels of the tile with radius pixels of apron on both sides
+shared vec4 line[TILE + 2 * MAX_RADIUS];
+
+vec4 fetch(int position, int lineIndex, ivec2 size)
+{
+    ivec2 texel = direction.x > 0.5 ? ivec2(position, lineIndex) : ivec2(lineIndex, position);
+    return texelFetch(source, clamp(texel, ivec2(0), size - 1), 0);
+}
+
+void main()
+{
+    ivec2 size = textureSize(source, 0);
+    int lineIndex = int(gl_WorkGroupID.x);
+    int lineLength = direction.x > 0.5 ? size.x : size.y;
+    int i = int(gl_LocalInvocationID.x);
+    int apron = 2 * radius;
+
+    // the first tile loads everything, from radius pixels before the line up to radius pixels after the tile
+    for (int j = i; j < TILE + apron; j += TILE)
+        line[j] = fetch(j - radius, lineIndex, size);
+
+    for (int tileStart = 0; tileStart < lineLength; tileStart += TILE)
+    {
+        if (tileStart > 0)
+        {
+            // the end of the previous window is the start of this one, only the TILE pixels after it are new.
+            // loads are always ahead of the stores, so a line never reads what it has already blurred
+            vec4 carried = i < apron ? line[TILE + i] : vec4(0.0);
+            barrier();
+            if (i < apron)
+                line[i] = carried;
+            line[apron + i] = fetch(tileStart + radius + i, lineIndex, size);
+        }
+        memoryBarrierShared();
+        barrier();
+
+        vec4 result = line[radius + i] * weights[0];
+        for (int k = 1; k <= radius; ++k)
+            result += (line[radius + i - k] + line[radius + i + k]) * weights[k];
+
+        int position = tileStart + i;
+        if (position < lineLength)
+            imageStore(destination, direction.x > 0.5 ? ivec2(position, lineIndex) : ivec2(lineIndex, position), result);
+        // everyone is done reading the window before the next tile moves it
+        barrier();
+    }
+}
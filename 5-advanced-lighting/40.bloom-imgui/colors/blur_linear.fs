@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// fragment fallback of blur.cs: pairs of gaussian taps folded into one bilinear fetch each (see separable_blur.h)
+uniform sampler2D source;
+uniform vec2 direction;      // (1, 0) blurs the rows, (0, 1) the columns
+uniform int tapCount;        // the center and up to MAX_RADIUS / 2 folded taps on each side
+uniform float offsets[17];   // in texels, offsets[0] is the center
+uniform float weights[17];
+
+void main()
+{
+    vec2 texel = direction / vec2(textureSize(source, 0));
+    vec4 result = texture(source, TexCoords) * weights[0];
+    for (int i = 1; i < tapCount; ++i)
+    {
+        result += texture(source, TexCoords + texel * offsets[i]) * weights[i];
+        result += texture(source, TexCoords - texel * offsets[i]) * weights[i];
+    }
+    FragColor = result;
+}
@@ -9,12 +9,16 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/bloom_mips.h>
+#include <learnopengl/separable_blur.h>
+#include <learnopengl/auto_exposure.h>
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
 #include <iostream>
+#include <memory>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -47,12 +51,17 @@ int main()
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // compute shaders for the separable blur and the auto exposure; macOS stops at 4.1, where the blur takes its
+    // fragment fallback and only the keyed exposure is left
 #ifdef __APPLE__
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 #endif
 
     // glfw window creation
@@ -166,6 +175,15 @@ int main()
             std::cout << "pingpongFBO[" << std::to_string(i) << "] is not complete\n";
     }
 
+    // downsample / upsample mip chain, the alternative to the ping-pong blur
+    BloomMips bloomMipChain("bloom_mip.vs", "bloom_downsample.fs", "bloom_upsample.fs", SCR_WIDTH, SCR_HEIGHT);
+    // one wide gaussian in place on the bright pixels (compute shader, or bilinear fragment fallback)
+    SeparableBlur separableBlur("blur.cs", "bloom_mip.vs", "blur_linear.fs");
+    // exposure adapted to a histogram of the hdr color (see auto_exposure.h)
+    std::unique_ptr<AutoExposure> exposureMeter;
+    if (GLAD_GL_VERSION_4_3)
+        exposureMeter.reset(new AutoExposure("luminance_histogram.cs", "luminance_average.cs"));
+
     // lighting info
 
     // positions
@@ -189,10 +207,20 @@ int main()
     shaderBloomFinal.use();
     shaderBloomFinal.setInt("scene", 0);
     shaderBloomFinal.setInt("bloomBlur", 1);
+    shaderBloomFinal.setInt("exposureTexture", 2);
 
     // parameters for imgui and rendering
     int blur_iterations = 10;
     int blur_distance = 5;
+    int bloom_mode = 1; // 0: ping-pong blur of the bright pixels, 1: mip chain from the hdr color (see bloom_mips.h),
+                        // 2: separable gaussian of the bright pixels (see separable_blur.h)
+    int bloom_mips = 6;
+    float bloom_threshold = 1.0f;
+    float bloom_knee = 0.5f;
+    float bloom_filter_radius = 1.0f;
+    bool auto_exposure = exposureMeter != nullptr;
+    int blur_radius = 12;
+    bool blur_fragment_path = false;
 
     // radio button state
     struct ImGuiParameterState
@@ -220,11 +248,16 @@ int main()
         ImGui::NewFrame();
 
         // ImGUI window creation
-        ImGui::SetNextWindowSize(ImVec2(400, 220));
+        ImGui::SetNextWindowSize(ImVec2(400, 470));
         ImGui::Begin("Bloom Parameters");
         ImGui::Text("ALT to unfocus. ENTER to focus");
         ImGui::Checkbox("Bloom", &bloom);
         ImGui::SliderFloat("Exposure", &exposure, 0.0f, 10.0f);
+        if (exposureMeter)
+        {
+            ImGui::Checkbox("Auto exposure", &auto_exposure);
+            ImGui::SliderFloat("Key value", &exposureMeter->keyValue, 0.05f, 2.0f);
+        }
         ImGui::SliderInt("Blur iterations", &blur_iterations, 2, 20);
         ImGui::SliderInt("Blur distance", &blur_distance, 0, 50);
 
@@ -250,6 +283,19 @@ int main()
             ImGui::EndTable();
         }
 
+        ImGui::Separator();
+        ImGui::RadioButton("Ping-pong blur", &bloom_mode, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("Mip chain", &bloom_mode, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Separable", &bloom_mode, 2);
+        ImGui::SliderInt("Mips", &bloom_mips, 1, (int)bloomMipChain.getMipCount());
+        ImGui::SliderFloat("Threshold", &bloom_threshold, 0.0f, 5.0f);
+        ImGui::SliderFloat("Knee", &bloom_knee, 0.0f, 2.0f);
+        ImGui::SliderFloat("Filter radius", &bloom_filter_radius, 0.5f, 3.0f);
+        ImGui::SliderInt("Blur radius", &blur_radius, 1, (int)SeparableBlur::MAX_RADIUS);
+        ImGui::Checkbox("Fragment path", &blur_fragment_path);
+
         ImGui::End();
 
         
@@ -340,25 +386,43 @@ int main()
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 2. blur bright fragments two-pass Gaussian blur, render to pingpongFBO
+        // measure the scene and adapt the exposure to it, it stays on the GPU for the tonemapping below
+        if (auto_exposure)
+            exposureMeter->update(colorBuffers[0], SCR_WIDTH, SCR_HEIGHT, deltaTime);
+
+        // 2. blur bright fragments two-pass Gaussian blur, render to pingpongFBO,
+        //    run the hdr color through the mip chain or blur the bright pixels in place
         bool horizontal = true, first_iteration = true;
-        
-        shaderBlur.use();
-        shaderBlur.setInt("blur_distance", blur_distance);
-        shaderBlur.setInt("blur_algorithm", radio_state.selected_radio);
+        unsigned int bloomTexture;
+        if (bloom_mode == 0)
+        {
+            shaderBlur.use();
+            shaderBlur.setInt("blur_distance", blur_distance);
+            shaderBlur.setInt("blur_algorithm", radio_state.selected_radio);
 
-        for (unsigned int i = 0; i < blur_iterations; i++)
+            for (unsigned int i = 0; i < blur_iterations; i++)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
+                shaderBlur.setInt("horizontal", horizontal);
+                glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
+                renderQuad(); // note: renderQuad specifies texCoords in range [0.0, 1.0], which is the range of texture coordinates
+                              // so we always sample from inside our texture in the fragment shader using the texture coordinates
+                horizontal = !horizontal;
+                if (first_iteration)
+                    first_iteration = false;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            bloomTexture = pingpongColorbuffers[!horizontal]; // use the last rendered to color buffer
+        }
+        else if (bloom_mode == 1)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            shaderBlur.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-            renderQuad(); // note: renderQuad specifies texCoords in range [0.0, 1.0], which is the range of texture coordinates
-                          // so we always sample from inside our texture in the fragment shader using the texture coordinates
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+            bloomTexture = bloomMipChain.render(colorBuffers[0], bloom_mips, bloom_threshold, bloom_knee, bloom_filter_radius);
+        }
+        else
+        {
+            separableBlur.blur(colorBuffers[1], colorBuffers[1], pingpongColorbuffers[0], SCR_WIDTH, SCR_HEIGHT, blur_radius, 0.0f, blur_fragment_path);
+            bloomTexture = colorBuffers[1];
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         /// 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         /// on screen rendering
@@ -367,9 +431,17 @@ int main()
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, colorBuffers[0]); // bind the hdr texture
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]); // use the last rendered to color buffer
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
         shaderBloomFinal.setInt("bloom", bloom);
+        // the mip chain returns the sum of its mips
+        shaderBloomFinal.setFloat("bloomStrength", bloom_mode == 1 ? 1.0f / bloom_mips : 1.0f);
         shaderBloomFinal.setFloat("exposure", exposure);
+        shaderBloomFinal.setBool("autoExposure", auto_exposure);
+        if (exposureMeter)
+        {
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, exposureMeter->getExposureTexture());
+        }
         renderQuad();
 
         //std::cout << "bloom: " << (bloom ? "on" : "off") << "\t exposure = " << exposure << std::endl;
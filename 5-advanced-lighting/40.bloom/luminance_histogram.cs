@@ -0,0 +1,38 @@
+#version 430 core
+layout (local_size_x = 16, local_size_y = 16) in;
+
+// first pass of auto_exposure.h: sorts every pixel of the hdr buffer into 256 log luminance bins
+uniform sampler2D hdrBuffer;
+uniform float minLogLuminance;
+uniform float inverseLogRange; // 1 / (maxLogLuminance - minLogLuminance)
+
+layout (std430, binding = 0) buffer Histogram
+{
+    uint histogram[256];
+};
+
+// one workgroup counts its 256 pixels here first, then adds each bin to the global histogram once
+shared uint localBins[256];
+
+uint luminanceBin(vec3 color)
+{
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    if (luminance < 1e-5)
+        return 0u; // black pixels get a bin of their own, left out of the average
+    float logLuminance = clamp((log2(luminance) - minLogLuminance) * inverseLogRange, 0.0, 1.0);
+    return uint(logLuminance * 254.0 + 1.0);
+}
+
+void main()
+{
+    localBins[gl_LocalInvocationIndex] = 0u;
+    barrier();
+
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (all(lessThan(pixel, textureSize(hdrBuffer, 0))))
+        atomicAdd(localBins[luminanceBin(texelFetch(hdrBuffer, pixel, 0).rgb)], 1u);
+    barrier();
+
+    if (localBins[gl_LocalInvocationIndex] > 0u)
+        atomicAdd(histogram[gl_LocalInvocationIndex], localBins[gl_LocalInvocationIndex]);
+}
@@ -9,8 +9,16 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <learnopengl/bloom_mips.h>
+#include <learnopengl/separable_blur.h>
+#include <learnopengl/auto_exposure.h>
+#include <learnopengl/post_process.h>
+#include <learnopengl/render_graph.h>
+
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -19,6 +27,11 @@ void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+void renderScene(Shader& shader, Shader& shaderLight, const glm::mat4& projection, const glm::mat4& view, unsigned int woodTexture, unsigned int containerTexture,
+                 const std::vector<glm::vec3>& lightPositions, const std::vector<glm::vec3>& lightColors);
+RenderGraph::Resource addPingPongBlurPasses(RenderGraph& graph, Shader& shaderBlur, RenderGraph::Resource brightColor, unsigned int amount);
+unsigned int createHDRTexture(unsigned int width, unsigned int height);
+unsigned int createColorGradingLUT(unsigned int size);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -26,6 +39,38 @@ const unsigned int SCR_HEIGHT = 600;
 bool bloom = true;
 bool bloomKeyPressed = false;
 float exposure = 1.0f;
+// x switches between the keyed exposure and one adapted to a histogram of the hdr color (see auto_exposure.h)
+bool autoExposure = true;
+bool autoExposureKeyPressed = false;
+
+// post-processing after the bloom (see post_process.h): g toggles the color grading, v the vignette, k cycles the
+// kernel effects of the framebuffers chapter and p switches between the fused chain and one pass per effect
+bool colorGrading = true;
+bool vignette = true;
+int kernelEffect = 0; // 0 is off, then sharpen, blur and edge detection
+const char* kernelEffectNames[] = { "off", "sharpen", "blur", "edge detection" };
+bool fusedPostProcess = true;
+bool colorGradingKeyPressed = false, vignetteKeyPressed = false, kernelEffectKeyPressed = false, fusedPostProcessKeyPressed = false;
+
+// m cycles between blurring the bright pixels with the ping-pong gaussian, the mip chain (see bloom_mips.h) and one
+// wide separable gaussian (see separable_blur.h)
+enum BloomMode
+{
+    BLOOM_PINGPONG,
+    BLOOM_MIP_CHAIN,
+    BLOOM_SEPARABLE
+};
+const char* bloomModeNames[] = { "ping-pong gaussian", "mip chain", "separable gaussian" };
+BloomMode bloomMode = BLOOM_MIP_CHAIN;
+bool bloomModeKeyPressed = false;
+unsigned int bloomMips = 6;
+float bloomThreshold = 1.0f;
+float bloomKnee = 0.5f;
+float bloomFilterRadius = 1.0f;
+// about as wide as the 10 ping-pong passes; f forces the fragment fallback of the compute blur
+unsigned int bloomBlurRadius = 12;
+bool blurFragmentPath = false;
+bool blurFragmentPathKeyPressed = false;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
@@ -37,17 +82,25 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char** argv)
 {
+    // "benchmark" times the bloom modes at 1080p and 4K and exits
+    const bool benchmark = argc > 1 && std::strcmp(argv[1], "benchmark") == 0;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // compute shaders for the separable blur and the auto exposure; macOS stops at 4.1, where the blur takes its
+    // fragment fallback and only the keyed exposure is left
 #ifdef __APPLE__
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 #endif
 
     // glfw window creation
@@ -83,74 +136,20 @@ int main()
     Shader shader{"bloom.vs", "bloom.fs"};
     Shader shaderLight{"bloom.vs", "light_box.fs"}; // for light sources
     Shader shaderBlur{"blur.vs", "blur.fs"};
-    Shader shaderBloomFinal {"bloom_final.vs", "bloom_final.fs"};
+    PostProcess postProcess("bloom_mip.vs", "post_process.fs");
 
     // load textures
     unsigned int woodTexture = loadTexture("../../resources/textures/wood.png", true);
     unsigned int containerTexture = loadTexture("../../resources/textures/container2.png", true);
 
-    // floating point framebuffer
-    unsigned int hdrFBO;
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    
-    // create 2 floating point color buffers (texture attachments). one for hdr color and other for brightness values
-    unsigned int colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-
-    for(int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-
-    // create and attach depth buffer (renderbuffer)
-    // we only need one depth buffer, since the two textures are for the same scene
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-    // use both color buffers for rendering
-    unsigned int attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
-    glDrawBuffers(2, attachments);
-
-    // check framebuffer status
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "hdrFBO not complete\n";
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // ping-pong framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-
-    for(int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-    
-        // also check if framebuffers are complete (no need for depth buffer)
-        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "pingpongFBO[" << std::to_string(i) << "] is not complete\n";
-    }
+    // the scene, bloom and post-processing targets are transient textures of the frame's render graph
+    BloomMips bloomMipChain("bloom_mip.vs", "bloom_downsample.fs", "bloom_upsample.fs", SCR_WIDTH, SCR_HEIGHT);
+    SeparableBlur separableBlur("blur.cs", "bloom_mip.vs", "blur_linear.fs");
+    std::unique_ptr<AutoExposure> exposureMeter;
+    if (GLAD_GL_VERSION_4_3)
+        exposureMeter.reset(new AutoExposure("luminance_histogram.cs", "luminance_average.cs"));
+    else
+        autoExposure = false;
 
     // lighting info
 
@@ -172,9 +171,244 @@ int main()
     shader.setInt("diffuseTexture", 0);
     shaderBlur.use();
     shaderBlur.setInt("image", 0);
-    shaderBloomFinal.use();
-    shaderBloomFinal.setInt("scene", 0);
-    shaderBloomFinal.setInt("bloomBlur", 1);
+    postProcess.colorGradingLUT = createColorGradingLUT(16);
+    if (exposureMeter)
+        postProcess.exposureTexture = exposureMeter->getExposureTexture();
+
+    // the frame as passes of a render graph (see render_graph.h), declared anew every frame at width x height. The
+    // passes run after this returns, so they capture its locals by value. Passes nothing reads are culled: with the
+    // bloom off nothing reads the blur, and the bright pixels are only written when the blur reads them at all
+    RenderGraph frameGraph;
+    auto addFramePasses = [&](RenderGraph& graph, unsigned int width, unsigned int height, BloomMips& mipChain) {
+        RenderGraph::Resource hdrColor = graph.createTexture("hdr color", RenderGraphTexture(width, height, GL_RGBA16F));
+        RenderGraph::Resource brightColor = graph.createTexture("bright color", RenderGraphTexture(width, height, GL_RGBA16F));
+        RenderGraph::Resource sceneDepth = graph.createTexture("scene depth", RenderGraphTexture(width, height, GL_DEPTH_COMPONENT24));
+
+        /// 1. render scene to our hdr and brightness textures
+        const glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
+        const glm::mat4 view = camera.GetViewMatrix();
+        const bool brightPixels = bloomMode != BLOOM_MIP_CHAIN; // the mip chain thresholds the hdr color itself
+        graph.addPass("scene", PASS_RASTER, [&, projection, view]() {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderScene(shader, shaderLight, projection, view, woodTexture, containerTexture, lightPositions, lightColors);
+        }).write(hdrColor).write(brightPixels ? brightColor : RenderGraph::NONE).write(sceneDepth);
+
+        // measure the scene and adapt the exposure to it, it stays on the GPU for the tonemapping below. The meter
+        // orders its own compute passes and its histogram buffer isn't a graph resource, so it's a side effect
+        if (autoExposure)
+        {
+            graph.addPass("auto exposure", PASS_COMPUTE, [&, hdrColor, width, height]() {
+                exposureMeter->update(graph.getTexture(hdrColor), width, height, deltaTime);
+            }).read(hdrColor).sideEffect();
+        }
+
+        // 2. blur bright fragments: two-pass Gaussian blur through ping-pong textures, the mip chain from the hdr color
+        // or one separable gaussian pair in place on the bright pixels
+        RenderGraph::Resource bloomTexture = brightColor;
+        if (bloomMode == BLOOM_PINGPONG)
+            bloomTexture = addPingPongBlurPasses(graph, shaderBlur, brightColor, 10);
+        else if (bloomMode == BLOOM_MIP_CHAIN)
+            bloomTexture = mipChain.addPasses(graph, hdrColor, bloomMips, bloomThreshold, bloomKnee, bloomFilterRadius);
+        else
+            separableBlur.addPasses(graph, brightColor, brightColor, bloomBlurRadius, 0.0f, blurFragmentPath);
+
+        /// 3. now add the bloom, tonemap HDR colors to default framebuffer's (clamped) color range and finish the image,
+        /// in as few passes as the enabled effects allow
+        postProcess.enabled[POST_BLOOM] = bloom;
+        postProcess.enabled[POST_COLOR_GRADING] = colorGrading;
+        postProcess.enabled[POST_KERNEL] = kernelEffect > 0;
+        postProcess.enabled[POST_VIGNETTE] = vignette;
+        postProcess.enabled[POST_DITHER] = true;
+        postProcess.kernelMode = std::max(kernelEffect - 1, 0);
+        postProcess.fused = fusedPostProcess;
+        // the mip chain returns the sum of its mips
+        postProcess.bloomStrength = bloomMode == BLOOM_MIP_CHAIN ? 1.0f / bloomMips : 1.0f;
+        postProcess.exposure = exposure;
+        postProcess.autoExposure = autoExposure;
+        postProcess.addPasses(graph, hdrColor, bloom ? bloomTexture : RenderGraph::NONE);
+    };
+
+    if (benchmark)
+    {
+        // gpu time of the bloom alone (not the scene or the final pass) at 1080p and 4K: the ping-pong gaussian against
+        // mip chains of different depth and the separable gaussian's fragment and compute paths at different radii, the
+        // auto exposure's histogram and average, and the post-processing chains fused against one pass per effect.
+        // The bloom runs as render graphs on the scene rendered once; last the render target memory of whole frames
+        // per bloom mode, against every target having a texture of its own as before the render graph
+        // ---------------------------------------------------------------------------------------------------------------
+        const unsigned int resolutions[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+        const unsigned int mipCounts[3] = { 4, 6, 8 };
+        const unsigned int blurRadii[3] = { 4, 12, 32 };
+        const int frames = 5;
+        unsigned int timeQuery;
+        glGenQueries(1, &timeQuery);
+        auto gpuMilliseconds = [&](auto&& bloomPass) {
+            glFinish();
+            glBeginQuery(GL_TIME_ELAPSED, timeQuery);
+            for (int frame = 0; frame < frames; frame++)
+            {
+                bloomPass();
+                glFlush(); // software rasterizers otherwise defer drawing into an unchanged target past the query
+            }
+            glEndQuery(GL_TIME_ELAPSED);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(timeQuery, GL_QUERY_RESULT, &nanoseconds);
+            return nanoseconds / 1.0e6 / frames;
+        };
+        std::cout << "resolution  bloom  gpu ms" << std::endl;
+        for (const unsigned int* resolution : resolutions)
+        {
+            const unsigned int width = resolution[0], height = resolution[1];
+            BloomMips benchmarkMipChain("bloom_mip.vs", "bloom_downsample.fs", "bloom_upsample.fs", width, height);
+            RenderGraph benchmarkGraph;
+            const std::string label = std::to_string(width) + "x" + std::to_string(height) + "  ";
+
+            // the scene once into textures of its own, every bloom graph imports them and returns its exported result
+            const unsigned int sceneColor = createHDRTexture(width, height), sceneBright = createHDRTexture(width, height);
+            const RenderGraphTexture hdrDescription(width, height, GL_RGBA16F);
+            auto runBloomGraph = [&](auto&& addBloomPasses) {
+                benchmarkGraph.reset();
+                RenderGraph::Resource hdrColor = benchmarkGraph.importTexture("hdr color", sceneColor, hdrDescription);
+                RenderGraph::Resource brightColor = benchmarkGraph.importTexture("bright color", sceneBright, hdrDescription);
+                RenderGraph::Resource result = addBloomPasses(hdrColor, brightColor);
+                benchmarkGraph.exportTexture(result);
+                benchmarkGraph.execute();
+                return benchmarkGraph.getTexture(result);
+            };
+            runBloomGraph([&](RenderGraph::Resource hdrColor, RenderGraph::Resource brightColor) {
+                RenderGraph::Resource sceneDepth = benchmarkGraph.createTexture("scene depth", RenderGraphTexture(width, height, GL_DEPTH_COMPONENT24));
+                glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
+                benchmarkGraph.addPass("scene", PASS_RASTER, [&, projection]() {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    renderScene(shader, shaderLight, projection, camera.GetViewMatrix(), woodTexture, containerTexture, lightPositions, lightColors);
+                }).write(hdrColor).write(brightColor).write(sceneDepth);
+                return hdrColor;
+            });
+
+            double ms = gpuMilliseconds([&]() {
+                runBloomGraph([&](RenderGraph::Resource, RenderGraph::Resource brightColor) { return addPingPongBlurPasses(benchmarkGraph, shaderBlur, brightColor, 10); });
+            });
+            std::cout << label << bloomModeNames[BLOOM_PINGPONG] << " (10 passes)  " << ms << std::endl;
+            for (unsigned int mipCount : mipCounts)
+            {
+                ms = gpuMilliseconds([&]() {
+                    runBloomGraph([&](RenderGraph::Resource hdrColor, RenderGraph::Resource) {
+                        return benchmarkMipChain.addPasses(benchmarkGraph, hdrColor, mipCount, bloomThreshold, bloomKnee, bloomFilterRadius);
+                    });
+                });
+                std::cout << label << bloomModeNames[BLOOM_MIP_CHAIN] << " (" << std::min(mipCount, benchmarkMipChain.getMipCount()) << " mips)  " << ms << std::endl;
+            }
+            // the bright pixels into a texture of their own, so every frame blurs the same input
+            auto separableBlurGraph = [&](unsigned int radius, bool fragmentPath) {
+                return runBloomGraph([&](RenderGraph::Resource, RenderGraph::Resource brightColor) {
+                    RenderGraph::Resource blurred = benchmarkGraph.createTexture("blurred", hdrDescription);
+                    separableBlur.addPasses(benchmarkGraph, brightColor, blurred, radius, 0.0f, fragmentPath);
+                    return blurred;
+                });
+            };
+            for (unsigned int radius : blurRadii)
+            {
+                for (int compute = 0; compute < (separableBlur.hasCompute() ? 2 : 1); compute++)
+                {
+                    ms = gpuMilliseconds([&]() { separableBlurGraph(radius, compute == 0); });
+                    std::cout << label << bloomModeNames[BLOOM_SEPARABLE] << " (radius " << radius << ", " << (compute ? "compute" : "fragment") << ")  " << ms << std::endl;
+                }
+            }
+            if (separableBlur.hasCompute())
+            {
+                // in place on the first (half resolution, R11F_G11F_B10F) mip of the chain, with the chain itself
+                ms = gpuMilliseconds([&]() {
+                    runBloomGraph([&](RenderGraph::Resource hdrColor, RenderGraph::Resource) {
+                        RenderGraph::Resource firstMip = benchmarkMipChain.addPasses(benchmarkGraph, hdrColor, 6, bloomThreshold, bloomKnee, bloomFilterRadius);
+                        separableBlur.addPasses(benchmarkGraph, firstMip, firstMip, 12);
+                        return firstMip;
+                    });
+                });
+                std::cout << label << bloomModeNames[BLOOM_MIP_CHAIN] << " (6 mips) + " << bloomModeNames[BLOOM_SEPARABLE] << " (radius 12, compute, in place on mip 0)  " << ms << std::endl;
+
+                // both paths compute the same kernel, the folded bilinear taps only differ by the filtering precision.
+                // the graph orders its own passes, the readback of a compute result needs its barrier from us
+                std::vector<float> fragmentResult(width * height * 4), computeResult(width * height * 4);
+                glBindTexture(GL_TEXTURE_2D, separableBlurGraph(12, true));
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, fragmentResult.data());
+                unsigned int computeTexture = separableBlurGraph(12, false);
+                glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+                glBindTexture(GL_TEXTURE_2D, computeTexture);
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, computeResult.data());
+                float maxDifference = 0.0f, maxValue = 0.0f;
+                for (size_t i = 0; i < computeResult.size(); i++)
+                {
+                    if (i % 4 == 3)
+                        continue;
+                    maxDifference = std::max(maxDifference, std::abs(computeResult[i] - fragmentResult[i]));
+                    maxValue = std::max(maxValue, computeResult[i]);
+                }
+                std::cout << label << "fragment vs compute (radius 12): max difference " << maxDifference << " of max value " << maxValue << std::endl;
+            }
+            if (exposureMeter)
+            {
+                ms = gpuMilliseconds([&]() { exposureMeter->update(sceneColor, width, height, 1.0f / 60.0f); });
+                std::cout << label << "auto exposure  " << ms << std::endl;
+            }
+
+            // the post-processing reads the hdr color and the 6 mip bloom and writes an 8 bit target of the same size
+            unsigned int postTexture, postFBO;
+            glGenTextures(1, &postTexture);
+            glBindTexture(GL_TEXTURE_2D, postTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glGenFramebuffers(1, &postFBO);
+            glBindFramebuffer(GL_FRAMEBUFFER, postFBO);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, postTexture, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            unsigned int bloomTexture = runBloomGraph([&](RenderGraph::Resource hdrColor, RenderGraph::Resource) {
+                return benchmarkMipChain.addPasses(benchmarkGraph, hdrColor, 6, bloomThreshold, bloomKnee, bloomFilterRadius);
+            });
+            postProcess.bloomStrength = 1.0f / 6.0f;
+            const char* chainNames[3] = { "bloom + tonemap + gamma", "typical (+ grading, vignette, dither)", "typical + sharpen" };
+            for (int chain = 0; chain < 3; chain++)
+            {
+                for (int effect = 0; effect < POST_EFFECT_COUNT; effect++)
+                    postProcess.enabled[effect] = effect == POST_BLOOM || effect == POST_TONEMAP || effect == POST_GAMMA || (chain > 0 && effect != POST_KERNEL) || chain == 2;
+                for (int fused = 1; fused >= 0; fused--)
+                {
+                    postProcess.fused = fused == 1;
+                    postProcess.render(sceneColor, bloomTexture, width, height, postFBO); // compiles the passes
+                    ms = gpuMilliseconds([&]() { postProcess.render(sceneColor, bloomTexture, width, height, postFBO); });
+                    std::cout << label << "post " << chainNames[chain] << ", " << (fused ? "fused" : "one pass per effect") << ": " << postProcess.planPasses().size()
+                              << " passes, " << postProcess.estimateTraffic(sceneColor, bloomTexture, width, height) / 1.0e6 << " MB  " << ms << std::endl;
+                }
+            }
+            glDeleteFramebuffers(1, &postFBO);
+            glDeleteTextures(1, &postTexture);
+
+            // render targets of a whole frame with the typical post-processing. before the render graph every target had
+            // a texture of its own for the whole run: the hdr framebuffer's color, bright pixels and depth, both
+            // ping-pong buffers, the whole mip chain and, once the kernel was used, the post-processing's two intermediates
+            unsigned long long separateBytes = 4 * hdrDescription.bytes() + RenderGraphTexture(width, height, GL_DEPTH_COMPONENT24).bytes();
+            for (unsigned int mipWidth = width / 2, mipHeight = height / 2, i = 0; i < BloomMips::MAX_MIPS && mipWidth > 0 && mipHeight > 0; mipWidth /= 2, mipHeight /= 2, i++)
+                separateBytes += RenderGraphTexture(mipWidth, mipHeight, GL_R11F_G11F_B10F).bytes();
+            const BloomMode benchmarkModes[4] = { BLOOM_PINGPONG, BLOOM_MIP_CHAIN, BLOOM_SEPARABLE, BLOOM_MIP_CHAIN };
+            fusedPostProcess = true;
+            for (int row = 0; row < 4; row++)
+            {
+                bloomMode = benchmarkModes[row];
+                kernelEffect = row == 3 ? 1 : 0;
+                benchmarkGraph.reset();
+                addFramePasses(benchmarkGraph, width, height, benchmarkMipChain);
+                benchmarkGraph.compile();
+                std::cout << label << "render targets, " << bloomModeNames[bloomMode] << (kernelEffect ? " + sharpen" : "") << ": separate "
+                          << (separateBytes + (kernelEffect ? 2 * hdrDescription.bytes() : 0)) / 1.0e6 << " MB, graph " << benchmarkGraph.getTextureBytes() / 1.0e6
+                          << " MB (" << benchmarkGraph.getUnaliasedTextureBytes() / 1.0e6 << " MB without aliasing), " << benchmarkGraph.getPassCount() - benchmarkGraph.getCulledPassCount()
+                          << " of " << benchmarkGraph.getPassCount() << " passes" << std::endl;
+            }
+
+            glDeleteTextures(1, &sceneColor);
+            glDeleteTextures(1, &sceneBright);
+        }
+        glDeleteQueries(1, &timeQuery);
+        glfwTerminate();
+        return 0;
+    }
 
     // render loop
     while(!glfwWindowShouldClose(window)) {
@@ -187,131 +421,194 @@ int main()
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        /// 1. render scene to our hdr and brightness textures
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 model = glm::mat4(1.0f);
-
-        shader.use();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        
-        // set lighting uniforms
-        for(unsigned int i = 0; i < lightPositions.size(); i++) {
-            shader.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shader.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-        }
-
-        shader.setVec3("viewPos", camera.Position);
+        // the scene, its bloom and the post-processing, see addFramePasses
+        frameGraph.reset();
+        addFramePasses(frameGraph, SCR_WIDTH, SCR_HEIGHT, bloomMipChain);
+        frameGraph.execute();
+
+        std::cout << "bloom: " << (bloom ? bloomModeNames[bloomMode] : "off");
+        if (bloom && bloomMode == BLOOM_SEPARABLE)
+            std::cout << (blurFragmentPath || !separableBlur.hasCompute() ? " (fragment)" : " (compute)");
+        std::cout << "\t exposure = ";
+        if (autoExposure)
+            std::cout << "auto" << std::endl;
+        else
+            std::cout << exposure << std::endl;
+        std::cout << "post: grading " << (colorGrading ? "on" : "off") << ", vignette " << (vignette ? "on" : "off") << ", kernel "
+                  << kernelEffectNames[kernelEffect] << ", " << postProcess.planPasses().size() << (fusedPostProcess ? " fused" : " separate") << " passes" << std::endl;
+        std::cout << "render targets: " << frameGraph.getTextureBytes() / 1.0e6 << " MB (" << frameGraph.getUnaliasedTextureBytes() / 1.0e6 << " MB without aliasing), "
+                  << frameGraph.getPassCount() - frameGraph.getCulledPassCount() << " of " << frameGraph.getPassCount() << " passes" << std::endl;
 
-        // render the scene
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
 
-        // create one large cube that acts as the floor
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0));
-        model = glm::scale(model, glm::vec3(12.5f, 0.5f, 12.5f));
-        shader.setMat4("model", model);
-        renderCube();
-        // then create multiple cubes as the scenery
-        glBindTexture(GL_TEXTURE_2D, containerTexture);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
-        renderCube();
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
-        renderCube();
+    glfwTerminate();
+    return 0;
+}
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 2.0));
-        model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader.setMat4("model", model);
-        renderCube();
+// an hdr color texture the benchmark renders the scene into once, for the bloom passes to import
+// ----------------------------------------------------------------------------------------------
+unsigned int createHDRTexture(unsigned int width, unsigned int height)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 2.7f, 4.0));
-        model = glm::rotate(model, glm::radians(23.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        model = glm::scale(model, glm::vec3(1.25));
-        shader.setMat4("model", model);
-        renderCube();
+// renders the floor, the containers and the light cubes into the bound hdr framebuffer
+// -------------------------------------------------------------------------------------
+void renderScene(Shader& shader, Shader& shaderLight, const glm::mat4& projection, const glm::mat4& view, unsigned int woodTexture, unsigned int containerTexture,
+                 const std::vector<glm::vec3>& lightPositions, const std::vector<glm::vec3>& lightColors)
+{
+    glm::mat4 model = glm::mat4(1.0f);
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-2.0f, 1.0f, -3.0));
-        model = glm::rotate(model, glm::radians(124.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader.setMat4("model", model);
-        renderCube();
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, woodTexture);
+    
+    // set lighting uniforms
+    for(unsigned int i = 0; i < lightPositions.size(); i++) {
+        shader.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
+        shader.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+    }
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-3.0f, 0.0f, 0.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
+    shader.setVec3("viewPos", camera.Position);
+
+    // render the scene
+
+    // create one large cube that acts as the floor
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0));
+    model = glm::scale(model, glm::vec3(12.5f, 0.5f, 12.5f));
+    shader.setMat4("model", model);
+    renderCube();
+    // then create multiple cubes as the scenery
+    glBindTexture(GL_TEXTURE_2D, containerTexture);
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
+    model = glm::scale(model, glm::vec3(0.5f));
+    shader.setMat4("model", model);
+    renderCube();
+
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
+    model = glm::scale(model, glm::vec3(0.5f));
+    shader.setMat4("model", model);
+    renderCube();
+
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 2.0));
+    model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+    shader.setMat4("model", model);
+    renderCube();
+
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, 2.7f, 4.0));
+    model = glm::rotate(model, glm::radians(23.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+    model = glm::scale(model, glm::vec3(1.25));
+    shader.setMat4("model", model);
+    renderCube();
+
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(-2.0f, 1.0f, -3.0));
+    model = glm::rotate(model, glm::radians(124.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+    shader.setMat4("model", model);
+    renderCube();
+
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(-3.0f, 0.0f, 0.0));
+    model = glm::scale(model, glm::vec3(0.5f));
+    shader.setMat4("model", model);
+    renderCube();
+
+    // finally show all the light sources as bright cubes
+    // not the light sources are also being rendered to the currently bound framebuffer - i.e hdrFBO
+    shaderLight.use();
+    shaderLight.setMat4("projection", projection);
+    shaderLight.setMat4("view", view);
+
+    for(unsigned int i = 0; i < lightPositions.size(); i++) {
+        model = glm::mat4(1.0);
+        model = glm::translate(model, glm::vec3(lightPositions[i]));
+        model = glm::scale(model, glm::vec3(0.25));
+
+        shaderLight.setMat4("model", model);
+        shaderLight.setVec3("lightColor", lightColors[i]);
         renderCube();
+    }
+}
 
-        // finally show all the light sources as bright cubes
-        // not the light sources are also being rendered to the currently bound framebuffer - i.e hdrFBO
-        shaderLight.use();
-        shaderLight.setMat4("projection", projection);
-        shaderLight.setMat4("view", view);
-
-        for(unsigned int i = 0; i < lightPositions.size(); i++) {
-            model = glm::mat4(1.0);
-            model = glm::translate(model, glm::vec3(lightPositions[i]));
-            model = glm::scale(model, glm::vec3(0.25));
-
-            shaderLight.setMat4("model", model);
-            shaderLight.setVec3("lightColor", lightColors[i]);
-            renderCube();
-        }
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2. blur bright fragments two-pass Gaussian blur, render to pingpongFBO
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 10;
-        shaderBlur.use();
-        for (unsigned int i = 0; i < amount; i++)
-        {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
+// blurs the bright pixels with amount alternating horizontal and vertical gaussian passes and returns the result.
+// every pass writes a texture of its own; the graph sees that each is only read by the next pass and runs the whole
+// blur on two textures, the first of them the bright pixels' own once the first pass has read them
+// ----------------------------------------------------------------------------------------------------------------
+RenderGraph::Resource addPingPongBlurPasses(RenderGraph& graph, Shader& shaderBlur, RenderGraph::Resource brightColor, unsigned int amount)
+{
+    const RenderGraphTexture description = graph.getDescription(brightColor);
+    RenderGraph::Resource source = brightColor;
+    for (unsigned int i = 0; i < amount; i++)
+    {
+        const bool horizontal = i % 2 == 0;
+        RenderGraph::Resource blurred = graph.createTexture("ping-pong blur " + std::to_string(i), description);
+        graph.addPass("ping-pong blur " + std::to_string(i), PASS_RASTER, [&graph, &shaderBlur, source, horizontal]() {
+            shaderBlur.use();
             shaderBlur.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, graph.getTexture(source));
             renderQuad(); // note: renderQuad specifies texCoords in range [0.0, 1.0], which is the range of texture coordinates
                           // so we always sample from inside our texture in the fragment shader using the texture coordinates
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        /// 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-        /// on screen rendering
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderBloomFinal.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]); // bind the hdr texture
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]); // use the last rendered to color buffer
-        shaderBloomFinal.setInt("bloom", bloom);
-        shaderBloomFinal.setFloat("exposure", exposure);
-        renderQuad();
-
-        std::cout << "bloom: " << (bloom ? "on" : "off") << "\t exposure = " << exposure << std::endl;
-        
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        }).read(source).write(blurred);
+        source = blurred;
     }
+    return source;
+}
 
+// a size^3 color grading LUT: a little more contrast and saturation and a slightly warmer white balance. It's
+// addressed by gamma encoded color and holds linear color, as half floats: 8 bits of linear color would turn the
+// darkest steps into visible bands once gamma corrected
+// ------------------------------------------------------------------------------------------------------------------
+unsigned int createColorGradingLUT(unsigned int size)
+{
+    std::vector<float> texels(size * size * size * 3);
+    for (unsigned int b = 0; b < size; b++)
+    {
+        for (unsigned int g = 0; g < size; g++)
+        {
+            for (unsigned int r = 0; r < size; r++)
+            {
+                glm::vec3 encoded = glm::vec3(r, g, b) / (float)(size - 1);
+                const float luminance = glm::dot(encoded, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+                encoded = glm::mix(glm::vec3(luminance), encoded, 1.15f);                    // saturation
+                encoded = encoded * encoded * (3.0f - 2.0f * encoded) * 0.3f + encoded * 0.7f; // s-curve contrast
+                encoded = glm::clamp(encoded * glm::vec3(1.04f, 1.0f, 0.94f), 0.0f, 1.0f);  // warmer
+                glm::vec3 color = glm::pow(encoded, glm::vec3(2.2f));
+                for (int channel = 0; channel < 3; channel++)
+                    texels[((b * size + g) * size + r) * 3 + channel] = color[channel];
+            }
+        }
+    }
 
-    glfwTerminate();
-    return 0;
+    unsigned int lut;
+    glGenTextures(1, &lut);
+    glBindTexture(GL_TEXTURE_3D, lut);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, size, size, size, 0, GL_RGB, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return lut;
 }
 
 // renderCube() renders a 1x1 3D cube in NDC.
@@ -446,6 +743,76 @@ void processInput(GLFWwindow *window)
         bloomKeyPressed = false;
     }
 
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !bloomModeKeyPressed)
+    {
+        bloomMode = (BloomMode)((bloomMode + 1) % 3);
+        bloomModeKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+    {
+        bloomModeKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !blurFragmentPathKeyPressed)
+    {
+        blurFragmentPath = !blurFragmentPath;
+        blurFragmentPathKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE)
+    {
+        blurFragmentPathKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS && !autoExposureKeyPressed)
+    {
+        autoExposure = !autoExposure && GLAD_GL_VERSION_4_3;
+        autoExposureKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_RELEASE)
+    {
+        autoExposureKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !colorGradingKeyPressed)
+    {
+        colorGrading = !colorGrading;
+        colorGradingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+    {
+        colorGradingKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS && !vignetteKeyPressed)
+    {
+        vignette = !vignette;
+        vignetteKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_RELEASE)
+    {
+        vignetteKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && !kernelEffectKeyPressed)
+    {
+        kernelEffect = (kernelEffect + 1) % 4;
+        kernelEffectKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE)
+    {
+        kernelEffectKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !fusedPostProcessKeyPressed)
+    {
+        fusedPostProcess = !fusedPostProcess;
+        fusedPostProcessKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+    {
+        fusedPostProcessKeyPressed = false;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
     {
         if (exposure > 0.0f)
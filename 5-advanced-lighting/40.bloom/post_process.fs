@@ -0,0 +1,83 @@
+#version 330 core
+// post_process.h inserts one #define per effect of the pass here; the effects always run in this order
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;     // the hdr scene for the first pass, the previous pass after that; as large as the target
+uniform sampler2D bloomBlur;
+uniform float bloomStrength;  // 1 for the gaussian blurs, 1 / mips for the mip chain
+uniform float exposure;
+uniform bool autoExposure;         // measured on the GPU (see auto_exposure.h) instead of keyed in
+uniform sampler2D exposureTexture; // 1x1: exposure, adapted luminance
+uniform sampler3D colorGradingLUT; // addressed by gamma encoded color, holds linear color
+uniform int kernelMode;       // 0: sharpen, 1: blur, 2: edge detection
+uniform float vignetteStrength;
+
+// the 3x3 kernels of the framebuffers chapter, on neighbouring texels of source
+vec3 applyKernel(ivec2 pixel)
+{
+    float kernels[27] = float[](
+        -1.0, -1.0, -1.0,  -1.0, 9.0, -1.0,  -1.0, -1.0, -1.0,                      // sharpen
+        1.0 / 16.0, 2.0 / 16.0, 1.0 / 16.0,  2.0 / 16.0, 4.0 / 16.0, 2.0 / 16.0,
+        1.0 / 16.0, 2.0 / 16.0, 1.0 / 16.0,                                           // blur
+        1.0, 1.0, 1.0,  1.0, -8.0, 1.0,  1.0, 1.0, 1.0);                              // edge detection
+    ivec2 maxPixel = textureSize(source, 0) - 1;
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < 9; ++i)
+    {
+        ivec2 offset = ivec2(i % 3 - 1, 1 - i / 3);
+        result += texelFetch(source, clamp(pixel + offset, ivec2(0), maxPixel), 0).rgb * kernels[kernelMode * 9 + i];
+    }
+    return result;
+}
+
+// interleaved gradient noise (Jimenez 2014)
+float interleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    // source is as large as the target, so every pixel fetches exactly its own texel instead of filtering
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+#ifdef POST_KERNEL
+    vec3 color = applyKernel(pixel); // only ever the first effect of its pass, it reads its neighbours from source
+#else
+    vec3 color = texelFetch(source, pixel, 0).rgb;
+#endif
+
+#ifdef POST_BLOOM
+    color += texture(bloomBlur, TexCoords).rgb * bloomStrength;
+#endif
+
+#ifdef POST_TONEMAP
+    float sceneExposure = autoExposure ? texelFetch(exposureTexture, ivec2(0), 0).r : exposure;
+    color = vec3(1.0) - exp(-color * sceneExposure);
+#endif
+
+#ifdef POST_COLOR_GRADING
+    // gamma encoded coordinates spend more of the few texels on the darks; half a texel inset so 0 and 1 land on the
+    // first and last texel centers
+    float lutSize = float(textureSize(colorGradingLUT, 0).x);
+    vec3 encoded = pow(clamp(color, 0.0, 1.0), vec3(1.0 / 2.2));
+    color = texture(colorGradingLUT, encoded * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize).rgb;
+#endif
+
+#ifdef POST_VIGNETTE
+    vec2 fromCenter = TexCoords - 0.5;
+    color *= 1.0 - vignetteStrength * smoothstep(0.2, 0.8, dot(fromCenter, fromCenter) * 2.0);
+#endif
+
+#ifdef POST_GAMMA
+    color = pow(max(color, vec3(0.0)), vec3(1.0 / 2.2));
+#endif
+
+#ifdef POST_DITHER
+    // about one 8 bit step of noise breaks up the banding of smooth gradients (vignette, bloom halos)
+    color += (interleavedGradientNoise(gl_FragCoord.xy) - 0.5) / 255.0;
+#endif
+
+    FragColor = vec4(color, 1.0);
+}
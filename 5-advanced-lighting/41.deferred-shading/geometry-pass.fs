@@ -11,14 +11,27 @@ in vec3 Normal;
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
 
+// compact layout (see gbuffer.h): no position target, the normal goes octahedral encoded into a RG16 target
+uniform bool compactGBuffer;
+
+// folds the unit normal onto the octahedron |x| + |y| + |z| = 1 and unfolds its lower half over the corners
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e * 0.5 + 0.5;
+}
+
 // note all variables must be in the same coordinate space
 // here we use the world coordinate space
 void main() {
     gPosition = FragPos; // world space fragment position
 
     gNormal = normalize(Normal);
+    if (compactGBuffer)
+        gNormal = vec3(encodeNormal(gNormal), 0.0);
 
     gAlbedoSpec.rgb = texture(texture_diffuse1, TexCoords).rgb; // store diffuse per-fragment color
     gAlbedoSpec.a = texture(texture_specular1, TexCoords).r; // store the specular intensity in the alpha component of `gAlbedoSpec`
                                                              // specular map has only one component
-}
\ No newline at end of file
+}
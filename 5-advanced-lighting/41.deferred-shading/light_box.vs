@@ -1,13 +1,26 @@
-#version 330 core
+#version 430 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+struct PointLight {
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    float Linear;
+    float Quadratic;
+};
+// one instance per light
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+
+out vec3 LightColor;
+
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
+uniform float boxSize;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    LightColor = lights[gl_InstanceID].Color;
+    gl_Position = projection * view * vec4(lights[gl_InstanceID].Position + aPos * boxSize, 1.0);
+}
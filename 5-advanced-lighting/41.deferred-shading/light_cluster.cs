@@ -0,0 +1,80 @@
+#version 430 core
+// one invocation per cluster: 16 x 9 tiles, 4 of the depth slices per workgroup (see light_clusters.h)
+layout (local_size_x = 16, local_size_y = 9, local_size_z = 4) in;
+
+struct PointLight {
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    float Linear;
+    float Quadratic;
+};
+
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+layout (std430, binding = 1) writeonly buffer ClusterCounts { uint clusterCounts[]; };
+layout (std430, binding = 2) writeonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+uniform mat4 view;
+uniform mat4 inverseProjection;
+uniform float zNear;
+uniform float zFar;
+uniform uint lightCount;
+uniform uint maxLightsPerCluster;
+
+const uint BATCH_SIZE = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+// view space center and radius of a batch of lights, loaded once for the whole workgroup
+shared vec4 batch[BATCH_SIZE];
+
+float sliceDepth(uint slice)
+{
+    return zNear * pow(zFar / zNear, float(slice) / float(gl_NumWorkGroups.z * gl_WorkGroupSize.z));
+}
+
+void main()
+{
+    const uvec3 tiles = gl_NumWorkGroups * gl_WorkGroupSize;
+    const uvec3 cell = gl_GlobalInvocationID;
+    const uint cluster = cell.x + cell.y * tiles.x + cell.z * tiles.x * tiles.y;
+
+    // bounds of the cluster: the tile's corner rays between the slice's near and far depth
+    vec2 tileMin = vec2(cell.xy) / vec2(tiles.xy) * 2.0 - 1.0;
+    vec2 tileMax = vec2(cell.xy + 1) / vec2(tiles.xy) * 2.0 - 1.0;
+    float depths[2] = float[2](sliceDepth(cell.z), sliceDepth(cell.z + 1));
+    vec3 boundsMin = vec3(3.402823e38);
+    vec3 boundsMax = vec3(-3.402823e38);
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        vec2 ndc = vec2((corner & 1) != 0 ? tileMax.x : tileMin.x, (corner & 2) != 0 ? tileMax.y : tileMin.y);
+        vec4 onNearPlane = inverseProjection * vec4(ndc, -1.0, 1.0);
+        vec3 point = onNearPlane.xyz / onNearPlane.w;
+        vec3 ray = point / -point.z;
+        for (int i = 0; i < 2; ++i)
+        {
+            boundsMin = min(boundsMin, ray * depths[i]);
+            boundsMax = max(boundsMax, ray * depths[i]);
+        }
+    }
+
+    uint count = 0;
+    for (uint first = 0; first < lightCount; first += BATCH_SIZE)
+    {
+        uint light = first + gl_LocalInvocationIndex;
+        if (light < lightCount)
+            batch[gl_LocalInvocationIndex] = vec4((view * vec4(lights[light].Position, 1.0)).xyz, lights[light].Radius);
+        barrier();
+
+        uint batchCount = min(BATCH_SIZE, lightCount - first);
+        for (uint i = 0; i < batchCount; ++i)
+        {
+            vec3 offset = clamp(batch[i].xyz, boundsMin, boundsMax) - batch[i].xyz;
+            if (dot(offset, offset) <= batch[i].w * batch[i].w)
+            {
+                if (count < maxLightsPerCluster)
+                    clusterLightIndices[cluster * maxLightsPerCluster + count] = first + i;
+                count++;
+            }
+        }
+        barrier();
+    }
+    clusterCounts[cluster] = count;
+}
@@ -0,0 +1,23 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+
+struct PointLight {
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    float Linear;
+    float Quadratic;
+};
+// one instance per light, the sphere scaled to its radius
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+
+flat out uint LightIndex;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+    LightIndex = gl_InstanceID;
+    gl_Position = projection * view * vec4(lights[gl_InstanceID].Position + aPos * lights[gl_InstanceID].Radius, 1.0);
+}
@@ -0,0 +1,100 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+// compact layout (see gbuffer.h): position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).rgb;
+    vec4 position = inverseViewProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+struct PointLight {
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    float Linear;
+    float Quadratic;
+};
+// the lights and the per cluster lists written by light_cluster.cs
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+layout (std430, binding = 1) readonly buffer ClusterCounts { uint clusterCounts[]; };
+layout (std430, binding = 2) readonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+// must match CLUSTER_TILES_X/Y and CLUSTER_SLICES of light_clusters.h
+const uvec3 CLUSTER_GRID = uvec3(16, 9, 24);
+
+uniform mat4 view;
+uniform vec3 viewPos;
+uniform vec2 screenSize;
+uniform float zNear;
+uniform float zFar;
+uniform uint maxLightsPerCluster;
+
+void main()
+{             
+    // retrieve data from gbuffer
+    vec3 FragPos = gBufferPosition(TexCoords);
+    vec3 Normal = gBufferNormal(TexCoords);
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    float Specular = texture(gAlbedoSpec, TexCoords).a;
+
+    // the cluster of this fragment: its screen tile and the exponential depth slice of its view depth
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / screenSize * vec2(CLUSTER_GRID.xy)), CLUSTER_GRID.xy - 1);
+    uint slice = uint(clamp(floor(log(depth / zNear) / log(zFar / zNear) * float(CLUSTER_GRID.z)), 0.0, float(CLUSTER_GRID.z - 1)));
+    uint cluster = tile.x + tile.y * CLUSTER_GRID.x + slice * CLUSTER_GRID.x * CLUSTER_GRID.y;
+    uint count = min(clusterCounts[cluster], maxLightsPerCluster);
+    
+    // then calculate lighting as usual, with the lights of the cluster only
+    vec3 lighting  = Diffuse * 0.1; // hard-coded ambient component
+    vec3 viewDir  = normalize(viewPos - FragPos);
+    for(uint j = 0; j < count; ++j)
+    {
+        uint i = clusterLightIndices[cluster * maxLightsPerCluster + j];
+        // calculate distance between light source and current fragment
+        float distance = length(lights[i].Position - FragPos);
+        // the cluster is a box around the fragment, the light may still miss it
+        if(distance < lights[i].Radius)
+        {
+            // diffuse
+            vec3 lightDir = normalize(lights[i].Position - FragPos);
+            vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * lights[i].Color;
+            // specular
+            vec3 halfwayDir = normalize(lightDir + viewDir);  
+            float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
+            vec3 specular = lights[i].Color * spec * Specular;
+            // attenuation
+            float attenuation = 1.0 / (1.0 + lights[i].Linear * distance + lights[i].Quadratic * distance * distance);
+            diffuse *= attenuation;
+            specular *= attenuation;
+            lighting += diffuse + specular;
+        }
+    }    
+    FragColor = vec4(lighting, 1.0);
+}
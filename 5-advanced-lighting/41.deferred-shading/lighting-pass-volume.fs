@@ -0,0 +1,78 @@
+#version 430 core
+out vec4 FragColor;
+
+flat in uint LightIndex;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+// compact layout (see gbuffer.h): position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).rgb;
+    vec4 position = inverseViewProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+struct PointLight {
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    float Linear;
+    float Quadratic;
+};
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+
+uniform vec3 viewPos;
+uniform vec2 screenSize;
+
+void main()
+{             
+    // retrieve data from gbuffer, at the pixel the light volume covers
+    vec2 TexCoords = gl_FragCoord.xy / screenSize;
+    vec3 FragPos = gBufferPosition(TexCoords);
+    vec3 Normal = gBufferNormal(TexCoords);
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    float Specular = texture(gAlbedoSpec, TexCoords).a;
+
+    // the depth test only rejects surfaces behind the volume, the ones in front of it still get here
+    PointLight light = lights[LightIndex];
+    float distance = length(light.Position - FragPos);
+    if(distance >= light.Radius)
+        discard;
+
+    // then calculate this light's share, blended on top of the ambient pass and the other lights
+    vec3 viewDir  = normalize(viewPos - FragPos);
+    // diffuse
+    vec3 lightDir = normalize(light.Position - FragPos);
+    vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * light.Color;
+    // specular
+    vec3 halfwayDir = normalize(lightDir + viewDir);  
+    float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
+    vec3 specular = light.Color * spec * Specular;
+    // attenuation
+    float attenuation = 1.0 / (1.0 + light.Linear * distance + light.Quadratic * distance * distance);
+    diffuse *= attenuation;
+    specular *= attenuation;
+    FragColor = vec4(diffuse + specular, 1.0);
+}
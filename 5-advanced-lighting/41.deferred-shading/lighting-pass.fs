@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 out vec4 FragColor;
 
 in vec2 TexCoords;
@@ -7,30 +7,57 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 
-struct Light {
+// compact layout (see gbuffer.h): position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).rgb;
+    vec4 position = inverseViewProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+struct PointLight {
     vec3 Position;
+    float Radius;
     vec3 Color;
-    
     float Linear;
     float Quadratic;
-    float Radius;
 };
-const int NR_LIGHTS = 32;
-uniform Light lights[NR_LIGHTS];
+// every light of the scene, see PointLight in light_clusters.h
+layout (std430, binding = 0) readonly buffer Lights { PointLight lights[]; };
+uniform uint lightCount;
 uniform vec3 viewPos;
 
 void main()
 {             
     // retrieve data from gbuffer
-    vec3 FragPos = texture(gPosition, TexCoords).rgb;
-    vec3 Normal = texture(gNormal, TexCoords).rgb;
+    vec3 FragPos = gBufferPosition(TexCoords);
+    vec3 Normal = gBufferNormal(TexCoords);
     vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
     float Specular = texture(gAlbedoSpec, TexCoords).a;
     
     // then calculate lighting as usual
     vec3 lighting  = Diffuse * 0.1; // hard-coded ambient component
     vec3 viewDir  = normalize(viewPos - FragPos);
-    for(int i = 0; i < NR_LIGHTS; ++i)
+    for(uint i = 0; i < lightCount; ++i)
     {
         // calculate distance between light source and current fragment
         float distance = length(lights[i].Position - FragPos);
@@ -38,7 +65,7 @@ void main()
         // if the condition `if` condition in one of gpu cores is true, while in all others it is
         // false, the other cores have to wait
         // https://stackoverflow.com/a/37837060/22743875
-        // alternative: tile based light culling
+        // alternative: tile based light culling (lighting-pass-clustered.fs)
         if(distance < lights[i].Radius)
         {
             // diffuse
@@ -8,8 +8,14 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/light_clusters.h>
+#include <learnopengl/gbuffer.h>
+#include <learnopengl/gpu_timer.h>
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -17,14 +23,20 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path, bool gammaCorrection);
 void renderQuad();
-void renderCube();
+void renderCube(unsigned int instanceCount = 1);
+void renderSphere(unsigned int instanceCount = 1);
+std::vector<PointLight> createLights(unsigned int count);
+void renderGeometryPass(Shader& shader, const GBuffer& gBuffer, Model& backpack, const std::vector<glm::vec3>& objectPositions, const glm::mat4& projection, const glm::mat4& view);
+void renderLightingPass(Shader& allLightsShader, Shader& clusteredShader, Shader& volumeShader, LightClusters& clusters, const GBuffer& gBuffer, const glm::mat4& projection, const glm::mat4& view);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
 
 // camera
-Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
+Camera camera(glm::vec3(0.0f, 4.0f, 16.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -15.0f);
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
@@ -33,12 +45,41 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// lighting: 1 shades every pixel with every light, 2 with the lights of its cluster only, 3 draws a sphere per
+// light that adds the light to the pixels it covers. up/down doubles/halves the number of lights.
+enum LightingMode
 {
+    LIGHTING_ALL_LIGHTS,
+    LIGHTING_CLUSTERED,
+    LIGHTING_VOLUMES
+};
+const char* lightingModeNames[] = { "all lights per pixel", "clustered", "light volumes" };
+LightingMode lightingMode = LIGHTING_CLUSTERED;
+unsigned int lightCount = 4096;
+bool lightCountChanged = true;
+bool upPressed = false, downPressed = false;
+
+// c switches between the standard and the compact g-buffer layout (see gbuffer.h)
+const char* gBufferLayoutNames[] = { "standard", "compact" };
+GBufferLayout gBufferLayout = GBUFFER_STANDARD;
+bool compactPressed = false;
+
+// lights fill the floor, attenuation steep enough that each one only reaches about a unit
+const float FLOOR_SIZE = 20.0f;
+const float LIGHT_LINEAR = 0.7f;
+const float LIGHT_QUADRATIC = 40.0f;
+
+unsigned int whiteTexture = 0;
+
+int main(int argc, char** argv)
+{
+    // "benchmark" renders a fixed number of frames per light count and mode and exits
+    const bool benchmark = argc > 1 && std::strcmp(argv[1], "benchmark") == 0;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // shader storage buffers and compute shaders
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -59,6 +100,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSwapInterval(0); // frame times are the point of the light count sweep
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -82,90 +124,151 @@ int main()
     // -------------------------
     Shader shaderGeometryPass("g_buffer.vs", "geometry-pass.fs");
     Shader shaderLightingPass("lighting.vs", "lighting-pass.fs");
+    Shader shaderClusteredLightingPass("lighting.vs", "lighting-pass-clustered.fs");
+    Shader shaderVolumeLightingPass("light_volume.vs", "lighting-pass-volume.fs");
     Shader shaderLightBox("light_box.vs", "light_box.fs");
+    // the distant froxels cover a lot of floor: with 16k lights the fullest ones hold ~830 lights, so leave room for them
+    LightClusters lightClusters("light_cluster.cs", NEAR_PLANE, FAR_PLANE, 1024);
 
     // load models
     // -----------
     Model backpack(("../../resources/objects/backpack/backpack.obj"));
     std::vector<glm::vec3> objectPositions;
-    objectPositions.push_back(glm::vec3(-3.0, -0.5, -3.0));
-    objectPositions.push_back(glm::vec3( 0.0, -0.5, -3.0));
-    objectPositions.push_back(glm::vec3( 3.0, -0.5, -3.0));
-    objectPositions.push_back(glm::vec3(-3.0, -0.5,  0.0));
-    objectPositions.push_back(glm::vec3( 0.0, -0.5,  0.0));
-    objectPositions.push_back(glm::vec3( 3.0, -0.5,  0.0));
-    objectPositions.push_back(glm::vec3(-3.0, -0.5,  3.0));
-    objectPositions.push_back(glm::vec3( 0.0, -0.5,  3.0));
-    objectPositions.push_back(glm::vec3( 3.0, -0.5,  3.0));
-
-
-    // configure g-buffer framebuffer
-    // ------------------------------
-    unsigned int gBuffer;
-    glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedoSpec;
-    // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    // color + specular color buffer
-    glGenTextures(1, &gAlbedoSpec);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    for (int x = -2; x <= 2; x++)
+    {
+        for (int z = -2; z <= 2; z++)
+            objectPositions.push_back(glm::vec3(x * 6.0f, -0.5f, z * 6.0f));
+    }
+
+    // plain white albedo and specular for the floor
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &whiteTexture);
+    glBindTexture(GL_TEXTURE_2D, whiteTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedoSpec, 0);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // lighting info
-    // -------------
-    const unsigned int NR_LIGHTS = 32;
-    std::vector<glm::vec3> lightPositions;
-    std::vector<glm::vec3> lightColors;
-    srand(13);
-    for (unsigned int i = 0; i < NR_LIGHTS; i++)
-    {
-        // calculate slightly random offsets
-        float xPos = static_cast<float>(((rand() % 100) / 100.0) * 6.0 - 3.0);
-        float yPos = static_cast<float>(((rand() % 100) / 100.0) * 6.0 - 4.0);
-        float zPos = static_cast<float>(((rand() % 100) / 100.0) * 6.0 - 3.0);
-        lightPositions.push_back(glm::vec3(xPos, yPos, zPos));
-        // also calculate random color
-        float rColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
-        float gColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
-        float bColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
-        lightColors.push_back(glm::vec3(rColor, gColor, bColor));
-    }
+
+    // configure g-buffer framebuffers, one per layout
+    // ----------------------------------------------
+    GBuffer standardGBuffer(SCR_WIDTH, SCR_HEIGHT, GBUFFER_STANDARD);
+    GBuffer compactGBuffer(SCR_WIDTH, SCR_HEIGHT, GBUFFER_COMPACT);
+    GBuffer* gBuffers[2] = { &standardGBuffer, &compactGBuffer };
 
     // shader configuration
     // --------------------
-    shaderLightingPass.use();
-    shaderLightingPass.setInt("gPosition", 0);
-    shaderLightingPass.setInt("gNormal", 1);
-    shaderLightingPass.setInt("gAlbedoSpec", 2);
+    Shader* lightingShaders[3] = { &shaderLightingPass, &shaderClusteredLightingPass, &shaderVolumeLightingPass };
+    for (Shader* shader : lightingShaders)
+    {
+        shader->use();
+        shader->setInt("gPosition", 0);
+        shader->setInt("gNormal", 1);
+        shader->setInt("gAlbedoSpec", 2);
+        shader->setInt("gDepth", 3);
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, FAR_PLANE);
+
+    if (benchmark)
+    {
+        // light count sweep from the start position: geometry + lighting pass per frame, and the fragment shader
+        // invocations of one lighting pass where the driver can count them (GL 4.6 or ARB_pipeline_statistics_query)
+        // ----------------------------------------------------------------------------------------------------------
+        bool pipelineStatistics = GLAD_GL_VERSION_4_6;
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; i++)
+            pipelineStatistics = pipelineStatistics || std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), "GL_ARB_pipeline_statistics_query") == 0;
+        unsigned int fragmentQuery = 0;
+        if (pipelineStatistics)
+            glGenQueries(1, &fragmentQuery);
+
+        // g-buffer traffic of one frame: the geometry pass writing every target once, one full screen pass reading them
+        const unsigned int resolutions[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+        std::cout << "g-buffer   bytes/pixel written + read   MB/frame at 1080p   MB/frame at 4K" << std::endl;
+        for (int layout = GBUFFER_STANDARD; layout <= GBUFFER_COMPACT; layout++)
+        {
+            const unsigned int bytesPerPixel = GBuffer::bytesWrittenPerPixel(static_cast<GBufferLayout>(layout)) + GBuffer::bytesReadPerPixel(static_cast<GBufferLayout>(layout));
+            std::cout << gBufferLayoutNames[layout] << "   " << GBuffer::bytesWrittenPerPixel(static_cast<GBufferLayout>(layout)) << " + "
+                << GBuffer::bytesReadPerPixel(static_cast<GBufferLayout>(layout));
+            for (const unsigned int* resolution : resolutions)
+                std::cout << "   " << resolution[0] * resolution[1] * bytesPerPixel / 1.0e6;
+            std::cout << std::endl;
+        }
+
+        const unsigned int lightCounts[6] = { 32, 512, 2048, 4096, 8192, 16384 };
+        const int frames = 20;
+        const glm::mat4 view = camera.GetViewMatrix();
+        std::cout << "lights  mode  g-buffer  ms/frame  fragment invocations (light volumes include the ambient quad)" << std::endl;
+        for (unsigned int count : lightCounts)
+        {
+            std::vector<PointLight> lights = createLights(count);
+            lightClusters.setLights(lights);
+
+            for (int run = 0; run < 6; run++)
+            {
+                const int mode = run / 2;
+                const GBuffer& gBuffer = *gBuffers[run % 2];
+                lightingMode = static_cast<LightingMode>(mode);
+                glFinish();
+                std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+                for (int frame = 0; frame < frames; frame++)
+                {
+                    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.framebuffer);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    renderGeometryPass(shaderGeometryPass, gBuffer, backpack, objectPositions, projection, view);
+                    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                    gBuffer.bindTextures();
+                    if (frame == 0 && fragmentQuery)
+                        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, fragmentQuery);
+                    renderLightingPass(shaderLightingPass, shaderClusteredLightingPass, shaderVolumeLightingPass, lightClusters, gBuffer, projection, view);
+                    if (frame == 0 && fragmentQuery)
+                        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+                }
+                glFinish();
+                const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+                GLuint64 fragments = 0;
+                if (fragmentQuery)
+                    glGetQueryObjectui64v(fragmentQuery, GL_QUERY_RESULT, &fragments);
+                std::cout << count << "    " << lightingModeNames[mode] << "    " << gBufferLayoutNames[gBuffer.getLayout()] << "    " << frameMs << "    ";
+                if (fragmentQuery)
+                    std::cout << fragments;
+                else
+                    std::cout << "n/a";
+                std::cout << std::endl;
+            }
+
+            // the gpu assignment of the clustered frames against the cpu reference
+            std::vector<unsigned int> gpuCounts, gpuIndices, cpuCounts, cpuIndices;
+            lightClusters.readBack(gpuCounts, gpuIndices);
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            assignLightsToClusters(lightClusters.getGrid(), projection, view, lights, lightClusters.getMaxLightsPerCluster(), cpuCounts, cpuIndices);
+            const double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            unsigned int mismatches = 0, maxCount = 0;
+            size_t total = 0;
+            for (unsigned int cluster = 0; cluster < gpuCounts.size(); cluster++)
+            {
+                const unsigned int stored = std::min(cpuCounts[cluster], lightClusters.getMaxLightsPerCluster());
+                bool same = gpuCounts[cluster] == cpuCounts[cluster];
+                for (unsigned int i = 0; same && i < stored; i++)
+                    same = gpuIndices[cluster * lightClusters.getMaxLightsPerCluster() + i] == cpuIndices[cluster * lightClusters.getMaxLightsPerCluster() + i];
+                mismatches += same ? 0 : 1;
+                maxCount = std::max(maxCount, gpuCounts[cluster]);
+                total += gpuCounts[cluster];
+            }
+            std::cout << count << "    clusters: " << static_cast<double>(total) / gpuCounts.size() << " avg / " << maxCount << " max lights, cpu reference "
+                << cpuMs << " ms, " << mismatches << " mismatches" << std::endl;
+        }
+        if (fragmentQuery)
+            glDeleteQueries(1, &fragmentQuery);
+        glfwTerminate();
+        return 0;
+    }
+
+    GpuTimer gpuTimer;
+    float statsStart = 0.0f;
+    int statsFrames = 0;
 
     // render loop
     // -----------
@@ -181,91 +284,58 @@ int main()
         // -----
         processInput(window);
 
+        if (lightCountChanged)
+        {
+            lightClusters.setLights(createLights(lightCount));
+            lightCountChanged = false;
+        }
+
         // render
         // ------
+        gpuTimer.begin();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+        const GBuffer& gBuffer = *gBuffers[gBufferLayout];
+        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.framebuffer);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, FAR_PLANE);
         glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 model = glm::mat4(1.0f);
-        shaderGeometryPass.use();
-        shaderGeometryPass.setMat4("projection", projection);
-        shaderGeometryPass.setMat4("view", view);
-        for (unsigned int i = 0; i < objectPositions.size(); i++)
-        {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, objectPositions[i]);
-            model = glm::scale(model, glm::vec3(0.25f));
-            shaderGeometryPass.setMat4("model", model);
-            backpack.Draw(shaderGeometryPass);
-        }
+        renderGeometryPass(shaderGeometryPass, gBuffer, backpack, objectPositions, projection, view);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
+        // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content,
+        // or by drawing the light volumes. Also copies the gbuffer's depth to the default framebuffer.
         // -----------------------------------------------------------------------------------------------------------------------
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderLightingPass.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-        // send light relevant uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
-        {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-            // update attenuation parameters and calculate radius
-            const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
-            const float linear = 0.7f;
-            const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
-            
-            // then calculate radius of light volume/sphere
-            
-            // between 0 and 1
-            const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b); // select brightest component
-            
-            float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
-        }
-        shaderLightingPass.setVec3("viewPos", camera.Position);
-        // finally render quad
-        renderQuad();
-
-        // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
-        // ----------------------------------------------------------------------------------
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
-        // blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
-        // the internal formats are implementation defined. This works on all of my systems, but if it doesn't on yours you'll likely have to write to the 		
-        // depth buffer in another shader stage (or somehow see to match the default framebuffer's internal format with the FBO's internal format).
-        glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gBuffer.bindTextures();
+        renderLightingPass(shaderLightingPass, shaderClusteredLightingPass, shaderVolumeLightingPass, lightClusters, gBuffer, projection, view);
 
-        // 3. render lights on top of scene
-        // --------------------------------
+        // 3. render lights on top of scene, one instance per light from the light buffer
+        // ------------------------------------------------------------------------------
         shaderLightBox.use();
         shaderLightBox.setMat4("projection", projection);
         shaderLightBox.setMat4("view", view);
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        shaderLightBox.setFloat("boxSize", 0.03f);
+        lightClusters.bind();
+        renderCube(lightClusters.getLightCount());
+
+        gpuTimer.end();
+
+        // frame and gpu time in the title once a second, the gpu time read back without waiting on the frames in flight
+        statsFrames++;
+        if (currentFrame - statsStart >= 1.0f)
         {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, lightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.125f));
-            shaderLightBox.setMat4("model", model);
-            shaderLightBox.setVec3("lightColor", lightColors[i]);
-            renderCube();
+            const std::string title = std::string(lightingModeNames[lightingMode]) + ", " + gBufferLayoutNames[gBufferLayout] + " g-buffer, "
+                + std::to_string(lightClusters.getLightCount()) + " lights: " + std::to_string((currentFrame - statsStart) * 1000.0f / statsFrames) + " ms/frame, "
+                + std::to_string(gpuTimer.takeAverageMs()) + " ms gpu";
+            glfwSetWindowTitle(window, title.c_str());
+            statsStart = currentFrame;
+            statsFrames = 0;
         }
 
-
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
@@ -276,11 +346,147 @@ int main()
     return 0;
 }
 
-// renderCube() renders a 1x1 3D cube in NDC.
-// -------------------------------------------------
+// random lights over the floor, the same ones for a given count
+// -------------------------------------------------------------
+std::vector<PointLight> createLights(unsigned int count)
+{
+    std::vector<PointLight> lights(count);
+    srand(13);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        // calculate slightly random offsets
+        float xPos = static_cast<float>(((rand() % 1000) / 1000.0) * 2.0 * FLOOR_SIZE - FLOOR_SIZE);
+        float yPos = static_cast<float>(((rand() % 1000) / 1000.0) * 1.5 - 1.0);
+        float zPos = static_cast<float>(((rand() % 1000) / 1000.0) * 2.0 * FLOOR_SIZE - FLOOR_SIZE);
+        lights[i].position = glm::vec3(xPos, yPos, zPos);
+        // also calculate random color
+        float rColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
+        float gColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
+        float bColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
+        lights[i].color = glm::vec3(rColor, gColor, bColor);
+        lights[i].linear = LIGHT_LINEAR;
+        lights[i].quadratic = LIGHT_QUADRATIC;
+        // then calculate radius of light volume/sphere
+        lights[i].radius = pointLightRadius(lights[i].color, LIGHT_LINEAR, LIGHT_QUADRATIC);
+    }
+    return lights;
+}
+
+// the backpacks and a white floor below them, into the bound g-buffer
+// -------------------------------------------------------------------
+void renderGeometryPass(Shader& shader, const GBuffer& gBuffer, Model& backpack, const std::vector<glm::vec3>& objectPositions, const glm::mat4& projection, const glm::mat4& view)
+{
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setBool("compactGBuffer", gBuffer.getLayout() == GBUFFER_COMPACT);
+    for (unsigned int i = 0; i < objectPositions.size(); i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, objectPositions[i]);
+        model = glm::scale(model, glm::vec3(0.25f));
+        shader.setMat4("model", model);
+        backpack.Draw(shader);
+    }
+
+    shader.setInt("texture_diffuse1", 0);
+    shader.setInt("texture_specular1", 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, whiteTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, whiteTexture);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.1f, 0.0f));
+    model = glm::scale(model, glm::vec3(FLOOR_SIZE, 0.1f, FLOOR_SIZE));
+    shader.setMat4("model", model);
+    renderCube();
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// full screen lighting with every light, or assigns the lights to clusters first and shades with those, or
+// draws every light's sphere into the default framebuffer, adding the light where the sphere covers the scene
+// ------------------------------------------------------------------------------------------------------------
+void renderLightingPass(Shader& allLightsShader, Shader& clusteredShader, Shader& volumeShader, LightClusters& clusters, const GBuffer& gBuffer, const glm::mat4& projection, const glm::mat4& view)
+{
+    // copy content of geometry's depth buffer to default framebuffer's depth buffer: the light volumes are tested against it
+    // and the light boxes are drawn into the scene with it afterwards
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
+    // blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
+    // the internal formats are implementation defined. This works on all of my systems, but if it doesn't on yours you'll likely have to write to the 		
+    // depth buffer in another shader stage (or somehow see to match the default framebuffer's internal format with the FBO's internal format).
+    glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // how each lighting shader gets position and normal out of the g-buffer
+    const glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+    Shader* shaders[3] = { &allLightsShader, &clusteredShader, &volumeShader };
+    for (Shader* shader : shaders)
+    {
+        shader->use();
+        shader->setBool("compactGBuffer", gBuffer.getLayout() == GBUFFER_COMPACT);
+        shader->setMat4("inverseViewProjection", inverseViewProjection);
+    }
+
+    // the full screen quad must not overwrite the copied depth
+    glDisable(GL_DEPTH_TEST);
+    if (lightingMode == LIGHTING_ALL_LIGHTS)
+    {
+        allLightsShader.use();
+        glUniform1ui(glGetUniformLocation(allLightsShader.ID, "lightCount"), clusters.getLightCount());
+        allLightsShader.setVec3("viewPos", camera.Position);
+        clusters.bind();
+        renderQuad();
+    }
+    else if (lightingMode == LIGHTING_CLUSTERED)
+    {
+        clusters.assign(projection, view);
+        clusteredShader.use();
+        clusters.setLightingUniforms(clusteredShader.ID, glm::vec2(SCR_WIDTH, SCR_HEIGHT));
+        clusteredShader.setMat4("view", view);
+        clusteredShader.setVec3("viewPos", camera.Position);
+        renderQuad();
+    }
+    else
+    {
+        // ambient for every pixel: the full screen pass without any light
+        allLightsShader.use();
+        glUniform1ui(glGetUniformLocation(allLightsShader.ID, "lightCount"), 0);
+        allLightsShader.setVec3("viewPos", camera.Position);
+        renderQuad();
+
+        // then all spheres in one instanced draw, each one adding its light. Only the back faces are drawn and only where
+        // they lie behind (or on) the scene, so pixels with the surface behind the volume or with nothing at all are never
+        // shaded. This also holds with the camera inside a volume, and depth clamping keeps back faces beyond the far plane.
+        volumeShader.use();
+        volumeShader.setMat4("projection", projection);
+        volumeShader.setMat4("view", view);
+        volumeShader.setVec3("viewPos", camera.Position);
+        volumeShader.setVec2("screenSize", glm::vec2(SCR_WIDTH, SCR_HEIGHT));
+        clusters.bind();
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        renderSphere(clusters.getLightCount());
+        glDisable(GL_BLEND);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_CLAMP);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+    glEnable(GL_DEPTH_TEST);
+}
+
+// renderCube() renders a 1x1 3D cube in NDC, instanceCount times.
+// -----------------------------------------------------------------
 unsigned int cubeVAO = 0;
 unsigned int cubeVBO = 0;
-void renderCube()
+void renderCube(unsigned int instanceCount)
 {
     // initialize (if necessary)
     if (cubeVAO == 0)
@@ -347,10 +553,76 @@ void renderCube()
     }
     // render Cube
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
     glBindVertexArray(0);
 }
 
+// renderSphere() renders a coarse sphere around the origin, instanceCount times. Its vertices lie a bit outside
+// the unit sphere so that the flat faces between them still enclose it, as a light volume has to.
+// ---------------------------------------------------------------------------------------------------------------
+unsigned int sphereVAO = 0;
+unsigned int sphereIndexCount;
+void renderSphere(unsigned int instanceCount)
+{
+    if (sphereVAO == 0)
+    {
+        glGenVertexArrays(1, &sphereVAO);
+
+        unsigned int vbo, ebo;
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+
+        const unsigned int X_SEGMENTS = 16;
+        const unsigned int Y_SEGMENTS = 8;
+        const float PI = 3.14159265359f;
+        // no face is further than half a segment from its vertices in either direction
+        const float enclosingScale = 1.0f / (std::cos(PI / X_SEGMENTS) * std::cos(PI / Y_SEGMENTS));
+        for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
+        {
+            for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
+            {
+                float xSegment = (float)x / (float)X_SEGMENTS;
+                float ySegment = (float)y / (float)Y_SEGMENTS;
+                float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+                float yPos = std::cos(ySegment * PI);
+                float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+                positions.push_back(glm::vec3(xPos, yPos, zPos) * enclosingScale);
+            }
+        }
+
+        // counter-clockwise seen from outside, so culling the front faces leaves the far side of the sphere
+        for (unsigned int x = 0; x < X_SEGMENTS; ++x)
+        {
+            for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
+            {
+                unsigned int current = x * (Y_SEGMENTS + 1) + y;
+                unsigned int next = (x + 1) * (Y_SEGMENTS + 1) + y;
+                indices.push_back(current);
+                indices.push_back(next);
+                indices.push_back(current + 1);
+                indices.push_back(next);
+                indices.push_back(next + 1);
+                indices.push_back(current + 1);
+            }
+        }
+        sphereIndexCount = static_cast<unsigned int>(indices.size());
+
+        glBindVertexArray(sphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindVertexArray(0);
+    }
+    glBindVertexArray(sphereVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, instanceCount);
+    glBindVertexArray(0);
+}
 
 // renderQuad() renders a 1x1 XY quad in NDC
 // -----------------------------------------
@@ -398,6 +670,38 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+        lightingMode = LIGHTING_ALL_LIGHTS;
+    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+        lightingMode = LIGHTING_CLUSTERED;
+    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
+        lightingMode = LIGHTING_VOLUMES;
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !compactPressed)
+    {
+        gBufferLayout = gBufferLayout == GBUFFER_STANDARD ? GBUFFER_COMPACT : GBUFFER_STANDARD;
+        compactPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+        compactPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS && !upPressed && lightCount < 65536)
+    {
+        lightCount *= 2;
+        lightCountChanged = true;
+        upPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_RELEASE)
+        upPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS && !downPressed && lightCount > 32)
+    {
+        lightCount /= 2;
+        lightCountChanged = true;
+        downPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_RELEASE)
+        downPressed = false;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -15,16 +15,53 @@ float radius = 0.5;
 float bias = 0.025;
 
 // tile noise texture over screen based on screen dimensions divided by noise size
-// makes rotation of kernels more rapid
-const vec2 noiseScale = vec2(800.0/4.0, 600.0/4.0); 
+// makes rotation of kernels more rapid. The screen is the SSAO target, which may be a fraction of the window:
+// every pixel of it still gets the next rotation of the interleaved 4x4 pattern.
+uniform vec2 noiseScale;
 
 uniform mat4 projection;
 
+// compact layout (see gbuffer.h): view space position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+// view space depth (negative z) at uv, without the full position
+float gBufferDepth(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).z;
+    float ndcDepth = texture(gDepth, uv).r * 2.0 - 1.0;
+    return -projection[3][2] / (ndcDepth + projection[2][2]);
+}
+
 void main()
 {
     // get input for SSAO algorithm
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+    vec3 fragPos = gBufferPosition(TexCoords);
+    vec3 normal = normalize(gBufferNormal(TexCoords));
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz); // get a random rotation vector from noise texture
     // note our random rotation vector has no z-component as defined in the render loop code
 
@@ -61,7 +98,7 @@ void main()
         
         // get depth of existing fragment at the current sample point from the gPosition texture
         // remember the sample point is just an imaginary point, it generally does not correspond to a real point
-        float existingSampleDepth = texture(gPosition, offset.xy).z; // get depth value of the current sample in *view space*
+        float existingSampleDepth = gBufferDepth(offset.xy); // get depth value of the current sample in *view space*
         
         // range check & accumulate
         // as values exceed radius, they get closer to 0.0
@@ -4,20 +4,63 @@ out float FragColor;
 in vec2 TexCoords;
 
 uniform sampler2D ssaoInput;
+// the g-buffer at the resolution of ssaoInput
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
 
-void main() 
+// compact layout (see gbuffer.h): view space position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
 {
-    // average of 16 samples (box blur)
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
 
+// how much a sample on (samplePos, sampleNormal) may stand in for the pixel on (position, normal): none once the depths
+// differ by more than a tenth of the distance or the normals diverge, so occlusion doesn't leak across edges
+float surfaceWeight(vec3 position, vec3 normal, vec3 samplePos, vec3 sampleNormal)
+{
+    float depthWeight = max(0.0, 1.0 - abs(samplePos.z - position.z) / (0.1 * abs(position.z)));
+    return depthWeight * pow(max(dot(normal, sampleNormal), 0.0), 8.0);
+}
+
+uniform vec2 direction; // one texel along x, then along y
+
+void main() 
+{
+    // separable bilateral blur: 9 gaussian weighted taps along direction, each also weighted by how close its
+    // surface is to this pixel's. The 4x4 noise tile repeats every 4 pixels, so this still averages it out.
     vec2 texelSize = 1.0 / vec2(textureSize(ssaoInput, 0));
+    vec3 position = gBufferPosition(TexCoords);
+    vec3 normal = gBufferNormal(TexCoords);
     float result = 0.0;
-    for (int x = -2; x < 2; ++x) 
+    float totalWeight = 0.0;
+    for (int i = -4; i <= 4; ++i)
     {
-        for (int y = -2; y < 2; ++y) 
-        {
-            vec2 offset = vec2(float(x), float(y)) * texelSize;
-            result += texture(ssaoInput, TexCoords + offset).r;
-        }
+        vec2 uv = TexCoords + direction * float(i) * texelSize;
+        float weight = exp(-float(i * i) / 8.0) * surfaceWeight(position, normal, gBufferPosition(uv), gBufferNormal(uv));
+        result += texture(ssaoInput, uv).r * weight;
+        totalWeight += weight;
     }
-    FragColor = result / (4.0 * 4.0);
-}  
\ No newline at end of file
+    // nothing rendered here (no normal): keep the input
+    FragColor = totalWeight > 0.0 ? result / totalWeight : texture(ssaoInput, TexCoords).r;
+}  
@@ -0,0 +1,46 @@
+#version 330 core
+// the reduced resolution g-buffer the SSAO passes read (in the standard layout) when SSAO runs below full resolution
+layout (location = 0) out vec3 lowResPosition;
+layout (location = 1) out vec3 lowResNormal;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+
+// compact layout (see gbuffer.h): view space position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+uniform int downsampleFactor;
+
+void main()
+{
+    // one full resolution texel per pixel, never an average: averaging would invent depths between a foreground and
+    // a background surface. 9.ssao_upsample.fs relies on pixel i being full resolution texel i * downsampleFactor.
+    ivec2 texel = ivec2(gl_FragCoord.xy) * downsampleFactor;
+    vec2 uv = (vec2(texel) + 0.5) / vec2(textureSize(gNormal, 0));
+    lowResPosition = gBufferPosition(uv);
+    lowResNormal = gBufferNormal(uv);
+}
@@ -7,6 +7,17 @@ in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
 
+// compact layout (see gbuffer.h): no position target, the normal goes octahedral encoded into a RG16 target
+uniform bool compactGBuffer;
+
+// folds the unit normal onto the octahedron |x| + |y| + |z| = 1 and unfolds its lower half over the corners
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e * 0.5 + 0.5;
+}
+
 // all variables are in view space
 void main()
 {    
@@ -14,6 +25,8 @@ void main()
     gPosition = FragPos;
     // also store the per-fragment normals into the gbuffer
     gNormal = normalize(Normal);
+    if (compactGBuffer)
+        gNormal = vec3(encodeNormal(gNormal), 0.0);
     // and the diffuse per-fragment color
     gAlbedo.rgb = vec3(0.95); // set a constant diffuse color for each pixel in this example
 
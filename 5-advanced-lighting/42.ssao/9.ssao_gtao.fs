@@ -0,0 +1,122 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+// ground truth ambient occlusion (Jimenez et al. 2016): instead of testing random points of a hemisphere, walk a few
+// screen space directions (slices) through the pixel, find the highest occluder on both sides of each and integrate
+// the visible, cosine weighted arc between those two horizons analytically.
+uniform sampler2D linearDepth; // view space depth at the SSAO resolution, mip mapped
+uniform sampler2D gNormal;
+
+// parameters
+uniform int sliceCount; // directions per pixel
+uniform int stepCount;  // samples per direction and side
+float radius = 0.5;     // the same view space radius as the hemisphere kernel
+float falloff = 0.615;  // share of the radius over which occluders fade out
+
+uniform mat4 projection;
+uniform int frameIndex; // turns the slices and shifts the steps every frame, for the temporal accumulation
+
+// compact layout (see gbuffer.h): octahedral encoded normals
+uniform bool compactGBuffer;
+
+const float PI = 3.14159265;
+const float HALF_PI = 1.57079633;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+// view space position from the depth mip chain
+vec3 viewPosition(vec2 uv, float lod)
+{
+    float z = textureLod(linearDepth, uv, lod).r;
+    return vec3((uv * 2.0 - 1.0) * -z / vec2(projection[0][0], projection[1][1]), z);
+}
+
+// interleaved gradient noise (Jimenez 2014): well spread over neighbouring pixels, so the blur averages it out quickly
+float interleavedGradientNoise(vec2 pixel)
+{
+    pixel += 5.588238 * float(frameIndex % 64);
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    vec2 depthSize = vec2(textureSize(linearDepth, 0));
+    float maxLod = floor(log2(max(depthSize.x, depthSize.y)));
+    vec3 position = viewPosition(TexCoords, 0.0);
+    vec3 normal = normalize(gBufferNormal(TexCoords));
+    vec3 viewVec = normalize(-position);
+
+    // the radius in SSAO pixels at this depth; below one pixel (or where nothing was rendered) there's nothing to find
+    float radiusPixels = radius * projection[1][1] * 0.5 * depthSize.y / max(-position.z, 1e-4);
+    if (position.z >= 0.0 || radiusPixels < 1.0)
+    {
+        FragColor = 1.0;
+        return;
+    }
+    float sliceNoise = interleavedGradientNoise(gl_FragCoord.xy);
+    float stepNoise = interleavedGradientNoise(gl_FragCoord.xy + vec2(17.0, 31.0));
+    float falloffRange = falloff * radius;
+    float falloffFrom = radius - falloffRange;
+
+    float visibility = 0.0;
+    for (int slice = 0; slice < sliceCount; ++slice)
+    {
+        float phi = (float(slice) + sliceNoise) * PI / float(sliceCount);
+        vec2 omega = vec2(cos(phi), sin(phi));
+        // the slice plane holds the view vector and the direction; the normal projected into it sits at angle n
+        vec3 direction = vec3(omega, 0.0);
+        vec3 orthoDirection = direction - dot(direction, viewVec) * viewVec;
+        vec3 axis = normalize(cross(orthoDirection, viewVec));
+        vec3 projectedNormal = normal - axis * dot(normal, axis);
+        float projectedLength = length(projectedNormal);
+        float cosN = clamp(dot(projectedNormal, viewVec) / projectedLength, 0.0, 1.0);
+        float n = sign(dot(orthoDirection, projectedNormal)) * acos(cosN);
+
+        // horizons start at the tangent plane, each sample can only raise them
+        float lowHorizonCos0 = cos(n + HALF_PI);
+        float lowHorizonCos1 = cos(n - HALF_PI);
+        float horizonCos0 = lowHorizonCos0;
+        float horizonCos1 = lowHorizonCos1;
+        for (int i = 0; i < stepCount; ++i)
+        {
+            // denser close to the pixel; far samples read a coarser depth level
+            float s = (float(i) + stepNoise) / float(stepCount);
+            float offsetPixels = max(s * s * radiusPixels, 1.0);
+            vec2 offset = omega * offsetPixels / depthSize;
+            float lod = clamp(log2(offsetPixels) - 3.0, 0.0, maxLod);
+
+            vec3 delta0 = viewPosition(TexCoords + offset, lod) - position;
+            vec3 delta1 = viewPosition(TexCoords - offset, lod) - position;
+            float distance0 = length(delta0);
+            float distance1 = length(delta1);
+            float weight0 = clamp(1.0 - (distance0 - falloffFrom) / falloffRange, 0.0, 1.0);
+            float weight1 = clamp(1.0 - (distance1 - falloffFrom) / falloffRange, 0.0, 1.0);
+            horizonCos0 = max(horizonCos0, mix(lowHorizonCos0, dot(delta0 / distance0, viewVec), weight0));
+            horizonCos1 = max(horizonCos1, mix(lowHorizonCos1, dot(delta1 / distance1, viewVec), weight1));
+        }
+
+        // visible arc between the horizons, clamped to the hemisphere around the normal
+        float h0 = -acos(horizonCos1);
+        float h1 = acos(horizonCos0);
+        h0 = n + clamp(h0 - n, -HALF_PI, HALF_PI);
+        h1 = n + clamp(h1 - n, -HALF_PI, HALF_PI);
+        float arc0 = (cosN + 2.0 * h0 * sin(n) - cos(2.0 * h0 - n)) / 4.0;
+        float arc1 = (cosN + 2.0 * h1 * sin(n) - cos(2.0 * h1 - n)) / 4.0;
+        visibility += projectedLength * (arc0 + arc1);
+    }
+    FragColor = visibility / float(sliceCount); // 1.0 when unoccluded, like 9.ssao.fs
+}
@@ -0,0 +1,26 @@
+#version 330 core
+// view space depth (negative z) of the g-buffer at the SSAO resolution; the mip chain built from it lets GTAO read a
+// coarser level for its far samples
+out float FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gPosition;
+
+// compact layout (see gbuffer.h): view space position rebuilt from depth
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    FragColor = gBufferPosition(TexCoords).z;
+}
@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor; // accumulated occlusion, view space depth, frames accumulated
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput; // this frame's occlusion
+uniform sampler2D history;   // last frame's output
+uniform bool resetHistory;
+uniform mat4 reprojection;   // this frame's view space to last frame's clip space
+// the g-buffer at the resolution of ssaoInput
+uniform sampler2D gPosition;
+
+// compact layout (see gbuffer.h): view space position rebuilt from depth
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+const float maxFrames = 16.0;
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    float occlusion = texture(ssaoInput, TexCoords).r;
+    vec3 position = gBufferPosition(TexCoords);
+
+    // where this surface was last frame; it's the same surface if the depth stored there is the one expected (-w)
+    vec4 previous = reprojection * vec4(position, 1.0);
+    vec2 previousUV = previous.xy / previous.w * 0.5 + 0.5;
+    vec4 accumulated = texture(history, previousUV);
+    bool valid = !resetHistory && previous.w > 0.0
+        && all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)))
+        && abs(accumulated.g + previous.w) < 0.05 * previous.w;
+
+    // running average over the last maxFrames frames, restarted on disocclusion
+    float frames = valid ? min(accumulated.b + 1.0, maxFrames) : 1.0;
+    FragColor = vec4(valid ? mix(accumulated.r, occlusion, 1.0 / frames) : occlusion, position.z, frames, 1.0);
+}
@@ -0,0 +1,85 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput; // reduced resolution, blurred
+uniform sampler2D lowResPosition;
+uniform sampler2D lowResNormal;
+uniform int downsampleFactor;
+
+// the full resolution g-buffer
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+
+// compact layout (see gbuffer.h): view space position rebuilt from depth, octahedral encoded normals
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 gBufferPosition(vec2 uv)
+{
+    if (!compactGBuffer)
+        return texture(gPosition, uv).xyz;
+    vec4 position = inverseProjection * vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+vec3 gBufferNormal(vec2 uv)
+{
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).rg) : texture(gNormal, uv).rgb;
+}
+
+// how much a sample on (samplePos, sampleNormal) may stand in for the pixel on (position, normal): none once the depths
+// differ by more than a tenth of the distance or the normals diverge, so occlusion doesn't leak across edges
+float surfaceWeight(vec3 position, vec3 normal, vec3 samplePos, vec3 sampleNormal)
+{
+    float depthWeight = max(0.0, 1.0 - abs(samplePos.z - position.z) / (0.1 * abs(position.z)));
+    return depthWeight * pow(max(dot(normal, sampleNormal), 0.0), 8.0);
+}
+
+void main()
+{
+    // joint bilateral upsample: the bilinear weights of the 4 surrounding reduced resolution pixels, each scaled by
+    // how well its surface matches this pixel's full resolution one
+    vec3 position = gBufferPosition(TexCoords);
+    vec3 normal = gBufferNormal(TexCoords);
+    // reduced resolution pixel i was taken at full resolution texel i * downsampleFactor, see 9.ssao_downsample.fs
+    vec2 lowResCoord = floor(gl_FragCoord.xy) / float(downsampleFactor);
+    ivec2 base = ivec2(lowResCoord);
+    vec2 f = fract(lowResCoord);
+    ivec2 maxTexel = textureSize(ssaoInput, 0) - 1;
+
+    float result = 0.0;
+    float totalWeight = 0.0;
+    float nearestDistance = 1e30;
+    float nearestOcclusion = 1.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = min(base + offset, maxTexel);
+        vec3 samplePos = texelFetch(lowResPosition, texel, 0).xyz;
+        float occlusion = texelFetch(ssaoInput, texel, 0).r;
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+        float weight = bilinear * surfaceWeight(position, normal, samplePos, texelFetch(lowResNormal, texel, 0).xyz);
+        result += occlusion * weight;
+        totalWeight += weight;
+        // for thin features none of the 4 may match: fall back to the closest surface
+        float distance = length(samplePos - position);
+        if (distance < nearestDistance)
+        {
+            nearestDistance = distance;
+            nearestOcclusion = occlusion;
+        }
+    }
+    FragColor = totalWeight > 1e-3 ? result / totalWeight : nearestOcclusion;
+}
@@ -8,9 +8,16 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/gbuffer.h>
+#include <learnopengl/render_graph.h>
+#include <learnopengl/gpu_timer.h>
 
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <sstream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -19,6 +26,14 @@ void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+struct SSAOShaders;
+struct GBufferTargets;
+struct SSAOHistory;
+GBufferTargets addGeometryPass(RenderGraph& graph, Shader& shader, GBufferLayout layout, Model& backpack, const glm::mat4& projection, const glm::mat4& view);
+GBufferTargets importGBuffer(RenderGraph& graph, const GBuffer& gBuffer);
+RenderGraph::Resource addSSAOPasses(RenderGraph& graph, SSAOShaders& shaders, const GBufferTargets& gBuffer, SSAOHistory& history, unsigned int downsampleFactor, unsigned int noiseTexture, const glm::mat4& projection, const glm::mat4& reprojection, unsigned int frameIndex);
+void addLightingPass(RenderGraph& graph, Shader& shader, const GBufferTargets& gBuffer, RenderGraph::Resource ssao, const glm::vec3& lightPos, const glm::vec3& lightColor, const glm::mat4& projection, const glm::mat4& view);
+void renderGeometryPass(Shader& shader, GBufferLayout layout, Model& backpack, const glm::mat4& projection, const glm::mat4& view);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -34,13 +49,74 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// c switches between the standard and the compact g-buffer layout (see gbuffer.h)
+const char* gBufferLayoutNames[] = { "standard", "compact" };
+GBufferLayout gBufferLayout = GBUFFER_STANDARD;
+bool compactPressed = false;
+
+// r cycles the resolution SSAO runs at, below full resolution it's upsampled to the window (see addSSAOPasses)
+enum SSAOResolution
+{
+    SSAO_FULL,
+    SSAO_HALF,
+    SSAO_QUARTER
+};
+const char* ssaoResolutionNames[] = { "full", "half", "quarter" };
+const unsigned int ssaoDownsampleFactors[] = { 1, 2, 4 };
+SSAOResolution ssaoResolution = SSAO_HALF;
+bool resolutionPressed = false;
+
+// g switches between the hemisphere kernel and ground truth ambient occlusion (GTAO, 9.ssao_gtao.fs), t turns the
+// accumulation of GTAO over frames on and off
+enum AOTechnique
+{
+    AO_HEMISPHERE,
+    AO_GTAO
+};
+const char* aoTechniqueNames[] = { "hemisphere kernel", "GTAO" };
+AOTechnique aoTechnique = AO_HEMISPHERE;
+bool temporalAccumulation = true;
+bool techniquePressed = false;
+bool temporalPressed = false;
+
+// the shaders of the SSAO passes (see addSSAOPasses)
+struct SSAOShaders
+{
+    Shader downsample;
+    Shader hemisphere;
+    Shader linearDepth;
+    Shader gtao;
+    Shader temporal;
+    Shader blur;
+    Shader upsample;
+};
+
+// the g-buffer's textures in a frame's render graph, in the layout of gbuffer.h
+struct GBufferTargets
+{
+    GBufferLayout layout;
+    RenderGraph::Resource position; // NONE for the compact layout
+    RenderGraph::Resource normal, albedoSpec, depth;
+};
+
+// accumulated GTAO at one resolution, alternating between this and last frame. It outlives the frame, so unlike the
+// other SSAO targets it isn't a transient texture of the render graph but created on first use and imported
+struct SSAOHistory
+{
+    unsigned int texture[2] = { 0, 0 };
+    unsigned int frame = 0; // the frame that last wrote it, 0 for none
+};
+
 float ourLerp(float a, float b, float f)
 {
     return a + f * (b - a);
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // "benchmark" times the SSAO passes at every resolution, compares them to full resolution and exits
+    const bool benchmark = argc > 1 && std::strcmp(argv[1], "benchmark") == 0;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -65,6 +141,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSwapInterval(0); // frame times are printed, don't wait for vsync
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -85,82 +162,25 @@ int main()
     // -------------------------
     Shader shaderGeometryPass("9.ssao_geometry.vs", "9.ssao_geometry.fs");
     Shader shaderLightingPass("9.ssao.vs", "9.ssao_lighting.fs");
-    Shader shaderSSAO("9.ssao.vs", "9.ssao.fs");
-    Shader shaderSSAOBlur("9.ssao.vs", "9.ssao_blur.fs");
+    SSAOShaders ssaoShaders = {
+        Shader("9.ssao.vs", "9.ssao_downsample.fs"),
+        Shader("9.ssao.vs", "9.ssao.fs"),
+        Shader("9.ssao.vs", "9.ssao_linear_depth.fs"),
+        Shader("9.ssao.vs", "9.ssao_gtao.fs"),
+        Shader("9.ssao.vs", "9.ssao_temporal.fs"),
+        Shader("9.ssao.vs", "9.ssao_blur.fs"),
+        Shader("9.ssao.vs", "9.ssao_upsample.fs")
+    };
 
     // load models
     // -----------
     Model backpack(("../../resources/objects/backpack/backpack.obj"));
 
-    // configure g-buffer framebuffer
-    // ------------------------------
-    unsigned int gBuffer;
-    glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedo;
-    // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    // color + specular color buffer
-    glGenTextures(1, &gAlbedo);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // also create framebuffer to hold SSAO processing stage 
-    // -----------------------------------------------------
-    unsigned int ssaoFBO, ssaoBlurFBO;
-    glGenFramebuffers(1, &ssaoFBO);  glGenFramebuffers(1, &ssaoBlurFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-    unsigned int ssaoColorBuffer, ssaoColorBufferBlur;
-    // SSAO color buffer
-    glGenTextures(1, &ssaoColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "SSAO Framebuffer not complete!" << std::endl;
-    // and blur stage
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-    glGenTextures(1, &ssaoColorBufferBlur);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // the g-buffer and the SSAO processing stages are transient textures of a render graph, rebuilt every frame for
+    // the selected layout, resolution and technique; only the GTAO history (one per resolution) outlives the frame
+    // ---------------------------------------------------------------------------------------------------------------
+    RenderGraph frameGraph;
+    SSAOHistory ssaoHistory[3];
 
     // generate sample kernel
     // ----------------------
@@ -214,13 +234,170 @@ int main()
     shaderLightingPass.setInt("gPosition", 0);
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedo", 2);
-    shaderLightingPass.setInt("ssao", 3);
-    shaderSSAO.use();
-    shaderSSAO.setInt("gPosition", 0);
-    shaderSSAO.setInt("gNormal", 1);
-    shaderSSAO.setInt("texNoise", 2);
-    shaderSSAOBlur.use();
-    shaderSSAOBlur.setInt("ssaoInput", 0);
+    shaderLightingPass.setInt("gDepth", 3);
+    shaderLightingPass.setInt("ssao", 4);
+    Shader* ssaoPassShaders[7] = { &ssaoShaders.downsample, &ssaoShaders.hemisphere, &ssaoShaders.linearDepth, &ssaoShaders.gtao,
+        &ssaoShaders.temporal, &ssaoShaders.blur, &ssaoShaders.upsample };
+    for (Shader* shader : ssaoPassShaders)
+    {
+        shader->use();
+        shader->setInt("gPosition", 0);
+        shader->setInt("gNormal", 1);
+        shader->setInt("gDepth", 3);
+    }
+    ssaoShaders.hemisphere.use();
+    ssaoShaders.hemisphere.setInt("texNoise", 4);
+    // the kernel doesn't change, send it once
+    for (unsigned int i = 0; i < 64; ++i)
+        ssaoShaders.hemisphere.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+    ssaoShaders.gtao.use();
+    ssaoShaders.gtao.setInt("linearDepth", 4);
+    ssaoShaders.gtao.setInt("sliceCount", 2);
+    ssaoShaders.gtao.setInt("stepCount", 4);
+    ssaoShaders.temporal.use();
+    ssaoShaders.temporal.setInt("ssaoInput", 4);
+    ssaoShaders.temporal.setInt("history", 5);
+    ssaoShaders.blur.use();
+    ssaoShaders.blur.setInt("ssaoInput", 4);
+    ssaoShaders.upsample.use();
+    ssaoShaders.upsample.setInt("ssaoInput", 4);
+    ssaoShaders.upsample.setInt("lowResPosition", 5);
+    ssaoShaders.upsample.setInt("lowResNormal", 6);
+
+    // frames rendered, rotates the GTAO slices and tells the temporal accumulation whether its history is last frame's
+    unsigned int frameIndex = 0;
+
+    if (benchmark)
+    {
+        // SSAO passes only (downsample, occlusion, blur, upsample) per g-buffer layout, technique and resolution from
+        // the start position. quality: how far the final, window sized AO is from the full resolution AO of the same
+        // technique, and for GTAO from a 16 slice x 16 step GTAO without accumulation. The SSAO passes run as render
+        // graphs on a g-buffer rendered once; last the render target memory of whole frames, against every target
+        // having a texture of its own as before the render graph
+        // -------------------------------------------------------------------------------------------------------------
+        const int frames = 16;
+        const glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 50.0f);
+        const glm::mat4 view = camera.GetViewMatrix();
+        const glm::mat4 reprojection = projection; // the camera doesn't move: last frame's view is this frame's
+        std::vector<float> fullResolution(SCR_WIDTH * SCR_HEIGHT), gtaoReference(SCR_WIDTH * SCR_HEIGHT), result(SCR_WIDTH * SCR_HEIGHT);
+        std::cout << "g-buffer  technique  resolution  ms/frame  error vs full resolution: mean  max  pixels > 0.05  mean error vs GTAO reference" << std::endl;
+        RenderGraph ssaoGraph;
+        for (int layout = GBUFFER_STANDARD; layout <= GBUFFER_COMPACT; layout++)
+        {
+            GBuffer gBuffer(SCR_WIDTH, SCR_HEIGHT, (GBufferLayout)layout);
+            glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.framebuffer);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderGeometryPass(shaderGeometryPass, gBuffer.getLayout(), backpack, projection, view);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // the SSAO passes on the g-buffer, keeping their result alive for the readback
+            auto renderSSAOGraph = [&](int resolution) {
+                ssaoGraph.reset();
+                RenderGraph::Resource ao = addSSAOPasses(ssaoGraph, ssaoShaders, importGBuffer(ssaoGraph, gBuffer), ssaoHistory[resolution],
+                    ssaoDownsampleFactors[resolution], noiseTexture, projection, reprojection, ++frameIndex);
+                ssaoGraph.exportTexture(ao);
+                ssaoGraph.execute();
+                return ssaoGraph.getTexture(ao);
+            };
+
+            aoTechnique = AO_GTAO;
+            temporalAccumulation = false;
+            ssaoShaders.gtao.use();
+            ssaoShaders.gtao.setInt("sliceCount", 16);
+            ssaoShaders.gtao.setInt("stepCount", 16);
+            glBindTexture(GL_TEXTURE_2D, renderSSAOGraph(SSAO_FULL));
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, gtaoReference.data());
+            ssaoShaders.gtao.use();
+            ssaoShaders.gtao.setInt("sliceCount", 2);
+            ssaoShaders.gtao.setInt("stepCount", 4);
+
+            // hemisphere kernel, GTAO, GTAO accumulated over frames
+            for (int run = 0; run < 3; run++)
+            {
+                aoTechnique = run == 0 ? AO_HEMISPHERE : AO_GTAO;
+                temporalAccumulation = run == 2;
+                for (int resolution = SSAO_FULL; resolution <= SSAO_QUARTER; resolution++)
+                {
+                    unsigned int ao = 0;
+                    glFinish();
+                    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+                    for (int frame = 0; frame < frames; frame++)
+                        ao = renderSSAOGraph(resolution);
+                    glFinish();
+                    const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+                    glBindTexture(GL_TEXTURE_2D, ao);
+                    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, result.data());
+                    if (resolution == SSAO_FULL)
+                        fullResolution = result;
+                    double errorSum = 0.0, referenceErrorSum = 0.0;
+                    float errorMax = 0.0f;
+                    unsigned int errorPixels = 0;
+                    for (size_t i = 0; i < result.size(); i++)
+                    {
+                        const float error = std::abs(result[i] - fullResolution[i]);
+                        errorSum += error;
+                        errorMax = std::max(errorMax, error);
+                        errorPixels += error > 0.05f ? 1 : 0;
+                        referenceErrorSum += std::abs(result[i] - gtaoReference[i]);
+                    }
+                    std::cout << gBufferLayoutNames[layout] << "    " << aoTechniqueNames[aoTechnique] << (temporalAccumulation ? " accumulated" : "") << "    "
+                        << ssaoResolutionNames[resolution] << "    " << frameMs << "    " << errorSum / result.size() << "  " << errorMax << "  "
+                        << 100.0 * errorPixels / result.size() << "%    ";
+                    if (aoTechnique == AO_GTAO)
+                        std::cout << referenceErrorSum / result.size();
+                    else
+                        std::cout << "n/a";
+                    std::cout << std::endl;
+                }
+            }
+        }
+
+        // before the render graph both g-buffers and the SSAO targets of every resolution had textures of their own
+        unsigned long long separateBytes = (unsigned long long)(GBuffer::bytesWrittenPerPixel(GBUFFER_STANDARD) + GBuffer::bytesWrittenPerPixel(GBUFFER_COMPACT)) * SCR_WIDTH * SCR_HEIGHT;
+        for (int resolution = SSAO_FULL; resolution <= SSAO_QUARTER; resolution++)
+        {
+            const unsigned int factor = ssaoDownsampleFactors[resolution];
+            const unsigned int width = (SCR_WIDTH + factor - 1) / factor, height = (SCR_HEIGHT + factor - 1) / factor;
+            if (factor > 1)
+                separateBytes += 2 * RenderGraphTexture(width, height, GL_RGBA16F).bytes() + RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_R8).bytes();
+            const unsigned int levels = (unsigned int)std::floor(std::log2((float)std::max(width, height))) + 1;
+            separateBytes += RenderGraphTexture(width, height, GL_R32F, GL_NEAREST, levels).bytes() + 3 * RenderGraphTexture(width, height, GL_R8).bytes()
+                + 2 * RenderGraphTexture(width, height, GL_RGBA16F).bytes();
+        }
+        for (int layout = GBUFFER_STANDARD; layout <= GBUFFER_COMPACT; layout++)
+        {
+            for (int run = 0; run < 3; run++)
+            {
+                aoTechnique = run == 0 ? AO_HEMISPHERE : AO_GTAO;
+                temporalAccumulation = run == 2;
+                for (int resolution = SSAO_FULL; resolution <= SSAO_QUARTER; resolution++)
+                {
+                    ssaoGraph.reset();
+                    GBufferTargets gBuffer = addGeometryPass(ssaoGraph, shaderGeometryPass, (GBufferLayout)layout, backpack, projection, view);
+                    RenderGraph::Resource ao = addSSAOPasses(ssaoGraph, ssaoShaders, gBuffer, ssaoHistory[resolution], ssaoDownsampleFactors[resolution],
+                        noiseTexture, projection, reprojection, ++frameIndex);
+                    addLightingPass(ssaoGraph, shaderLightingPass, gBuffer, ao, lightPos, lightColor, projection, view);
+                    ssaoGraph.compile();
+                    // the history is imported, not one of the graph's textures
+                    const unsigned int factor = ssaoDownsampleFactors[resolution];
+                    const unsigned long long historyBytes = temporalAccumulation
+                        ? 2 * RenderGraphTexture((SCR_WIDTH + factor - 1) / factor, (SCR_HEIGHT + factor - 1) / factor, GL_RGBA16F).bytes() : 0;
+                    std::cout << "render targets, " << gBufferLayoutNames[layout] << " " << aoTechniqueNames[aoTechnique] << (temporalAccumulation ? " accumulated" : "") << " "
+                        << ssaoResolutionNames[resolution] << ": separate " << separateBytes / 1.0e6 << " MB, graph " << (ssaoGraph.getTextureBytes() + historyBytes) / 1.0e6
+                        << " MB (" << (ssaoGraph.getUnaliasedTextureBytes() + historyBytes) / 1.0e6 << " MB without aliasing), " << ssaoGraph.getPassCount() - ssaoGraph.getCulledPassCount()
+                        << " of " << ssaoGraph.getPassCount() << " passes" << std::endl;
+                }
+            }
+        }
+        glfwTerminate();
+        return 0;
+    }
+
+    GpuTimer gpuTimer;
+    float statsStart = 0.0f;
+    int statsFrames = 0;
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
 
     // render loop
     // -----------
@@ -238,89 +415,46 @@ int main()
 
         // render
         // ------
+        gpuTimer.begin();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        frameGraph.reset();
+
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 50.0f);
-            glm::mat4 view = camera.GetViewMatrix();
-            glm::mat4 model = glm::mat4(1.0f);
-            shaderGeometryPass.use();
-            shaderGeometryPass.setMat4("projection", projection);
-            shaderGeometryPass.setMat4("view", view);
-            // room cube
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0, 7.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(7.5f, 7.5f, 7.5f));
-            shaderGeometryPass.setMat4("model", model);
-            shaderGeometryPass.setInt("invertedNormals", 1); // invert normals as we're inside the cube
-            renderCube();
-            shaderGeometryPass.setInt("invertedNormals", 0); 
-            // backpack model on the floor
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0));
-            model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0));
-            model = glm::scale(model, glm::vec3(1.0f));
-            shaderGeometryPass.setMat4("model", model);
-            backpack.Draw(shaderGeometryPass);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-        // 2. generate SSAO texture
-        // ------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
-            shaderSSAO.use();
-            // Send kernel + rotation 
-            for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
-            shaderSSAO.setMat4("projection", projection);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gPosition);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gNormal);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, noiseTexture);
-            renderQuad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 50.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        GBufferTargets gBuffer = addGeometryPass(frameGraph, shaderGeometryPass, gBufferLayout, backpack, projection, view);
 
 
-        // 3. blur SSAO texture to remove noise
-        // ------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
-            shaderSSAOBlur.use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-            renderQuad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // 2. generate SSAO texture and blur it to remove noise, at the selected resolution
+        // --------------------------------------------------------------------------------
+        RenderGraph::Resource ssaoTexture = addSSAOPasses(frameGraph, ssaoShaders, gBuffer, ssaoHistory[ssaoResolution], ssaoDownsampleFactors[ssaoResolution],
+            noiseTexture, projection, previousViewProjection * glm::inverse(view), ++frameIndex);
+        previousViewProjection = projection * view;
 
 
-        // 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
+        // 3. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
         // -----------------------------------------------------------------------------------------------------
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderLightingPass.use();
-        // send light relevant uniforms
-        glm::vec3 lightPosView = glm::vec3(camera.GetViewMatrix() * glm::vec4(lightPos, 1.0));
-        shaderLightingPass.setVec3("light.Position", lightPosView);
-        shaderLightingPass.setVec3("light.Color", lightColor);
-        // Update attenuation parameters
-        const float linear    = 0.09f;
-        const float quadratic = 0.032f;
-        shaderLightingPass.setFloat("light.Linear", linear);
-        shaderLightingPass.setFloat("light.Quadratic", quadratic);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gAlbedo);
-        glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
-        glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-        renderQuad();
+        addLightingPass(frameGraph, shaderLightingPass, gBuffer, ssaoTexture, lightPos, lightColor, projection, view);
+        frameGraph.execute();
+
+        gpuTimer.end();
+
+        // frame and gpu time in the title once a second, the gpu time read back without waiting on the frames in flight
+        statsFrames++;
+        if (currentFrame - statsStart >= 1.0f)
+        {
+            std::ostringstream title;
+            title << gBufferLayoutNames[gBufferLayout] << " g-buffer, " << ssaoResolutionNames[ssaoResolution] << " resolution "
+                << aoTechniqueNames[aoTechnique] << (aoTechnique == AO_GTAO && temporalAccumulation ? " (accumulated)" : "") << ": "
+                << (currentFrame - statsStart) * 1000.0f / statsFrames << " ms/frame, " << gpuTimer.takeAverageMs() << " ms gpu, render targets "
+                << frameGraph.getTextureBytes() / 1.0e6 << " MB (" << frameGraph.getUnaliasedTextureBytes() / 1.0e6 << " MB without aliasing)";
+            glfwSetWindowTitle(window, title.str().c_str());
+            statsStart = currentFrame;
+            statsFrames = 0;
+        }
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -333,6 +467,286 @@ int main()
     return 0;
 }
 
+// renders the room and the backpack into the g-buffer (bound by the caller)
+// --------------------------------------------------------------------------
+void renderGeometryPass(Shader& shader, GBufferLayout layout, Model& backpack, const glm::mat4& projection, const glm::mat4& view)
+{
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setBool("compactGBuffer", layout == GBUFFER_COMPACT);
+    // room cube
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0, 7.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(7.5f, 7.5f, 7.5f));
+    shader.setMat4("model", model);
+    shader.setInt("invertedNormals", 1); // invert normals as we're inside the cube
+    renderCube();
+    shader.setInt("invertedNormals", 0);
+    // backpack model on the floor
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0));
+    model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0));
+    model = glm::scale(model, glm::vec3(1.0f));
+    shader.setMat4("model", model);
+    backpack.Draw(shader);
+}
+
+// the window sized g-buffer as transient textures of the graph and the geometry pass filling it. The compact layout
+// leaves location 0 (position) without a target, as GBuffer does
+// ------------------------------------------------------------------------------------------------------------------
+GBufferTargets addGeometryPass(RenderGraph& graph, Shader& shader, GBufferLayout layout, Model& backpack, const glm::mat4& projection, const glm::mat4& view)
+{
+    GBufferTargets gBuffer;
+    gBuffer.layout = layout;
+    gBuffer.position = RenderGraph::NONE;
+    if (layout == GBUFFER_STANDARD)
+        gBuffer.position = graph.createTexture("g-buffer position", RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_RGBA16F, GL_NEAREST));
+    gBuffer.normal = graph.createTexture("g-buffer normal", RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GBuffer::normalFormat(layout), GL_NEAREST));
+    gBuffer.albedoSpec = graph.createTexture("g-buffer albedo", RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8, GL_NEAREST));
+    gBuffer.depth = graph.createTexture("g-buffer depth", RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_COMPONENT24, GL_NEAREST));
+    graph.addPass("geometry", PASS_RASTER, [&shader, &backpack, layout, projection, view]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderGeometryPass(shader, layout, backpack, projection, view);
+    }).write(gBuffer.position).write(gBuffer.normal).write(gBuffer.albedoSpec).write(gBuffer.depth);
+    return gBuffer;
+}
+
+// the textures of a GBuffer rendered outside the graph
+// -----------------------------------------------------
+GBufferTargets importGBuffer(RenderGraph& graph, const GBuffer& gBuffer)
+{
+    GBufferTargets imported;
+    imported.layout = gBuffer.getLayout();
+    imported.position = RenderGraph::NONE;
+    if (imported.layout == GBUFFER_STANDARD)
+        imported.position = graph.importTexture("g-buffer position", gBuffer.position, RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_RGBA16F, GL_NEAREST));
+    imported.normal = graph.importTexture("g-buffer normal", gBuffer.normal, RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GBuffer::normalFormat(imported.layout), GL_NEAREST));
+    imported.albedoSpec = graph.importTexture("g-buffer albedo", gBuffer.albedoSpec, RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_RGBA8, GL_NEAREST));
+    imported.depth = graph.importTexture("g-buffer depth", gBuffer.depth, RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_DEPTH_COMPONENT24, GL_NEAREST));
+    return imported;
+}
+
+// position (standard layout) on texture unit 0, normal on 1, albedo + specular on 2 and depth on 3, as
+// GBuffer::bindTextures; called inside a pass. declareGBufferReads declares what the SSAO passes read of it
+// ---------------------------------------------------------------------------------------------------------
+void bindGBuffer(const RenderGraph& graph, const GBufferTargets& gBuffer)
+{
+    RenderGraph::Resource resources[4] = { gBuffer.position, gBuffer.normal, gBuffer.albedoSpec, gBuffer.depth };
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, resources[i] == RenderGraph::NONE ? 0 : graph.getTexture(resources[i]));
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void declareGBufferReads(RenderGraph::PassBuilder pass, const GBufferTargets& gBuffer)
+{
+    if (gBuffer.position != RenderGraph::NONE)
+        pass.read(gBuffer.position);
+    pass.read(gBuffer.normal).read(gBuffer.depth);
+}
+
+// a point sampled, clamped texture; the GTAO history, the rest of the SSAO targets are the render graph's
+// --------------------------------------------------------------------------------------------------------
+unsigned int createSSAOTarget(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// adds the passes rendering the window sized, blurred ambient occlusion of the g-buffer with the selected technique
+// and returns its texture. below full resolution the g-buffer is first point sampled down (one pixel of every
+// downsampleFactor x downsampleFactor block, so depths and normals stay those of real surfaces), occlusion and blur
+// run on that and the result is brought back up with a joint bilateral upsample that only takes low resolution pixels
+// on the same surface as the full resolution one. the hemisphere kernel's 4x4 noise tile repeats per SSAO pixel, so
+// each pixel of a block samples a different rotation of the kernel (interleaved sampling) which the blur and upsample
+// then average out. GTAO reads a mip mapped copy of the depth and, with temporal accumulation, is averaged with the
+// reprojected result of the previous frames before the blur; reprojection takes this frame's view space to last
+// frame's clip space. every target but the history is transient: the occlusion and the second blur share a texture
+// ------------------------------------------------------------------------------------------------------------------
+RenderGraph::Resource addSSAOPasses(RenderGraph& graph, SSAOShaders& shaders, const GBufferTargets& gBuffer, SSAOHistory& history, unsigned int downsampleFactor, unsigned int noiseTexture, const glm::mat4& projection, const glm::mat4& reprojection, unsigned int frameIndex)
+{
+    const bool compact = gBuffer.layout == GBUFFER_COMPACT;
+    const glm::mat4 inverseProjection = glm::inverse(projection);
+    const unsigned int width = (SCR_WIDTH + downsampleFactor - 1) / downsampleFactor;
+    const unsigned int height = (SCR_HEIGHT + downsampleFactor - 1) / downsampleFactor;
+    const RenderGraphTexture occlusionDescription(width, height, GL_R8, GL_NEAREST);
+
+    // the g-buffer the occlusion and blur passes read: the window's own or its reduced resolution copy (standard
+    // layout, albedo and depth stay those of the window)
+    GBufferTargets input = gBuffer;
+    if (downsampleFactor > 1)
+    {
+        input.layout = GBUFFER_STANDARD;
+        input.position = graph.createTexture("ssao position", RenderGraphTexture(width, height, GL_RGBA16F, GL_NEAREST));
+        input.normal = graph.createTexture("ssao normal", RenderGraphTexture(width, height, GL_RGBA16F, GL_NEAREST));
+        RenderGraph::PassBuilder pass = graph.addPass("ssao downsample", PASS_RASTER, [&graph, &shaders, gBuffer, downsampleFactor, compact, inverseProjection]() {
+            bindGBuffer(graph, gBuffer);
+            shaders.downsample.use();
+            shaders.downsample.setInt("downsampleFactor", downsampleFactor);
+            shaders.downsample.setBool("compactGBuffer", compact);
+            shaders.downsample.setMat4("inverseProjection", inverseProjection);
+            renderQuad();
+        }).write(input.position).write(input.normal);
+        declareGBufferReads(pass, gBuffer);
+    }
+    const bool compactInput = input.layout == GBUFFER_COMPACT;
+
+    // occlusion
+    RenderGraph::Resource occlusion = graph.createTexture("ssao", occlusionDescription);
+    if (aoTechnique == AO_HEMISPHERE)
+    {
+        RenderGraph::PassBuilder pass = graph.addPass("ssao hemisphere", PASS_RASTER, [&graph, &shaders, input, noiseTexture, projection, inverseProjection, compactInput, width, height]() {
+            bindGBuffer(graph, input);
+            shaders.hemisphere.use();
+            shaders.hemisphere.setMat4("projection", projection);
+            shaders.hemisphere.setBool("compactGBuffer", compactInput);
+            shaders.hemisphere.setMat4("inverseProjection", inverseProjection);
+            shaders.hemisphere.setVec2("noiseScale", glm::vec2(width / 4.0f, height / 4.0f));
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, noiseTexture);
+            renderQuad();
+        }).write(occlusion);
+        declareGBufferReads(pass, input);
+    }
+    else
+    {
+        // a full mip chain, filled by glGenerateMipmap from the level the pass draws
+        const unsigned int levels = (unsigned int)std::floor(std::log2((float)std::max(width, height))) + 1;
+        RenderGraph::Resource linearDepth = graph.createTexture("ssao linear depth", RenderGraphTexture(width, height, GL_R32F, GL_NEAREST, levels));
+        RenderGraph::PassBuilder depthPass = graph.addPass("ssao linear depth", PASS_RASTER, [&graph, &shaders, input, linearDepth, compactInput, inverseProjection]() {
+            bindGBuffer(graph, input);
+            shaders.linearDepth.use();
+            shaders.linearDepth.setBool("compactGBuffer", compactInput);
+            shaders.linearDepth.setMat4("inverseProjection", inverseProjection);
+            renderQuad();
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, graph.getTexture(linearDepth));
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }).write(linearDepth);
+        declareGBufferReads(depthPass, input);
+
+        RenderGraph::PassBuilder gtaoPass = graph.addPass("ssao gtao", PASS_RASTER, [&graph, &shaders, input, linearDepth, projection, compactInput, frameIndex]() {
+            bindGBuffer(graph, input);
+            shaders.gtao.use();
+            shaders.gtao.setMat4("projection", projection);
+            shaders.gtao.setBool("compactGBuffer", compactInput);
+            shaders.gtao.setInt("frameIndex", frameIndex);
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, graph.getTexture(linearDepth));
+            renderQuad();
+        }).read(linearDepth).write(occlusion);
+        declareGBufferReads(gtaoPass, input);
+
+        if (temporalAccumulation)
+        {
+            if (history.texture[0] == 0)
+            {
+                for (unsigned int i = 0; i < 2; i++)
+                    history.texture[i] = createSSAOTarget(width, height, GL_RGBA16F, GL_RGBA);
+            }
+            const unsigned int current = frameIndex % 2;
+            const RenderGraphTexture historyDescription(width, height, GL_RGBA16F, GL_NEAREST);
+            RenderGraph::Resource previous = graph.importTexture("ssao history", history.texture[1 - current], historyDescription);
+            RenderGraph::Resource accumulated = graph.importTexture("ssao history", history.texture[current], historyDescription);
+            // the other history is only last frame's if this resolution rendered it, with accumulation on
+            const bool resetHistory = history.frame == 0 || history.frame + 1 != frameIndex;
+            history.frame = frameIndex;
+            RenderGraph::PassBuilder pass = graph.addPass("ssao temporal", PASS_RASTER, [&graph, &shaders, input, occlusion, previous, compactInput, inverseProjection, reprojection, resetHistory]() {
+                bindGBuffer(graph, input);
+                shaders.temporal.use();
+                shaders.temporal.setBool("compactGBuffer", compactInput);
+                shaders.temporal.setMat4("inverseProjection", inverseProjection);
+                shaders.temporal.setMat4("reprojection", reprojection);
+                shaders.temporal.setBool("resetHistory", resetHistory);
+                glActiveTexture(GL_TEXTURE4);
+                glBindTexture(GL_TEXTURE_2D, graph.getTexture(occlusion));
+                glActiveTexture(GL_TEXTURE5);
+                glBindTexture(GL_TEXTURE_2D, graph.getTexture(previous));
+                renderQuad();
+            }).read(occlusion).read(previous).write(accumulated);
+            declareGBufferReads(pass, input);
+            occlusion = accumulated;
+        }
+    }
+
+    // depth and normal aware blur, horizontal then vertical
+    RenderGraph::Resource blurred = occlusion;
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        RenderGraph::Resource source = blurred;
+        blurred = graph.createTexture(i == 0 ? "ssao blur horizontal" : "ssao blur vertical", occlusionDescription);
+        const glm::vec2 direction = i == 0 ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f);
+        RenderGraph::PassBuilder pass = graph.addPass("ssao blur", PASS_RASTER, [&graph, &shaders, input, source, compactInput, inverseProjection, direction]() {
+            bindGBuffer(graph, input);
+            shaders.blur.use();
+            shaders.blur.setBool("compactGBuffer", compactInput);
+            shaders.blur.setMat4("inverseProjection", inverseProjection);
+            shaders.blur.setVec2("direction", direction);
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, graph.getTexture(source));
+            renderQuad();
+        }).read(source).write(blurred);
+        declareGBufferReads(pass, input);
+    }
+    if (downsampleFactor == 1)
+        return blurred;
+
+    // back to the window size
+    RenderGraph::Resource upsampled = graph.createTexture("ssao upsampled", RenderGraphTexture(SCR_WIDTH, SCR_HEIGHT, GL_R8, GL_NEAREST));
+    RenderGraph::PassBuilder pass = graph.addPass("ssao upsample", PASS_RASTER, [&graph, &shaders, gBuffer, input, blurred, downsampleFactor, compact, inverseProjection]() {
+        bindGBuffer(graph, gBuffer);
+        shaders.upsample.use();
+        shaders.upsample.setInt("downsampleFactor", downsampleFactor);
+        shaders.upsample.setBool("compactGBuffer", compact);
+        shaders.upsample.setMat4("inverseProjection", inverseProjection);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, graph.getTexture(blurred));
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, graph.getTexture(input.position));
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D, graph.getTexture(input.normal));
+        glActiveTexture(GL_TEXTURE0);
+        renderQuad();
+    }).read(blurred).read(input.position).read(input.normal).write(upsampled);
+    declareGBufferReads(pass, gBuffer);
+    return upsampled;
+}
+
+// traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion, into the default framebuffer
+// ------------------------------------------------------------------------------------------------------------------
+void addLightingPass(RenderGraph& graph, Shader& shader, const GBufferTargets& gBuffer, RenderGraph::Resource ssao, const glm::vec3& lightPos, const glm::vec3& lightColor, const glm::mat4& projection, const glm::mat4& view)
+{
+    RenderGraph::PassBuilder pass = graph.addPass("lighting", PASS_RASTER, [&graph, &shader, gBuffer, ssao, lightPos, lightColor, projection, view]() {
+        shader.use();
+        // send light relevant uniforms
+        glm::vec3 lightPosView = glm::vec3(view * glm::vec4(lightPos, 1.0));
+        shader.setVec3("light.Position", lightPosView);
+        shader.setVec3("light.Color", lightColor);
+        // Update attenuation parameters
+        const float linear    = 0.09f;
+        const float quadratic = 0.032f;
+        shader.setFloat("light.Linear", linear);
+        shader.setFloat("light.Quadratic", quadratic);
+        shader.setBool("compactGBuffer", gBuffer.layout == GBUFFER_COMPACT);
+        shader.setMat4("inverseProjection", glm::inverse(projection));
+        bindGBuffer(graph, gBuffer);
+        glActiveTexture(GL_TEXTURE4); // add extra SSAO texture to lighting pass
+        glBindTexture(GL_TEXTURE_2D, graph.getTexture(ssao));
+        renderQuad();
+    }).read(gBuffer.albedoSpec).read(ssao).sideEffect();
+    declareGBufferReads(pass, gBuffer);
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -455,6 +869,38 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !compactPressed)
+    {
+        gBufferLayout = gBufferLayout == GBUFFER_STANDARD ? GBUFFER_COMPACT : GBUFFER_STANDARD;
+        compactPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+        compactPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !resolutionPressed)
+    {
+        ssaoResolution = static_cast<SSAOResolution>((ssaoResolution + 1) % 3);
+        resolutionPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE)
+        resolutionPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !techniquePressed)
+    {
+        aoTechnique = aoTechnique == AO_HEMISPHERE ? AO_GTAO : AO_HEMISPHERE;
+        techniquePressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+        techniquePressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !temporalPressed)
+    {
+        temporalAccumulation = !temporalAccumulation;
+        temporalPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE)
+        temporalPressed = false;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
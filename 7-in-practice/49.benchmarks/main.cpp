@@ -0,0 +1,707 @@
+// CPU benchmarks for the shared learnopengl/ headers, no window or GL context needed.
+// usage: benchmarks [name...]   (runs every benchmark when no name is given)
+#include <glad/glad.h>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/spatial_index.h>
+#include <learnopengl/culling_context.h>
+#include <learnopengl/bone.h>
+#include <learnopengl/light_clusters.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/occlusion_rasterizer.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// timing helpers
+// --------------
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// results are written here so the optimizer can't drop the timed work
+volatile float benchmarkSink = 0.0f;
+
+// spatial index: 100k moving entities
+// -----------------------------------
+struct MovingObject
+{
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 extents;
+
+    SpatialBox box() const { return SpatialBox(position - extents, position + extents); }
+};
+
+// reference results for the queries
+unsigned int bruteForceRange(const std::vector<MovingObject>& objects, const SpatialBox& range)
+{
+    unsigned int hits = 0;
+    for (const MovingObject& object : objects)
+        hits += object.box().overlaps(range) ? 1 : 0;
+    return hits;
+}
+
+unsigned int bruteForceSphere(const std::vector<MovingObject>& objects, const glm::vec3& center, float radius)
+{
+    unsigned int hits = 0;
+    for (const MovingObject& object : objects)
+        hits += object.box().overlapsSphere(center, radius) ? 1 : 0;
+    return hits;
+}
+
+unsigned int bruteForceFrustum(const std::vector<MovingObject>& objects, const Frustum& frustum)
+{
+    unsigned int hits = 0;
+    for (const MovingObject& object : objects)
+        hits += object.box().isOnFrustum(frustum) ? 1 : 0;
+    return hits;
+}
+
+float bruteForceRay(const std::vector<MovingObject>& objects, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    const glm::vec3 invDirection = spatialInverseDirection(direction);
+    float nearest = maxDistance;
+    for (const MovingObject& object : objects)
+    {
+        float t;
+        if (object.box().intersectRay(origin, invDirection, nearest, t))
+            nearest = t;
+    }
+    return nearest;
+}
+
+void benchmarkSpatialIndex()
+{
+    const unsigned int objectCount = 100000;
+    const float worldHalfSize = 1000.0f;
+    const int frames = 30;
+    const int queryCount = 1000;
+    const int frustumCount = 20;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-worldHalfSize, worldHalfSize);
+    std::uniform_real_distribution<float> velocity(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> size(0.5f, 3.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<MovingObject> objects(objectCount);
+    for (MovingObject& object : objects)
+    {
+        object.position = glm::vec3(position(rng), position(rng), position(rng));
+        object.velocity = glm::vec3(velocity(rng), velocity(rng), velocity(rng));
+        object.extents = glm::vec3(size(rng), size(rng), size(rng));
+    }
+
+    SpatialHash hash(8.0f);
+    LooseOctree octree(glm::vec3(0.0f), worldHalfSize, 8);
+
+    Clock::time_point start = Clock::now();
+    for (unsigned int i = 0; i < objectCount; i++)
+        hash.insert(i, objects[i].box());
+    const double hashInsert = elapsedMs(start);
+
+    start = Clock::now();
+    for (unsigned int i = 0; i < objectCount; i++)
+        octree.insert(i, objects[i].box());
+    const double octreeInsert = elapsedMs(start);
+
+    // move everything at 60 fps, bouncing off the world bounds
+    double hashUpdate = 0.0, octreeUpdate = 0.0;
+    const float deltaTime = 1.0f / 60.0f;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (MovingObject& object : objects)
+        {
+            object.position += object.velocity * deltaTime;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (std::abs(object.position[axis]) > worldHalfSize)
+                    object.velocity[axis] = -object.velocity[axis];
+            }
+        }
+
+        start = Clock::now();
+        for (unsigned int i = 0; i < objectCount; i++)
+            hash.update(i, objects[i].box());
+        hashUpdate += elapsedMs(start);
+
+        start = Clock::now();
+        for (unsigned int i = 0; i < objectCount; i++)
+            octree.update(i, objects[i].box());
+        octreeUpdate += elapsedMs(start);
+    }
+
+    // queries, every result is checked against the brute force loop
+    std::vector<SpatialBox> ranges(queryCount);
+    std::vector<glm::vec4> spheres(queryCount);
+    std::vector<glm::vec3> rayOrigins(queryCount), rayDirections(queryCount);
+    for (int i = 0; i < queryCount; i++)
+    {
+        const glm::vec3 center(position(rng), position(rng), position(rng));
+        ranges[i] = SpatialBox(center - 25.0f, center + 25.0f);
+        spheres[i] = glm::vec4(position(rng), position(rng), position(rng), 25.0f);
+        rayOrigins[i] = glm::vec3(position(rng), position(rng), position(rng));
+        rayDirections[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 0.001f));
+    }
+    std::vector<Frustum> frustums;
+    for (int i = 0; i < frustumCount; i++)
+    {
+        Camera camera(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(0.0f, 1.0f, 0.0f), unit(rng) * 180.0f, unit(rng) * 60.0f);
+        frustums.push_back(createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 300.0f));
+    }
+    const float rayLength = 500.0f;
+
+    // brute force first, its results are the reference for both structures
+    std::vector<unsigned int> expected[4];
+    double bruteQuery[4] = {};
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+        expected[0].push_back(bruteForceRange(objects, ranges[i]));
+    bruteQuery[0] = elapsedMs(start);
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+        expected[1].push_back(bruteForceSphere(objects, glm::vec3(spheres[i]), spheres[i].w));
+    bruteQuery[1] = elapsedMs(start);
+    start = Clock::now();
+    for (int i = 0; i < frustumCount; i++)
+        expected[2].push_back(bruteForceFrustum(objects, frustums[i]));
+    bruteQuery[2] = elapsedMs(start);
+    std::vector<float> expectedRay;
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+        expectedRay.push_back(bruteForceRay(objects, rayOrigins[i], rayDirections[i], rayLength));
+    bruteQuery[3] = elapsedMs(start);
+
+    unsigned int mismatches = 0;
+    std::vector<unsigned int> result;
+    auto runQueries = [&](auto& index, double times[4]) {
+        start = Clock::now();
+        for (int i = 0; i < queryCount; i++)
+        {
+            result.clear();
+            index.queryRange(ranges[i], result);
+            mismatches += result.size() != expected[0][i] ? 1 : 0;
+        }
+        times[0] = elapsedMs(start);
+        start = Clock::now();
+        for (int i = 0; i < queryCount; i++)
+        {
+            result.clear();
+            index.querySphere(glm::vec3(spheres[i]), spheres[i].w, result);
+            mismatches += result.size() != expected[1][i] ? 1 : 0;
+        }
+        times[1] = elapsedMs(start);
+        start = Clock::now();
+        for (int i = 0; i < frustumCount; i++)
+        {
+            result.clear();
+            index.queryFrustum(frustums[i], result);
+            mismatches += result.size() != expected[2][i] ? 1 : 0;
+        }
+        times[2] = elapsedMs(start);
+        start = Clock::now();
+        for (int i = 0; i < queryCount; i++)
+        {
+            unsigned int hitId = 0;
+            float hitDistance = rayLength;
+            index.raycast(rayOrigins[i], rayDirections[i], rayLength, hitId, hitDistance);
+            mismatches += std::abs(hitDistance - expectedRay[i]) > 1e-3f ? 1 : 0;
+        }
+        times[3] = elapsedMs(start);
+    };
+    double hashQuery[4], octreeQuery[4];
+    runQueries(hash, hashQuery);
+    runQueries(octree, octreeQuery);
+
+    std::cout << "spatial index, " << objectCount << " moving objects, " << frames << " frames" << std::endl;
+    std::cout << "                  hash      octree    brute force" << std::endl;
+    std::cout << "insert (ms)       " << hashInsert << "  " << octreeInsert << std::endl;
+    std::cout << "update/frame (ms) " << hashUpdate / frames << "  " << octreeUpdate / frames << std::endl;
+    const char* queryNames[4] = { "range (us)       ", "sphere (us)      ", "frustum (us)     ", "ray (us)         " };
+    const int queryCounts[4] = { queryCount, queryCount, frustumCount, queryCount };
+    for (int q = 0; q < 4; q++)
+    {
+        std::cout << queryNames[q] << 1000.0 * hashQuery[q] / queryCounts[q] << "  " << 1000.0 * octreeQuery[q] / queryCounts[q]
+            << "  " << 1000.0 * bruteQuery[q] / queryCounts[q] << std::endl;
+    }
+    std::cout << "cells " << hash.getCellCount() << ", octree nodes " << octree.getNodeCount() << ", mismatches " << mismatches << std::endl;
+}
+
+// frustum culling: planes tested per object on a flythrough
+// ----------------------------------------------------------
+void benchmarkCulling()
+{
+    const unsigned int objectCount = 20000;
+    const float worldHalfSize = 800.0f;
+    const int frames = 1200;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-worldHalfSize, worldHalfSize);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::vector<AABB> boxes;
+    for (unsigned int i = 0; i < objectCount; i++)
+        boxes.push_back(AABB(glm::vec3(position(rng), position(rng) * 0.1f, position(rng)), size(rng), size(rng), size(rng)));
+
+    // 20 seconds at 60 fps: a slow circle around the scene with some bobbing and a look-around
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+    std::vector<glm::mat4> viewProjections;
+    std::vector<Frustum> cameraFrustums;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        const float t = frame / 60.0f;
+        const glm::vec3 eye(500.0f * std::sin(t * 0.1f), 20.0f + 10.0f * std::sin(t * 0.5f), 500.0f * std::cos(t * 0.1f));
+        const float yaw = glm::degrees(-t * 0.1f) + 180.0f + 20.0f * std::sin(t * 0.3f);
+        Camera camera(eye, glm::vec3(0.0f, 1.0f, 0.0f), yaw, 5.0f * std::sin(t * 0.2f));
+        viewProjections.push_back(projection * camera.GetViewMatrix());
+        cameraFrustums.push_back(createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 500.0f));
+    }
+
+    // before: entity.h, frustum rebuilt from the camera and all planes in a fixed order
+    Clock::time_point start = Clock::now();
+    unsigned long long visibleCount = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (unsigned int i = 0; i < objectCount; i++)
+            visibleCount += static_cast<const BoundingVolume&>(boxes[i]).isOnFrustum(cameraFrustums[frame]) ? 1 : 0;
+    }
+    const double entityTime = elapsedMs(start);
+
+    // reference visibility from the same matrix planes the context uses (the far plane extracted from the
+    // matrix differs from the camera one by a few hundredths, which flips a handful of boxes right on it)
+    std::vector<unsigned char> reference(objectCount * frames);
+    for (int frame = 0; frame < frames; frame++)
+    {
+        const Frustum frustum = createFrustumFromMatrix(viewProjections[frame]);
+        for (unsigned int i = 0; i < objectCount; i++)
+            reference[frame * objectCount + i] = static_cast<const BoundingVolume&>(boxes[i]).isOnFrustum(frustum) ? 1 : 0;
+    }
+
+    std::cout << "frustum culling, " << objectCount << " boxes, " << frames << " frames, " << visibleCount / frames << " visible per frame" << std::endl;
+    std::cout << "AABB::isOnFrustum:  " << entityTime / frames << " ms/frame" << std::endl;
+
+    const char* modeNames[3] = { "fixed order:        ", "plane coherence:    ", "+ temporal:         " };
+    for (int mode = 0; mode < 3; mode++)
+    {
+        CullingContext context;
+        context.planeCoherence = mode >= 1;
+        context.temporalCoherence = mode >= 2;
+        unsigned int mismatches = 0;
+
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            context.beginFrame(viewProjections[frame]);
+            for (unsigned int i = 0; i < objectCount; i++)
+            {
+                const bool visible = context.isVisible(i, boxes[i]);
+                // skipped objects are always reported visible, only a rejection of a visible object is an error
+                mismatches += (!visible && reference[frame * objectCount + i]) ? 1 : 0;
+            }
+        }
+        const double time = elapsedMs(start);
+
+        std::cout << modeNames[mode] << time / frames << " ms/frame, " << context.getPlanesPerObject() << " planes/object, "
+            << 100.0 * context.getObjectsSkipped() / context.getObjectsTested() << "% skipped, " << mismatches << " wrongly culled" << std::endl;
+    }
+}
+
+// keyframe sampling: long motion capture clips
+// --------------------------------------------
+// the Bone of the original tutorial: keys as array of structs, linear search from the first key
+struct LegacyBone
+{
+    std::vector<std::pair<float, glm::vec3>> positions, scales;
+    std::vector<std::pair<float, glm::quat>> rotations;
+    glm::mat4 localTransform;
+
+    template<typename T>
+    static int GetIndex(const std::vector<std::pair<float, T>>& keys, float animationTime)
+    {
+        for (int index = 0; index < static_cast<int>(keys.size()) - 1; ++index)
+        {
+            if (animationTime < keys[index + 1].first)
+                return index;
+        }
+        return static_cast<int>(keys.size()) - 2; // the original asserts here
+    }
+
+    template<typename T>
+    static T Interpolate(const std::vector<std::pair<float, T>>& keys, float animationTime)
+    {
+        const int p0 = GetIndex(keys, animationTime);
+        const float scaleFactor = (animationTime - keys[p0].first) / (keys[p0 + 1].first - keys[p0].first);
+        return InterpolateKey(keys[p0].second, keys[p0 + 1].second, scaleFactor);
+    }
+
+    void Update(float animationTime)
+    {
+        localTransform = glm::translate(glm::mat4(1.0f), Interpolate(positions, animationTime)) *
+            glm::toMat4(Interpolate(rotations, animationTime)) * glm::scale(glm::mat4(1.0f), Interpolate(scales, animationTime));
+    }
+};
+
+// a smooth random-ish motion, keyed at a fixed rate
+aiNodeAnim* createMotionCaptureChannel(unsigned int keyCount, float seconds, int bone)
+{
+    aiNodeAnim* channel = new aiNodeAnim();
+    channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keyCount;
+    channel->mPositionKeys = new aiVectorKey[keyCount];
+    channel->mRotationKeys = new aiQuatKey[keyCount];
+    channel->mScalingKeys = new aiVectorKey[keyCount];
+    for (unsigned int k = 0; k < keyCount; k++)
+    {
+        const double time = seconds * k / (keyCount - 1);
+        const float phase = static_cast<float>(time) + bone * 0.37f;
+        const glm::quat rotation = glm::quat(glm::vec3(std::sin(phase), std::cos(phase * 1.3f), std::sin(phase * 0.7f)));
+        channel->mPositionKeys[k] = aiVectorKey(time, aiVector3D(std::sin(phase), std::cos(phase * 0.5f), 0.1f * bone));
+        channel->mRotationKeys[k] = aiQuatKey(time, aiQuaternion(rotation.w, rotation.x, rotation.y, rotation.z));
+        channel->mScalingKeys[k] = aiVectorKey(time, aiVector3D(1.0f));
+    }
+    return channel;
+}
+
+void benchmarkKeyframes()
+{
+    const int boneCount = 60;
+    const float keyRate = 120.0f;
+    const float clipSeconds[3] = { 10.0f, 60.0f, 300.0f };
+
+    std::cout << "keyframe sampling, " << boneCount << " bones keyed at " << keyRate << " Hz, played at 60 fps (ns per bone update)" << std::endl;
+    std::cout << "clip      keys/track  linear scan  cursor   binary search (random seek)  max difference" << std::endl;
+    for (float seconds : clipSeconds)
+    {
+        const unsigned int keyCount = static_cast<unsigned int>(seconds * keyRate) + 1;
+        std::vector<Bone> bones;
+        std::vector<LegacyBone> legacyBones(boneCount);
+        for (int b = 0; b < boneCount; b++)
+        {
+            aiNodeAnim* channel = createMotionCaptureChannel(keyCount, seconds, b);
+            bones.push_back(Bone("bone", b, channel));
+            for (unsigned int k = 0; k < keyCount; k++)
+            {
+                legacyBones[b].positions.push_back({ static_cast<float>(channel->mPositionKeys[k].mTime), AssimpGLMHelpers::GetGLMVec(channel->mPositionKeys[k].mValue) });
+                legacyBones[b].rotations.push_back({ static_cast<float>(channel->mRotationKeys[k].mTime), AssimpGLMHelpers::GetGLMQuat(channel->mRotationKeys[k].mValue) });
+                legacyBones[b].scales.push_back({ static_cast<float>(channel->mScalingKeys[k].mTime), AssimpGLMHelpers::GetGLMVec(channel->mScalingKeys[k].mValue) });
+            }
+            delete channel;
+        }
+
+        // the whole clip for the cursor, a spread out subset of the same frames for the (stateless) linear scan
+        const int frames = static_cast<int>(seconds * 60.0f);
+        const int legacyStride = std::max(1, frames / 600);
+        std::vector<float> seekTimes(frames);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> anyTime(0.0f, seconds);
+        for (float& t : seekTimes)
+            t = anyTime(rng);
+
+        Clock::time_point start = Clock::now();
+        float checksum = 0.0f;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (Bone& bone : bones)
+            {
+                bone.Update(frame / 60.0f);
+                checksum += bone.GetLocalTransform()[3][0];
+            }
+        }
+        const double cursorNs = elapsedMs(start) * 1e6 / (frames * boneCount);
+
+        float maxDifference = 0.0f;
+        int legacyFrames = 0;
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame += legacyStride, legacyFrames++)
+        {
+            for (LegacyBone& bone : legacyBones)
+            {
+                bone.Update(frame / 60.0f);
+                checksum += bone.localTransform[3][0];
+            }
+        }
+        const double legacyNs = elapsedMs(start) * 1e6 / (legacyFrames * boneCount);
+
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (Bone& bone : bones)
+            {
+                bone.Update(seekTimes[frame]);
+                checksum += bone.GetLocalTransform()[3][0];
+            }
+        }
+        const double seekNs = elapsedMs(start) * 1e6 / (frames * boneCount);
+
+        // both give the same pose (checked outside the timed loops)
+        for (int frame = 0; frame < frames; frame += legacyStride)
+        {
+            for (int b = 0; b < boneCount; b++)
+            {
+                bones[b].Update(frame / 60.0f);
+                legacyBones[b].Update(frame / 60.0f);
+                const glm::mat4 difference = bones[b].GetLocalTransform() - legacyBones[b].localTransform;
+                for (int c = 0; c < 4; c++)
+                    maxDifference = std::max(maxDifference, glm::length(difference[c]));
+            }
+        }
+
+        benchmarkSink = checksum;
+        std::cout << seconds << " s     " << keyCount << "        " << legacyNs << "     " << cursorNs << "  " << seekNs
+            << "                      " << maxDifference << std::endl;
+    }
+}
+
+// light assignment to view space clusters (the CPU reference of light_cluster.cs): every cluster tested against
+// every light versus assignLightsToClusters, which only tests the depth slices a light reaches
+// -------------------------------------------------------------------------------------------------------------
+void benchmarkLightClusters()
+{
+    const unsigned int lightCounts[6] = { 256, 1024, 2048, 4096, 8192, 16384 };
+    const unsigned int maxLightsPerCluster = 1024;
+    const int frames = 10;
+
+    ClusterGrid grid;
+    grid.zNear = 0.1f;
+    grid.zFar = 100.0f;
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, grid.zNear, grid.zFar);
+    const glm::mat4 view = Camera(glm::vec3(0.0f, 4.0f, 16.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -15.0f).GetViewMatrix();
+    const glm::mat4 inverseProjection = glm::inverse(projection);
+    std::vector<glm::vec3> boundsMin(grid.clusterCount()), boundsMax(grid.clusterCount());
+    for (unsigned int cluster = 0; cluster < grid.clusterCount(); cluster++)
+    {
+        const unsigned int tile = cluster % (CLUSTER_TILES_X * CLUSTER_TILES_Y);
+        grid.clusterBounds(tile % CLUSTER_TILES_X, tile / CLUSTER_TILES_X, cluster / (CLUSTER_TILES_X * CLUSTER_TILES_Y), inverseProjection, boundsMin[cluster], boundsMax[cluster]);
+    }
+
+    std::cout << "clustered light assignment, " << CLUSTER_TILES_X << "x" << CLUSTER_TILES_Y << "x" << CLUSTER_SLICES << " clusters, lights on a 40 x 40 floor (ms per assignment)" << std::endl;
+    std::cout << "lights  every cluster x light  slice range  lights/cluster avg/max  mismatches" << std::endl;
+    for (unsigned int lightCount : lightCounts)
+    {
+        // same layout as 5-advanced-lighting/41.deferred-shading
+        std::mt19937 rng(13);
+        std::uniform_real_distribution<float> floor(-20.0f, 20.0f), height(-1.0f, 0.5f), color(0.5f, 1.0f);
+        std::vector<PointLight> lights(lightCount);
+        for (PointLight& light : lights)
+        {
+            light.position = glm::vec3(floor(rng), height(rng), floor(rng));
+            light.color = glm::vec3(color(rng), color(rng), color(rng));
+            light.linear = 0.7f;
+            light.quadratic = 40.0f;
+            light.radius = pointLightRadius(light.color, light.linear, light.quadratic);
+        }
+
+        std::vector<unsigned int> bruteCounts(grid.clusterCount()), bruteIndices(static_cast<size_t>(grid.clusterCount()) * maxLightsPerCluster);
+        std::vector<glm::vec3> centers(lightCount);
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (unsigned int i = 0; i < lightCount; i++)
+                centers[i] = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+            std::fill(bruteCounts.begin(), bruteCounts.end(), 0);
+            for (unsigned int cluster = 0; cluster < grid.clusterCount(); cluster++)
+            {
+                for (unsigned int i = 0; i < lightCount; i++)
+                {
+                    if (!sphereOverlapsBox(centers[i], lights[i].radius, boundsMin[cluster], boundsMax[cluster]))
+                        continue;
+                    if (bruteCounts[cluster] < maxLightsPerCluster)
+                        bruteIndices[static_cast<size_t>(cluster) * maxLightsPerCluster + bruteCounts[cluster]] = i;
+                    bruteCounts[cluster]++;
+                }
+            }
+        }
+        const double bruteMs = elapsedMs(start) / frames;
+
+        std::vector<unsigned int> counts, indices;
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+            assignLightsToClusters(grid, projection, view, lights, maxLightsPerCluster, counts, indices);
+        const double assignMs = elapsedMs(start) / frames;
+
+        unsigned int mismatches = 0, maxCount = 0;
+        size_t total = 0;
+        for (unsigned int cluster = 0; cluster < grid.clusterCount(); cluster++)
+        {
+            const size_t first = static_cast<size_t>(cluster) * maxLightsPerCluster;
+            const bool same = counts[cluster] == bruteCounts[cluster]
+                && std::equal(&indices[first], &indices[first] + std::min(counts[cluster], maxLightsPerCluster), &bruteIndices[first]);
+            mismatches += same ? 0 : 1;
+            maxCount = std::max(maxCount, counts[cluster]);
+            total += counts[cluster];
+        }
+        std::cout << lightCount << "    " << bruteMs << "                 " << assignMs << "      "
+            << static_cast<double>(total) / grid.clusterCount() << " / " << maxCount << "            " << mismatches << std::endl;
+    }
+}
+
+// CPU occlusion rasterizer: a fixed scene with known results, then the SSE path against the scalar one
+// -----------------------------------------------------------------------------------------------------
+struct OcclusionCase
+{
+    const char* name;
+    AABB box;
+    bool visible; // expected: inside the frustum and not hidden behind the wall
+};
+
+void benchmarkOcclusion()
+{
+    // a 6 x 4 wall 10 units in front of the camera, the rest of the scene around and behind it
+    Camera camera(glm::vec3(0.0f, 1.0f, 10.0f));
+    const float aspect = 4.0f / 3.0f;
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f) * camera.GetViewMatrix();
+    const Frustum frustum = createFrustumFromCamera(camera, aspect, glm::radians(45.0f), 0.1f, 100.0f);
+    const AABB wall(glm::vec3(-3.0f, 0.0f, -1.0f), glm::vec3(3.0f, 4.0f, 0.0f));
+    const OcclusionCase cases[] = {
+        { "in front of the wall", AABB(glm::vec3(0.0f, 1.0f, 4.0f), 0.5f, 0.5f, 0.5f), true },
+        { "beside the wall", AABB(glm::vec3(6.0f, 2.0f, -4.0f), 1.0f, 1.0f, 1.0f), true },
+        { "peeking over the wall", AABB(glm::vec3(0.0f, 6.0f, -5.0f), 1.0f, 1.0f, 1.0f), true },
+        { "behind the wall", AABB(glm::vec3(0.0f, 1.0f, -6.0f), 1.0f, 1.0f, 1.0f), false },
+        { "behind the wall, left", AABB(glm::vec3(-2.0f, 2.0f, -3.0f), 0.5f, 0.5f, 0.5f), false },
+        { "outside the frustum", AABB(glm::vec3(30.0f, 1.0f, -5.0f), 1.0f, 1.0f, 1.0f), false },
+    };
+
+    std::cout << "fixed scene, 200 x 150 depth buffer: ";
+    JobSystem serialJobs(1);
+    JobSystem jobs(std::max(4u, std::thread::hardware_concurrency())); // at least 4 shares of triangles, even on small machines
+    unsigned int failures = 0;
+    for (JobSystem* jobSystem : { &serialJobs, &jobs })
+    {
+        for (int simd = 0; simd < 2; simd++)
+        {
+            OcclusionRasterizer rasterizer(200, 150, *jobSystem);
+            rasterizer.simd = simd == 1;
+            rasterizer.beginFrame(viewProjection);
+            rasterizer.addOccluder(wall);
+            rasterizer.rasterize();
+            for (const OcclusionCase& test : cases)
+            {
+                const bool visible = static_cast<const BoundingVolume&>(test.box).isOnFrustum(frustum) && rasterizer.isVisible(test.box);
+                if (visible != test.visible)
+                {
+                    std::cout << std::endl << "  FAILED: " << test.name << " is " << (visible ? "visible" : "culled") << " with " << jobSystem->getThreadCount()
+                        << " threads, " << (simd ? "SSE" : "scalar");
+                    failures++;
+                }
+            }
+        }
+    }
+    std::cout << (failures ? "" : "every case as expected") << std::endl;
+
+    // random walls and boxes behind them: depth buffer and visibility of the scalar code against SSE, single
+    // threaded and on all threads
+    const int frames = 200;
+    const unsigned int width = 256, height = 128;
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.0f, 3.0f), glm::vec3(0.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+    std::vector<AABB> occluders, objects;
+    for (int i = 0; i < 60; i++)
+    {
+        const glm::vec3 center(position(rng), position(rng) * 0.3f + 1.0f, position(rng) * 2.0f - 12.0f);
+        occluders.push_back(AABB(center - glm::vec3(1.0f, 1.0f, 0.2f), center + glm::vec3(1.0f, 1.0f, 0.2f)));
+    }
+    for (int i = 0; i < 2000; i++)
+    {
+        const glm::vec3 center(position(rng), position(rng) * 0.3f + 1.0f, position(rng) * 3.0f - 20.0f);
+        objects.push_back(AABB(center - glm::vec3(0.2f), center + glm::vec3(0.2f)));
+    }
+
+    std::cout << occluders.size() << " box occluders, " << objects.size() << " objects, " << width << " x " << height << " depth buffer" << std::endl;
+    std::cout << "path    threads  rasterize (ms)  test (ms)  visible  depth mismatches vs scalar  visibility mismatches vs scalar" << std::endl;
+    std::vector<float> scalarDepth;
+    std::vector<unsigned char> scalarVisible;
+    for (JobSystem* jobSystem : { &serialJobs, &jobs })
+    {
+        for (int simd = 0; simd < 2; simd++)
+        {
+            OcclusionRasterizer rasterizer(width, height, *jobSystem);
+            rasterizer.simd = simd == 1;
+            Clock::time_point start = Clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                rasterizer.beginFrame(projection * view);
+                for (const AABB& occluder : occluders)
+                    rasterizer.addOccluder(occluder);
+                rasterizer.rasterize();
+            }
+            const double rasterizeMs = elapsedMs(start) / frames;
+
+            std::vector<unsigned char> visible(objects.size());
+            start = Clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                for (size_t i = 0; i < objects.size(); i++)
+                    visible[i] = rasterizer.isVisible(objects[i]) ? 1 : 0;
+            }
+            const double testMs = elapsedMs(start) / frames;
+
+            std::vector<float> depth;
+            for (unsigned int y = 0; y < height; y++)
+            {
+                for (unsigned int x = 0; x < width; x++)
+                    depth.push_back(rasterizer.getDepth(x, y));
+            }
+            if (scalarDepth.empty())
+            {
+                scalarDepth = depth;
+                scalarVisible = visible;
+            }
+            unsigned int depthMismatches = 0, visibleMismatches = 0, visibleCount = 0;
+            for (size_t i = 0; i < depth.size(); i++)
+                depthMismatches += depth[i] != scalarDepth[i] ? 1 : 0;
+            for (size_t i = 0; i < visible.size(); i++)
+            {
+                visibleMismatches += visible[i] != scalarVisible[i] ? 1 : 0;
+                visibleCount += visible[i];
+            }
+            std::cout << (simd ? "SSE     " : "scalar  ") << jobSystem->getThreadCount() << "        " << rasterizeMs << "        " << testMs << "   "
+                << visibleCount << "      " << depthMismatches << "                           " << visibleMismatches << std::endl;
+        }
+    }
+}
+
+// benchmark table
+// ---------------
+struct Benchmark
+{
+    const char* name;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    { "spatial", benchmarkSpatialIndex },
+    { "culling", benchmarkCulling },
+    { "keyframes", benchmarkKeyframes },
+    { "clusters", benchmarkLightClusters },
+    { "occlusion", benchmarkOcclusion },
+};
+
+int main(int argc, char** argv)
+{
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            selected = selected || std::strcmp(argv[i], benchmark.name) == 0;
+        if (!selected)
+            continue;
+
+        std::cout << "== " << benchmark.name << " ==" << std::endl;
+        benchmark.run();
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,608 @@
+// CPU benchmarks of the skeletal animation headers with the vampire rig.
+// a hidden window is created because loading the model uploads its meshes and textures.
+// usage: animation-benchmarks [name...]   (runs every benchmark when no name is given)
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/animation_clip.h>
+#include <learnopengl/animator.h>
+#include <learnopengl/crowd_animator.h>
+#include <learnopengl/model_animation.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// timing helpers
+// --------------
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+float maxMatrixDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++)
+    {
+        for (int c = 0; c < 4; c++)
+            difference = std::max(difference, glm::length(a[i][c] - b[i][c]));
+    }
+    return difference;
+}
+
+// animator: compiled node array vs the recursive tutorial version
+// ----------------------------------------------------------------
+// CalculateBoneTransform of the original tutorial: recursion over the node tree, a linear search for the
+// bone track and a copy of the bone info map at every node
+class LegacyAnimator
+{
+public:
+    std::vector<glm::mat4> finalBoneMatrices;
+
+    LegacyAnimator(Animation* animation) : finalBoneMatrices(100, glm::mat4(1.0f)), animation(animation) {}
+
+    void UpdateAnimation(float dt)
+    {
+        currentTime += animation->GetTicksPerSecond() * dt;
+        currentTime = fmod(currentTime, animation->GetDuration());
+        CalculateBoneTransform(&animation->GetRootNode(), glm::mat4(1.0f));
+    }
+
+private:
+    Animation* animation;
+    float currentTime = 0.0f;
+
+    Bone* FindBone(const std::string& name)
+    {
+        auto& bones = animation->GetBones();
+        auto iter = std::find_if(bones.begin(), bones.end(), [&](const Bone& bone) { return bone.GetBoneName() == name; });
+        return iter == bones.end() ? nullptr : &(*iter);
+    }
+
+    void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+    {
+        std::string nodeName = node->name;
+        glm::mat4 nodeTransform = node->transformation;
+
+        Bone* bone = FindBone(nodeName);
+        if (bone)
+        {
+            bone->Update(currentTime);
+            nodeTransform = bone->GetLocalTransform();
+        }
+
+        glm::mat4 globalTransformation = parentTransform * nodeTransform;
+
+        auto boneInfoMap = animation->GetBoneIDMap();
+        if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+        {
+            int index = boneInfoMap[nodeName].id;
+            glm::mat4 offset = boneInfoMap[nodeName].offset;
+            finalBoneMatrices[index] = globalTransformation * offset;
+        }
+
+        for (int i = 0; i < node->childrenCount; i++)
+            CalculateBoneTransform(&node->children[i], globalTransformation);
+    }
+};
+
+void benchmarkAnimator(Animation& animation)
+{
+    const int updates = 20000;
+    const float deltaTime = 1.0f / 60.0f;
+
+    LegacyAnimator legacy(&animation);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        legacy.UpdateAnimation(deltaTime);
+    const double legacyUs = elapsedMs(start) * 1000.0 / updates;
+
+    Animator animator(&animation);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        animator.UpdateAnimation(deltaTime);
+    const double compiledUs = elapsedMs(start) * 1000.0 / updates;
+
+    std::cout << "animator, " << animation.GetNodes().size() << " nodes, " << animation.GetBones().size() << " tracks, " << updates << " updates" << std::endl;
+    std::cout << "recursive + map copies:  " << legacyUs << " us/update" << std::endl;
+    std::cout << "compiled nodes:          " << compiledUs << " us/update" << std::endl;
+    std::cout << "max difference           " << maxMatrixDifference(legacy.finalBoneMatrices, animator.GetFinalBoneMatrices()) << std::endl;
+}
+
+// crowd: thousands of animators into one palette buffer
+// -----------------------------------------------------
+void benchmarkCrowd(Animation& animation)
+{
+    const unsigned int crowdSizes[3] = { 1000, 5000, 10000 };
+    const int updates = 20;
+    const float deltaTime = 1.0f / 60.0f;
+    const size_t stride = animation.GetBoneMatrixCount();
+    JobSystem serialJobs(1);
+    JobSystem jobs;
+
+    std::cout << "crowd, " << animation.GetBoneMatrixCount() << " bone matrices per instance, " << jobs.getThreadCount() << " threads (ms per update)" << std::endl;
+    std::cout << "instances  separate animators + copy  crowd, 1 thread  crowd, " << jobs.getThreadCount() << " threads  palette (MB)" << std::endl;
+    for (unsigned int instanceCount : crowdSizes)
+    {
+        // before: one Animator per character, every palette copied into the upload buffer
+        std::vector<Animator> animators(instanceCount, Animator(&animation));
+        std::vector<glm::mat4> uploadBuffer(instanceCount * stride);
+        for (unsigned int i = 0; i < instanceCount; i++)
+            animators[i].SetCurrentTime(i * 7.0f);
+        Clock::time_point start = Clock::now();
+        for (int update = 0; update < updates; update++)
+        {
+            for (unsigned int i = 0; i < instanceCount; i++)
+            {
+                animators[i].UpdateAnimation(deltaTime);
+                std::vector<glm::mat4> transforms = animators[i].GetFinalBoneMatrices();
+                std::copy(transforms.begin(), transforms.begin() + stride, uploadBuffer.begin() + i * stride);
+            }
+        }
+        const double separateMs = elapsedMs(start) / updates;
+
+        double crowdMs[2];
+        float difference = 0.0f;
+        for (int run = 0; run < 2; run++)
+        {
+            CrowdAnimator crowd(&animation, instanceCount, run == 0 ? serialJobs : jobs);
+            for (unsigned int i = 0; i < instanceCount; i++)
+                crowd.GetAnimator(i).SetCurrentTime(i * 7.0f);
+            start = Clock::now();
+            for (int update = 0; update < updates; update++)
+                crowd.UpdateAnimation(deltaTime);
+            crowdMs[run] = elapsedMs(start) / updates;
+
+            // same poses as the separate animators
+            for (unsigned int i = 0; i < instanceCount; i++)
+            {
+                for (unsigned int b = 0; b < crowd.GetPaletteStride(); b++)
+                {
+                    for (int c = 0; c < 4; c++)
+                        difference = std::max(difference, glm::length(crowd.GetInstancePalette(i)[b][c] - uploadBuffer[i * stride + b][c]));
+                }
+            }
+            if (run == 1)
+                std::cout << instanceCount << "       " << separateMs << "                      " << crowdMs[0] << "          " << crowdMs[1]
+                    << "          " << crowd.GetPaletteSizeInBytes() / (1024.0 * 1024.0) << "  (max difference " << difference << ")" << std::endl;
+        }
+    }
+}
+
+// blend: cross-fades, N-way blends and layers against a single clip
+// -------------------------------------------------------------------
+void benchmarkBlend(Animation& animation)
+{
+    const int updates = 20000;
+    const float deltaTime = 1.0f / 60.0f;
+    // copies of the dance stand in for different clips of the same skeleton. blending a clip with itself has
+    // to give the clip back, which checks the blend math along the way.
+    std::vector<Animation> clips(4, animation);
+
+    Animator single(&animation);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        single.UpdateAnimation(deltaTime);
+    const double singleUs = elapsedMs(start) * 1000.0 / updates;
+
+    // the same clip through the blend path, the baseline of the blend ratios: the single clip above goes from the
+    // keys straight to matrices, here a second clip at weight 0 keeps the animator blending BonePoses
+    Animator singlePose(&clips[0]);
+    singlePose.AddClip(&clips[1], 0.0f);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        singlePose.UpdateAnimation(deltaTime);
+    const double singlePoseUs = elapsedMs(start) * 1000.0 / updates;
+
+    Animator crossFade(&clips[0]);
+    crossFade.CrossFade(&clips[1], 1.0e6f); // stays mid fade for the whole run
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        crossFade.UpdateAnimation(deltaTime);
+    const double crossFadeUs = elapsedMs(start) * 1000.0 / updates;
+
+    Animator blend(&clips[0]);
+    for (int c = 1; c < 4; c++)
+        blend.AddClip(&clips[c], 1.0f);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        blend.UpdateAnimation(deltaTime);
+    const double blendUs = elapsedMs(start) * 1000.0 / updates;
+
+    // additive layer of the clip over itself: adds its motion since the first frame a second time
+    Animator layered(&clips[0]);
+    for (int c = 1; c < 4; c++)
+        layered.AddClip(&clips[c], 1.0f);
+    layered.AddLayer(&animation, 0.5f, true, layered.CreateBoneMask(animation.GetNodeName(0)));
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        layered.UpdateAnimation(deltaTime);
+    const double layeredUs = elapsedMs(start) * 1000.0 / updates;
+
+    std::cout << "blend, " << animation.GetNodes().size() << " nodes, " << animation.GetBones().size() << " tracks, " << updates << " updates" << std::endl;
+    std::cout << "single clip:                   " << singleUs << " us/update" << std::endl;
+    std::cout << "single clip, blend path:       " << singlePoseUs << " us/update (" << singlePoseUs / singleUs << "x, max difference "
+        << maxMatrixDifference(single.GetFinalBoneMatrices(), singlePose.GetFinalBoneMatrices()) << ")" << std::endl;
+    std::cout << "ratios against the single clip, direct / blend path:" << std::endl;
+    std::cout << "cross-fade, 2 clips:           " << crossFadeUs << " us/update (" << crossFadeUs / singleUs << "x / " << crossFadeUs / singlePoseUs
+        << "x, max difference " << maxMatrixDifference(single.GetFinalBoneMatrices(), crossFade.GetFinalBoneMatrices()) << ")" << std::endl;
+    std::cout << "4-way blend:                   " << blendUs << " us/update (" << blendUs / singleUs << "x / " << blendUs / singlePoseUs
+        << "x, max difference " << maxMatrixDifference(single.GetFinalBoneMatrices(), blend.GetFinalBoneMatrices()) << ")" << std::endl;
+    std::cout << "4-way blend + additive layer:  " << layeredUs << " us/update (" << layeredUs / singleUs << "x / " << layeredUs / singlePoseUs << "x)" << std::endl;
+}
+
+// clip: baked clips (reduced/resampled, quantized, memory mapped) against the imported keys
+// ------------------------------------------------------------------------------------------
+void benchmarkClip(Model& model, Animation& animation)
+{
+    const int updates = 20000;
+    const float deltaTime = 1.0f / 60.0f;
+    const char* path = "../../resources/objects/vampire/dancing_vampire.dae";
+
+    Clock::time_point start = Clock::now();
+    Animation imported(path, &model);
+    const double importMs = elapsedMs(start);
+
+    Animator source(&animation);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        source.UpdateAnimation(deltaTime);
+    const double sourceUs = elapsedMs(start) * 1000.0 / updates;
+
+    std::cout << "clip, " << animation.GetBones().size() << " tracks, " << animation.GetDuration() / animation.GetTicksPerSecond() << " s, Assimp import " << importMs << " ms, "
+        << "update " << sourceUs << " us" << std::endl;
+
+    ClipBakeSettings keyed;
+    ClipBakeSettings uniform;
+    uniform.sampleRate = 30.0f;
+    const ClipBakeSettings* variants[2] = { &keyed, &uniform };
+    const char* names[2] = { "reduced keys", "uniform 30 Hz" };
+    const char* files[2] = { "dancing_vampire_keyed.clip", "dancing_vampire_uniform.clip" };
+    for (int v = 0; v < 2; v++)
+    {
+        ClipBakeReport report;
+        if (!BakeAnimationClip(animation, files[v], *variants[v], &report))
+            continue;
+
+        start = Clock::now();
+        AnimationClipFile file(files[v]);
+        if (!file.IsOpen())
+            continue;
+        Animation baked = file.CreateAnimation(animation.GetSkeleton());
+        const double loadMs = elapsedMs(start);
+
+        Animator animator(&baked);
+        start = Clock::now();
+        for (int i = 0; i < updates; i++)
+            animator.UpdateAnimation(deltaTime);
+        const double bakedUs = elapsedMs(start) * 1000.0 / updates;
+
+        // bone matrices over the whole clip, the error as the skin sees it
+        float paletteError = 0.0f;
+        for (int i = 0; i < 500; i++)
+        {
+            const float time = animation.GetDuration() * i / 500.0f;
+            source.SetCurrentTime(time);
+            animator.SetCurrentTime(time);
+            source.CalculateBoneTransforms();
+            animator.CalculateBoneTransforms();
+            paletteError = std::max(paletteError, maxMatrixDifference(source.GetFinalBoneMatrices(), animator.GetFinalBoneMatrices()));
+        }
+
+        std::cout << names[v] << ": " << report.sourceKeys << " -> " << report.bakedKeys << " keys, " << report.sourceKeyBytes << " -> " << report.bakedKeyBytes
+            << " key bytes (" << static_cast<double>(report.sourceKeyBytes) / report.bakedKeyBytes << ":1), file " << report.fileBytes << " bytes" << std::endl;
+        std::cout << "    max error: position " << report.maxPositionError << ", rotation " << report.maxRotationError << " rad, scale " << report.maxScaleError
+            << ", bone matrices " << paletteError << std::endl;
+        std::cout << "    mapped load " << loadMs << " ms, update " << bakedUs << " us" << std::endl;
+    }
+}
+
+// skinning: packed bone data and dual quaternion palettes against linear blend skinning
+// -------------------------------------------------------------------------------------
+glm::vec3 skinLinear(const Vertex& vertex, const glm::mat4* palette)
+{
+    glm::mat4 transform(0.0f);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        transform += palette[vertex.m_BoneIDs[i]] * GetBoneWeight(vertex, i);
+    return glm::vec3(transform * glm::vec4(vertex.Position, 1.0f));
+}
+
+// same math as anim_model_dq.vs of 53.dual-quaternion-skinning
+glm::vec3 skinDualQuaternion(const Vertex& vertex, const glm::mat2x4* dualQuats)
+{
+    const glm::vec4 pivot = dualQuats[vertex.m_BoneIDs[0]][0];
+    glm::mat2x4 blended(0.0f);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        const glm::mat2x4& dq = dualQuats[vertex.m_BoneIDs[i]];
+        blended += dq * (glm::dot(dq[0], pivot) < 0.0f ? -GetBoneWeight(vertex, i) : GetBoneWeight(vertex, i));
+    }
+    const float length = glm::length(blended[0]);
+    const glm::vec4 real = blended[0] / length;
+    const glm::vec4 dual = blended[1] / length;
+    const glm::vec3 axis(real);
+    const glm::vec3 rotated = vertex.Position + 2.0f * glm::cross(axis, glm::cross(axis, vertex.Position) + real.w * vertex.Position);
+    return rotated + 2.0f * (real.w * glm::vec3(dual) - dual.w * axis + glm::cross(axis, glm::vec3(dual)));
+}
+
+void benchmarkSkinning(Model& model, Animation& animation)
+{
+    const int updates = 20000;
+    const float deltaTime = 1.0f / 60.0f;
+
+    // what the packed bone data and the dual quaternion palette save
+    size_t vertexCount = 0;
+    for (const Mesh& mesh : model.meshes)
+        vertexCount += mesh.vertices.size();
+    const size_t unpackedVertex = sizeof(Vertex) - sizeof(Vertex::m_BoneIDs) - sizeof(Vertex::m_Weights) + MAX_BONE_INFLUENCE * (sizeof(int) + sizeof(float));
+    const int boneCount = animation.GetBoneMatrixCount();
+    std::cout << "skinning, " << vertexCount << " vertices, " << boneCount << " bones" << std::endl;
+    std::cout << "vertex:                 " << unpackedVertex << " -> " << sizeof(Vertex) << " bytes (" << vertexCount * unpackedVertex / 1024 << " -> "
+        << vertexCount * sizeof(Vertex) / 1024 << " KB)" << std::endl;
+    std::cout << "palette per frame:      " << boneCount * sizeof(glm::mat4) << " -> " << boneCount * sizeof(glm::mat2x4) << " bytes" << std::endl;
+
+    Animator matrices(&animation);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        matrices.UpdateAnimation(deltaTime);
+    const double matrixUs = elapsedMs(start) * 1000.0 / updates;
+    Animator dualQuaternions(&animation);
+    dualQuaternions.SetDualQuaternionSkinning(true);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++)
+        dualQuaternions.UpdateAnimation(deltaTime);
+    const double dualQuaternionUs = elapsedMs(start) * 1000.0 / updates;
+    std::cout << "update:                 " << matrixUs << " us, " << dualQuaternionUs << " us with dual quaternions" << std::endl;
+
+    // dual quaternions drop scale, for a rig without scale both skinnings agree away from twisted joints
+    float maxScale = 0.0f;
+    float maxDifference = 0.0f;
+    for (int frame = 0; frame < 50; frame++)
+    {
+        dualQuaternions.SetCurrentTime(animation.GetDuration() * frame / 50.0f);
+        dualQuaternions.CalculateBoneTransforms();
+        const std::vector<glm::mat4>& palette = dualQuaternions.GetFinalBoneMatrices();
+        for (int bone = 0; bone < boneCount; bone++)
+        {
+            for (int c = 0; c < 3; c++)
+                maxScale = std::max(maxScale, std::abs(glm::length(glm::vec3(palette[bone][c])) - 1.0f));
+        }
+        for (const Mesh& mesh : model.meshes)
+        {
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                if (vertex.m_Weights[0] == 0)
+                    continue;
+                const glm::vec3 linear = skinLinear(vertex, palette.data());
+                const glm::vec3 dual = skinDualQuaternion(vertex, dualQuaternions.GetFinalDualQuaternions().data());
+                maxDifference = std::max(maxDifference, glm::length(linear - dual));
+            }
+        }
+    }
+    std::cout << "palette scale:          max |scale - 1| " << maxScale << std::endl;
+    std::cout << "linear vs dual quat:    max vertex difference " << maxDifference << " over 50 frames" << std::endl;
+
+    // candy wrapper: a ring of radius 1 around a joint between two bones along x, half weight each, while the
+    // second bone twists about x. linear blending shrinks the ring to cos(angle / 2).
+    const float angles[3] = { 90.0f, 135.0f, 170.0f };
+    for (float angle : angles)
+    {
+        const glm::mat4 palette[2] = { glm::mat4(1.0f), glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(1.0f, 0.0f, 0.0f)) };
+        const glm::mat2x4 dualQuats[2] = { MatrixToDualQuaternion(palette[0]), MatrixToDualQuaternion(palette[1]) };
+        Vertex vertex = {};
+        vertex.m_BoneIDs[1] = 1;
+        vertex.m_Weights[0] = static_cast<BoneWeight>(MAX_BONE_WEIGHT - MAX_BONE_WEIGHT / 2);
+        vertex.m_Weights[1] = static_cast<BoneWeight>(MAX_BONE_WEIGHT / 2);
+        float linearRadius = 0.0f, dualRadius = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            const float around = glm::two_pi<float>() * i / 16.0f;
+            vertex.Position = glm::vec3(0.0f, std::cos(around), std::sin(around));
+            const glm::vec3 linear = skinLinear(vertex, palette);
+            const glm::vec3 dual = skinDualQuaternion(vertex, dualQuats);
+            linearRadius += glm::length(glm::vec2(linear.y, linear.z)) / 16.0f;
+            dualRadius += glm::length(glm::vec2(dual.y, dual.z)) / 16.0f;
+        }
+        std::cout << "twist " << angle << " deg:          joint radius " << linearRadius << " linear, " << dualRadius << " dual quaternion" << std::endl;
+    }
+}
+
+// fixedrate: skeletons evaluated at fixed rates (by distance) and interpolated at a 240 Hz frame rate
+// ---------------------------------------------------------------------------------------------------
+void benchmarkFixedRate(Animation& animation)
+{
+    const unsigned int instanceCount = 1000;
+    const unsigned int columns = 40;
+    const int frames = 240;
+    const float deltaTime = 1.0f / 240.0f;
+    JobSystem jobs;
+
+    // a grid in front of the camera, 1.5 apart
+    std::vector<glm::vec3> positions(instanceCount);
+    for (unsigned int i = 0; i < instanceCount; i++)
+        positions[i] = glm::vec3((static_cast<float>(i % columns) - columns * 0.5f) * 1.5f, 0.0f, -static_cast<float>(i / columns) * 1.5f);
+    const glm::vec3 cameraPosition(0.0f, 2.0f, 5.0f);
+
+    struct Setup
+    {
+        const char* name;
+        std::vector<AnimationLod> lods;
+    };
+    const Setup setups[4] = {
+        { "every frame (240 Hz)", { { 0.0f, 0.0f } } },
+        { "60 Hz", { { 0.0f, 60.0f } } },
+        { "30 Hz", { { 0.0f, 30.0f } } },
+        { "60/30/10 Hz by distance", { { 10.0f, 60.0f }, { 25.0f, 30.0f }, { 0.0f, 10.0f } } },
+    };
+
+    std::cout << "fixedrate, " << instanceCount << " instances, " << frames << " frames at 240 Hz, " << jobs.getThreadCount() << " threads" << std::endl;
+    for (const Setup& setup : setups)
+    {
+        CrowdAnimator crowd(&animation, instanceCount, jobs);
+        for (unsigned int i = 0; i < instanceCount; i++)
+            crowd.GetAnimator(i).SetCurrentTime(i * 7.0f);
+        crowd.SetUpdateRates(cameraPosition, positions.data(), setup.lods);
+
+        size_t evaluated = 0;
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            crowd.UpdateAnimation(deltaTime);
+            evaluated += crowd.GetEvaluatedCount();
+        }
+        const double frameMs = elapsedMs(start) / frames;
+        std::cout << setup.name << ": " << frameMs << " ms/frame, " << static_cast<double>(evaluated) / frames << " evaluated + "
+            << instanceCount - static_cast<double>(evaluated) / frames << " interpolated skeletons per frame" << std::endl;
+    }
+
+    // interpolation error: the palette of a fixed rate animator against evaluating every frame at the time it
+    // shows (one step behind)
+    const float rates[2] = { 60.0f, 30.0f };
+    for (float rate : rates)
+    {
+        Animator fixedRate(&animation);
+        fixedRate.SetUpdateRate(rate);
+        Animator exact(&animation);
+        const float interval = 1.0f / rate;
+        float maxError = 0.0f;
+        for (int frame = 1; frame <= frames * 4; frame++)
+        {
+            fixedRate.UpdateAnimation(deltaTime);
+            const float shownTime = frame * deltaTime - interval;
+            if (shownTime < 0.0f)
+                continue;
+            exact.SetCurrentTime(std::fmod(shownTime * animation.GetTicksPerSecond(), animation.GetDuration()));
+            exact.CalculateBoneTransforms();
+            maxError = std::max(maxError, maxMatrixDifference(fixedRate.GetFinalBoneMatrices(), exact.GetFinalBoneMatrices()));
+        }
+        std::cout << rate << " Hz interpolated vs evaluated: max bone matrix difference " << maxError << std::endl;
+    }
+}
+
+// shared: skeleton and clips loaded once, what every further character costs
+// ---------------------------------------------------------------------------
+void benchmarkShared(Model& model, Animation& animation)
+{
+    const unsigned int instanceCount = 1000;
+    const char* path = "../../resources/objects/vampire/dancing_vampire.dae";
+    JobSystem jobs;
+
+    // loading the clip again hands out the same animation, on the model's skeleton
+    std::shared_ptr<const Animation> clip = LoadSharedAnimation(path, &model);
+    std::shared_ptr<const Animation> again = LoadSharedAnimation(path, &model);
+    const Skeleton& skeleton = *model.GetSkeleton();
+
+    size_t skeletonBytes = skeleton.GetNodes().size() * (sizeof(AnimationNode) + sizeof(BonePose) + sizeof(std::string));
+    for (size_t i = 0; i < skeleton.GetNodes().size(); i++)
+        skeletonBytes += skeleton.GetNodeName(static_cast<int>(i)).capacity();
+    size_t clipBytes = clip->GetNodeTracks().size() * sizeof(int);
+    for (const Bone& bone : clip->GetBones())
+    {
+        clipBytes += sizeof(Bone) + bone.GetPositionKeys().Size() * (sizeof(float) + sizeof(glm::vec3)) +
+            bone.GetRotationKeys().Size() * (sizeof(float) + sizeof(glm::quat)) + bone.GetScaleKeys().Size() * (sizeof(float) + sizeof(glm::vec3));
+    }
+
+    std::vector<Animator> animators(instanceCount, Animator(clip.get()));
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        animators[i].SetCurrentTime(i * 7.0f);
+        animators[i].UpdateAnimation(1.0f / 60.0f);
+    }
+    CrowdAnimator crowd(clip.get(), instanceCount, jobs);
+    crowd.UpdateAnimation(1.0f / 60.0f);
+
+    size_t animatorBytes = 0;
+    for (const Animator& animator : animators)
+        animatorBytes += animator.GetSizeInBytes();
+    const size_t crowdBytes = crowd.GetAnimator(0).GetSizeInBytes() + crowd.GetPaletteStride() * sizeof(glm::mat4);
+
+    std::cout << "shared, " << skeleton.GetNodes().size() << " nodes, " << skeleton.GetBoneMatrixCount() << " bone matrices, " << clip->GetBones().size() << " tracks" << std::endl;
+    std::cout << "clip loaded twice:        " << (clip == again ? "same animation" : "two copies") << ", skeleton "
+        << (clip->GetSkeleton() == model.GetSkeleton() && animation.GetSkeleton() == model.GetSkeleton() ? "shared with the model" : "copied") << std::endl;
+    std::cout << "shared once:              skeleton " << skeletonBytes << " bytes, clip " << clipBytes << " bytes" << std::endl;
+    std::cout << "per character:            animator " << animatorBytes / instanceCount << " bytes, crowd animator + palette slice " << crowdBytes << " bytes" << std::endl;
+    std::cout << instanceCount << " characters:         " << (skeletonBytes + clipBytes + animatorBytes) / 1024 << " KB" << std::endl;
+}
+
+// benchmark table
+// ---------------
+struct Benchmark
+{
+    const char* name;
+    void (*run)(Model& model, Animation& animation);
+};
+
+const Benchmark benchmarks[] = {
+    { "animator", [](Model&, Animation& animation) { benchmarkAnimator(animation); } },
+    { "crowd", [](Model&, Animation& animation) { benchmarkCrowd(animation); } },
+    { "blend", [](Model&, Animation& animation) { benchmarkBlend(animation); } },
+    { "clip", benchmarkClip },
+    { "skinning", benchmarkSkinning },
+    { "fixedrate", [](Model&, Animation& animation) { benchmarkFixedRate(animation); } },
+    { "shared", benchmarkShared },
+};
+
+int main(int argc, char** argv)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(64, 64, "animation benchmarks", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Model vampire("../../resources/objects/vampire/dancing_vampire.dae");
+    if (vampire.GetBoneCount() == 0)
+    {
+        std::cout << "ERROR::ANIMATION_BENCHMARKS::VAMPIRE_NOT_LOADED" << std::endl;
+        return -1;
+    }
+    Animation danceAnimation("../../resources/objects/vampire/dancing_vampire.dae", &vampire);
+
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            selected = selected || std::strcmp(argv[i], benchmark.name) == 0;
+        if (!selected)
+            continue;
+
+        std::cout << "== " << benchmark.name << " ==" << std::endl;
+        benchmark.run(vampire, danceAnimation);
+        std::cout << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,45 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+layout (location = 7) in mat4 aInstanceMatrix;
+layout (location = 11) in vec4 aInstanceAnimation; // first row, frame count, frames per second, time offset (AnimationTexture)
+
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform float time;
+uniform sampler2D boneTexture; // three texels per bone: the first three rows of its final bone matrix
+
+out vec2 TexCoords;
+
+void main()
+{
+    // the two baked frames around this instance's time
+    float frame = mod((time + aInstanceAnimation.w) * aInstanceAnimation.z, aInstanceAnimation.y - 1.0f);
+    int frame0 = int(frame);
+    float factor = frame - float(frame0);
+    int row0 = int(aInstanceAnimation.x) + frame0;
+
+    vec4 position = vec4(aPos, 1.0f);
+    vec3 totalPosition = vec3(0.0f);
+    float totalWeight = 0.0f;
+    // unused slots are bone 0 with weight 0 and add nothing
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        int column = aBoneIds[i] * 3;
+        vec4 rowX = mix(texelFetch(boneTexture, ivec2(column, row0), 0), texelFetch(boneTexture, ivec2(column, row0 + 1), 0), factor);
+        vec4 rowY = mix(texelFetch(boneTexture, ivec2(column + 1, row0), 0), texelFetch(boneTexture, ivec2(column + 1, row0 + 1), 0), factor);
+        vec4 rowZ = mix(texelFetch(boneTexture, ivec2(column + 2, row0), 0), texelFetch(boneTexture, ivec2(column + 2, row0 + 1), 0), factor);
+        totalPosition += vec3(dot(rowX, position), dot(rowY, position), dot(rowZ, position)) * aWeights[i];
+        totalWeight += aWeights[i];
+    }
+    // vertices without bones stay where they are
+    if (totalWeight == 0.0f)
+        totalPosition = aPos;
+
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * aInstanceMatrix * vec4(totalPosition, 1.0f);
+}
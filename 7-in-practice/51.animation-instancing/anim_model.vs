@@ -0,0 +1,33 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+
+const int MAX_BONES = 100;
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat4 finalBonesMatrices[MAX_BONES];
+
+out vec2 TexCoords;
+
+void main()
+{
+    vec4 totalPosition = vec4(0.0f);
+    // unused slots are bone 0 with weight 0 and add nothing
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (aBoneIds[i] >= MAX_BONES)
+        {
+            totalPosition = vec4(aPos, 1.0f);
+            break;
+        }
+        totalPosition += finalBonesMatrices[aBoneIds[i]] * vec4(aPos, 1.0f) * aWeights[i];
+    }
+
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * model * totalPosition;
+}
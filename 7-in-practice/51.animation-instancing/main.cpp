@@ -0,0 +1,297 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/animator.h>
+#include <learnopengl/animation_texture.h>
+#include <learnopengl/model_animation.h>
+#include <learnopengl/gpu_timer.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow* window);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// camera
+Camera camera(glm::vec3(0.0f, 8.0f, 40.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// space switches between an Animator per character (the model_animation.h path) and the baked texture
+bool bakedInstancing = true;
+bool spacePressed = false;
+
+// per instance attributes of the baked path, locations 7-10 and 11 of anim_instanced.vs
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 animation;
+};
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSwapInterval(0); // frame times are the point of this demo
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    // -------------------------
+    Shader animatorShader("anim_model.vs", "anim_model.fs");
+    Shader instancedShader("anim_instanced.vs", "anim_model.fs");
+
+    // load models
+    // -----------
+    Model vampire("../../resources/objects/vampire/dancing_vampire.dae");
+    Animation danceAnimation("../../resources/objects/vampire/dancing_vampire.dae", &vampire);
+
+    // bake the dance once: 30 frames per second of every bone matrix
+    AnimationTexture bakedClips({ &danceAnimation }, 30.0f);
+    std::cout << "baked " << bakedClips.GetBoneCount() << " bones into " << bakedClips.GetSizeInBytes() / 1024 << " KB" << std::endl;
+
+    // a crowd on a grid, every dancer a bit out of step with its neighbours
+    // ---------------------------------------------------------------------
+    const unsigned int amount = 1000;
+    const unsigned int columns = 40;
+    const float spacing = 1.5f;
+    std::vector<InstanceData> instances(amount);
+    std::vector<Animator> animators(amount, Animator(&danceAnimation));
+    for (unsigned int i = 0; i < amount; i++)
+    {
+        const float x = (static_cast<float>(i % columns) - columns * 0.5f) * spacing;
+        const float z = -static_cast<float>(i / columns) * spacing;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z));
+        model = glm::scale(model, glm::vec3(0.5f));
+
+        const float timeOffset = static_cast<float>(i % 37) * 0.11f;
+        instances[i].model = model;
+        instances[i].animation = bakedClips.GetInstanceAnimation(0, timeOffset);
+        animators[i].SetCurrentTime(timeOffset * danceAnimation.GetTicksPerSecond());
+    }
+
+    // instance buffer, added to the vertex array of every mesh
+    unsigned int instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(InstanceData), &instances[0], GL_STATIC_DRAW);
+    for (unsigned int i = 0; i < vampire.meshes.size(); i++)
+    {
+        glBindVertexArray(vampire.meshes[i].VAO);
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(7 + column);
+            glVertexAttribPointer(7 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(7 + column, 1);
+        }
+        glEnableVertexAttribArray(11);
+        glVertexAttribPointer(11, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, animation));
+        glVertexAttribDivisor(11, 1);
+        glBindVertexArray(0);
+    }
+
+    GpuTimer gpuTimer;
+    float statsStart = 0.0f;
+    int statsFrames = 0;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        // render
+        // ------
+        gpuTimer.begin();
+        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        if (bakedInstancing)
+        {
+            // one instanced draw per mesh, the vertex shader looks up the pose of every instance
+            instancedShader.use();
+            instancedShader.setMat4("projection", projection);
+            instancedShader.setMat4("view", view);
+            instancedShader.setFloat("time", currentFrame);
+            instancedShader.setInt("texture_diffuse1", 0);
+            instancedShader.setInt("boneTexture", 1);
+            bakedClips.Bind(1);
+            for (unsigned int i = 0; i < vampire.meshes.size(); i++)
+            {
+                const Mesh& mesh = vampire.meshes[i];
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, mesh.textures.empty() ? 0 : mesh.textures[0].id);
+                glBindVertexArray(mesh.VAO);
+                glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(mesh.indices.size()), GL_UNSIGNED_INT, 0, amount);
+            }
+            glBindVertexArray(0);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        else
+        {
+            // an Animator, a palette upload and a draw per character
+            animatorShader.use();
+            animatorShader.setMat4("projection", projection);
+            animatorShader.setMat4("view", view);
+            for (unsigned int i = 0; i < amount; i++)
+            {
+                animators[i].UpdateAnimation(deltaTime);
+                const std::vector<glm::mat4>& transforms = animators[i].GetFinalBoneMatrices();
+                glUniformMatrix4fv(glGetUniformLocation(animatorShader.ID, "finalBonesMatrices"), static_cast<GLsizei>(transforms.size()), GL_FALSE, glm::value_ptr(transforms[0]));
+                animatorShader.setMat4("model", instances[i].model);
+                vampire.Draw(animatorShader);
+            }
+        }
+
+        gpuTimer.end();
+
+        // frame and gpu time in the title once a second, the gpu time read back without waiting on the frames in flight
+        statsFrames++;
+        if (currentFrame - statsStart >= 1.0f)
+        {
+            const std::string title = std::string(bakedInstancing ? "baked texture, instanced" : "animator per instance") + ": "
+                + std::to_string(amount) + " instances, " + std::to_string((currentFrame - statsStart) * 1000.0f / statsFrames) + " ms/frame, "
+                + std::to_string(gpuTimer.takeAverageMs()) + " ms gpu";
+            glfwSetWindowTitle(window, title.c_str());
+            statsStart = currentFrame;
+            statsFrames = 0;
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteBuffers(1, &instanceVBO);
+    glfwTerminate();
+    return 0;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow* window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !spacePressed)
+    {
+        bakedInstancing = !bakedInstancing;
+        spacePressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
+        spacePressed = false;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -0,0 +1,15 @@
+#version 330 core
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+uniform vec3 lightPos;
+uniform float far_plane;
+
+void main()
+{
+    // distance to the light mapped to [0,1]
+    gl_FragDepth = length(fs_in.FragPos - lightPos) / far_plane;
+}
@@ -0,0 +1,43 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+
+const int MAX_BONES = 100;
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat4 finalBonesMatrices[MAX_BONES];
+
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} vs_out;
+
+// skins in every pass that draws the character, what the skinning cache saves
+void main()
+{
+    mat4 boneTransform = mat4(0.0);
+    float totalWeight = 0.0;
+    // unused slots are bone 0 with weight 0 and add nothing
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (aBoneIds[i] >= MAX_BONES)
+            continue;
+        boneTransform += finalBonesMatrices[aBoneIds[i]] * aWeights[i];
+        totalWeight += aWeights[i];
+    }
+    if (totalWeight == 0.0)
+        boneTransform = mat4(1.0);
+
+    vec4 worldPos = model * boneTransform * vec4(aPos, 1.0);
+    vs_out.FragPos = worldPos.xyz;
+    vs_out.Normal = mat3(model) * mat3(boneTransform) * aNormal;
+    vs_out.TexCoords = aTexCoords;
+    gl_Position = projection * view * worldPos;
+}
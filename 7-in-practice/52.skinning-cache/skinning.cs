@@ -0,0 +1,81 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+// std430 layouts of SkinningInputVertex and SkinnedVertex (skinning_cache.h)
+struct InputVertex
+{
+    vec4 position;
+    vec4 normal;
+    vec4 tangent;
+    vec4 bitangent;
+    ivec4 boneIds;
+    vec4 weights;
+};
+
+struct SkinnedVertex
+{
+    vec4 position;
+    vec4 normal;
+    vec4 tangent;
+    vec4 bitangent;
+};
+
+layout (std430, binding = 0) readonly buffer BindPose
+{
+    InputVertex bindPose[];
+};
+
+layout (std430, binding = 1) readonly buffer Palette
+{
+    mat4 palette[];
+};
+
+layout (std430, binding = 2) writeonly buffer Skinned
+{
+    SkinnedVertex skinned[];
+};
+
+uniform int vertexCount;
+uniform int boneCount;
+
+vec4 normalizeDirection(vec3 direction)
+{
+    return vec4(dot(direction, direction) > 0.0 ? normalize(direction) : direction, 0.0);
+}
+
+void main()
+{
+    int index = int(gl_GlobalInvocationID.x);
+    if (index >= vertexCount)
+        return;
+
+    InputVertex vertex = bindPose[index];
+    mat4 blended = mat4(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        int bone = vertex.boneIds[i];
+        if (bone < 0 || bone >= boneCount)
+            continue;
+        blended += palette[bone] * vertex.weights[i];
+        totalWeight += vertex.weights[i];
+    }
+
+    SkinnedVertex result;
+    if (totalWeight == 0.0)
+    {
+        result.position = vertex.position;
+        result.normal = vertex.normal;
+        result.tangent = vertex.tangent;
+        result.bitangent = vertex.bitangent;
+    }
+    else
+    {
+        mat3 linear = mat3(blended);
+        result.position = vec4((blended * vec4(vertex.position.xyz, 1.0)).xyz, 1.0);
+        result.normal = normalizeDirection(linear * vertex.normal.xyz);
+        result.tangent = normalizeDirection(linear * vertex.tangent.xyz);
+        result.bitangent = normalizeDirection(linear * vertex.bitangent.xyz);
+    }
+    skinned[index] = result;
+}
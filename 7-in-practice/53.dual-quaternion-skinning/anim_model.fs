@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 lightDir;
+
+void main()
+{
+    // a little directional shading so the shape of the joints shows
+    float diffuse = max(dot(normalize(Normal), -lightDir), 0.0);
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * (0.4 + 0.6 * diffuse), 1.0);
+}
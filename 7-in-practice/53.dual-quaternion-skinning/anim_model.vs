@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+
+const int MAX_BONES = 100;
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat4 finalBonesMatrices[MAX_BONES];
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+// linear blend skinning: the weighted sum of the bone matrices
+void main()
+{
+    mat4 boneTransform = mat4(0.0);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (aBoneIds[i] >= MAX_BONES)
+            continue;
+        boneTransform += finalBonesMatrices[aBoneIds[i]] * aWeights[i];
+    }
+    // vertices without bones stay where they are
+    if (aWeights[0] == 0.0)
+        boneTransform = mat4(1.0);
+
+    TexCoords = aTexCoords;
+    Normal = mat3(model) * mat3(boneTransform) * aNormal;
+    gl_Position = projection * view * model * boneTransform * vec4(aPos, 1.0);
+}
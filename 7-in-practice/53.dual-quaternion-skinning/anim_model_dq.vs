@@ -0,0 +1,55 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aWeights;
+
+const int MAX_BONES = 100;
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat2x4 finalBonesDualQuats[MAX_BONES]; // rotation, translation part (Animator::GetFinalDualQuaternions)
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// dual quaternion skinning: blend the unit dual quaternions of the bones and renormalize, a blend of rotations
+// stays a rotation so twisted joints keep their volume
+void main()
+{
+    // the strongest influence comes first, the others are flipped onto its side of the quaternion sphere so the
+    // blend takes the short way around
+    vec4 pivot = finalBonesDualQuats[min(aBoneIds[0], MAX_BONES - 1)][0];
+    mat2x4 blended = mat2x4(0.0);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (aBoneIds[i] >= MAX_BONES)
+            continue;
+        mat2x4 dq = finalBonesDualQuats[aBoneIds[i]];
+        float weight = dot(dq[0], pivot) < 0.0 ? -aWeights[i] : aWeights[i];
+        blended += dq * weight;
+    }
+    float len = length(blended[0]);
+    // vertices without bones stay where they are
+    if (len == 0.0)
+        blended = mat2x4(vec4(0.0, 0.0, 0.0, 1.0), vec4(0.0));
+    else
+        blended /= len;
+
+    vec4 real = blended[0];
+    vec4 dual = blended[1];
+    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    vec3 position = rotate(real, aPos) + translation;
+
+    TexCoords = aTexCoords;
+    Normal = mat3(model) * rotate(real, aNormal);
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
@@ -2,27 +2,25 @@
 
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
 #include <learnopengl/bone.h>
 #include <functional>
 #include <learnopengl/animdata.h>
 #include <learnopengl/model_animation.h>
-
-struct AssimpNodeData
-{
-	glm::mat4 transformation;
-	std::string name;
-	int childrenCount;
-	std::vector<AssimpNodeData> children;
-};
+#include <learnopengl/skeleton.h>
 
 class Animation
 {
 public:
 	Animation() = default;
 
-	Animation(const std::string& animationPath, Model* model)
+	// the clip's tracks are matched by node name to skeleton, or to the model's skeleton (shared by all of
+	// its clips) when none is given. The model is left untouched.
+	Animation(const std::string& animationPath, Model* model, std::shared_ptr<const Skeleton> skeleton = nullptr)
 	{
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
@@ -30,10 +28,23 @@ public:
 		auto animation = scene->mAnimations[0];
 		m_Duration = animation->mDuration;
 		m_TicksPerSecond = animation->mTicksPerSecond;
-		aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-		globalTransformation = globalTransformation.Inverse();
-		ReadHierarchyData(m_RootNode, scene->mRootNode);
-		ReadMissingBones(animation, *model);
+		m_Skeleton = skeleton ? skeleton : model->GetSkeleton();
+		if (!m_Skeleton)
+			m_Skeleton = std::make_shared<const Skeleton>(scene->mRootNode, model->GetBoneInfoMap());
+		ReadBones(animation);
+	}
+
+	// an animation that is already compiled, e.g. read from a baked clip (see animation_clip.h).
+	// nodeTracks[i] indexes bones for node i of skeleton, -1 if the node isn't animated.
+	Animation(float duration, int ticksPerSecond, std::shared_ptr<const Skeleton> skeleton, const std::vector<int>& nodeTracks, const std::vector<Bone>& bones)
+	{
+		m_Duration = duration;
+		m_TicksPerSecond = ticksPerSecond;
+		m_Skeleton = skeleton;
+		m_Bones = bones;
+		for (size_t i = 0; i < m_Bones.size(); i++)
+			m_BoneIndices[m_Bones[i].GetBoneName()] = static_cast<int>(i);
+		m_NodeTracks = nodeTracks;
 	}
 
 	~Animation()
@@ -42,70 +53,79 @@ public:
 
 	Bone* FindBone(const std::string& name)
 	{
-		auto iter = std::find_if(m_Bones.begin(), m_Bones.end(),
-			[&](const Bone& Bone)
-			{
-				return Bone.GetBoneName() == name;
-			}
-		);
-		if (iter == m_Bones.end()) return nullptr;
-		else return &(*iter);
+		auto iter = m_BoneIndices.find(name);
+		if (iter == m_BoneIndices.end()) return nullptr;
+		else return &m_Bones[iter->second];
 	}
 
-	
-	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
-	inline float GetDuration() { return m_Duration;}
-	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
-	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() 
+	// index in GetBones() of the track animating the named node, -1 if this clip doesn't animate it
+	int FindTrackIndex(const std::string& name) const
+	{
+		auto iter = m_BoneIndices.find(name);
+		return iter == m_BoneIndices.end() ? -1 : iter->second;
+	}
+
+	inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+	inline float GetDuration() const { return m_Duration;}
+
+	// the rig the clip is played on, shared with the model and its other clips
+	inline const std::shared_ptr<const Skeleton>& GetSkeleton() const { return m_Skeleton; }
+	inline const AssimpNodeData& GetRootNode() const { return m_Skeleton->GetRootNode(); }
+	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() const
 	{ 
-		return m_BoneInfoMap;
+		return m_Skeleton->GetBoneIDMap();
 	}
+	inline const std::vector<AnimationNode>& GetNodes() const { return m_Skeleton->GetNodes(); }
+	inline const std::string& GetNodeName(int node) const { return m_Skeleton->GetNodeName(node); }
+	inline const std::vector<BonePose>& GetBindPoses() const { return m_Skeleton->GetBindPoses(); }
+	int GetBoneMatrixCount() const { return m_Skeleton->GetBoneMatrixCount(); }
+
+	inline std::vector<Bone>& GetBones() { return m_Bones; }
+	inline const std::vector<Bone>& GetBones() const { return m_Bones; }
+	// per node of the skeleton: index in GetBones() of the track animating it, -1 if not animated
+	inline const std::vector<int>& GetNodeTracks() const { return m_NodeTracks; }
 
 private:
-	void ReadMissingBones(const aiAnimation* animation, Model& model)
+	// a Bone per channel, tied to the final bone matrix of its node (-1 when no vertex is bound to it)
+	void ReadBones(const aiAnimation* animation)
 	{
-		int size = animation->mNumChannels;
-
-		auto& boneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
-		int& boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
-
-		//reading channels(bones engaged in an animation and their keyframes)
-		for (int i = 0; i < size; i++)
+		const std::vector<AnimationNode>& nodes = m_Skeleton->GetNodes();
+		for (unsigned int i = 0; i < animation->mNumChannels; i++)
 		{
 			auto channel = animation->mChannels[i];
 			std::string boneName = channel->mNodeName.data;
-
-			if (boneInfoMap.find(boneName) == boneInfoMap.end())
-			{
-				boneInfoMap[boneName].id = boneCount;
-				boneCount++;
-			}
-			m_Bones.push_back(Bone(channel->mNodeName.data,
-				boneInfoMap[channel->mNodeName.data].id, channel));
+			const int node = m_Skeleton->FindNode(boneName);
+			m_BoneIndices[boneName] = static_cast<int>(m_Bones.size());
+			m_Bones.push_back(Bone(boneName, node >= 0 ? nodes[node].boneIndex : -1, channel));
 		}
 
-		m_BoneInfoMap = boneInfoMap;
+		m_NodeTracks.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++)
+			m_NodeTracks[i] = FindTrackIndex(m_Skeleton->GetNodeName(static_cast<int>(i)));
 	}
 
-	void ReadHierarchyData(AssimpNodeData& dest, const aiNode* src)
-	{
-		assert(src);
-
-		dest.name = src->mName.data;
-		dest.transformation = AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation);
-		dest.childrenCount = src->mNumChildren;
-
-		for (int i = 0; i < src->mNumChildren; i++)
-		{
-			AssimpNodeData newData;
-			ReadHierarchyData(newData, src->mChildren[i]);
-			dest.children.push_back(newData);
-		}
-	}
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
-	AssimpNodeData m_RootNode;
-	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::unordered_map<std::string, int> m_BoneIndices; // bone name -> index in m_Bones
+	std::shared_ptr<const Skeleton> m_Skeleton;
+	std::vector<int> m_NodeTracks; // parallel to the skeleton's nodes
 };
 
+// Loads the clip of path once per skeleton: every caller gets the same immutable Animation, which is freed
+// with the last reference to it.
+inline std::shared_ptr<const Animation> LoadSharedAnimation(const std::string& animationPath, Model* model)
+{
+	static std::mutex mutex;
+	static std::map<std::pair<std::string, const Skeleton*>, std::weak_ptr<const Animation>> loaded;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::weak_ptr<const Animation>& entry = loaded[std::make_pair(animationPath, model->GetSkeleton().get())];
+	std::shared_ptr<const Animation> animation = entry.lock();
+	if (!animation)
+	{
+		animation = std::make_shared<const Animation>(animationPath, model);
+		entry = animation;
+	}
+	return animation;
+}
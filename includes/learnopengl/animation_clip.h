@@ -0,0 +1,523 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <learnopengl/animation.h>
+#include <learnopengl/bone.h>
+#include <learnopengl/clip_format.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+	Baked animation clips: the keys of an imported Animation reduced, quantized and written to a file
+	(clip_format.h) that is mapped into memory and played in place, without Assimp.
+*/
+
+struct ClipBakeSettings
+{
+	// largest error keyframe reduction may add, in model units, radians and scale units
+	float positionTolerance = 0.001f;
+	float rotationTolerance = 0.001f;
+	float scaleTolerance = 0.001f;
+	// > 0: every channel is resampled at this many keys per second instead of being reduced. More keys, but no
+	// key times to store or search
+	float sampleRate = 0.0f;
+};
+
+struct ClipBakeReport
+{
+	unsigned int sourceKeys = 0;
+	unsigned int bakedKeys = 0;
+	size_t sourceKeyBytes = 0; // as the Bones hold them: float time and full float value per key
+	size_t bakedKeyBytes = 0;
+	size_t fileBytes = 0;
+	// measured on the baked clip at every source key and halfway between them
+	float maxPositionError = 0.0f;
+	float maxRotationError = 0.0f; // radians
+	float maxScaleError = 0.0f;
+};
+
+inline float KeyError(const glm::vec3& a, const glm::vec3& b)
+{
+	return glm::length(a - b);
+}
+
+// angle between the rotations (from the difference rotation, acos of the dot product loses small angles)
+inline float KeyError(const glm::quat& a, const glm::quat& b)
+{
+	const glm::quat difference = glm::conjugate(a) * b;
+	return 2.0f * std::atan2(glm::length(glm::vec3(difference.x, difference.y, difference.z)), std::abs(difference.w));
+}
+
+template<typename T>
+bool IsConstantTrack(const KeyTrack<T>& track, float tolerance)
+{
+	for (int i = 1; i < track.Size(); i++)
+	{
+		if (KeyError(track.values[i], track.values[0]) > tolerance)
+			return false;
+	}
+	return true;
+}
+
+// indices of the keys to keep: every segment is stretched as long as linear interpolation between its ends
+// stays within tolerance of all the keys it skips. Channels that never leave tolerance of their first key
+// keep just that one.
+template<typename T>
+std::vector<int> ReduceKeys(const KeyTrack<T>& track, float tolerance)
+{
+	std::vector<int> kept(1, 0);
+	const int keyCount = track.Size();
+	if (IsConstantTrack(track, tolerance))
+		return kept;
+
+	int start = 0;
+	while (start < keyCount - 1)
+	{
+		int end = start + 1;
+		while (end + 1 < keyCount)
+		{
+			const int candidate = end + 1;
+			const float span = track.times[candidate] - track.times[start];
+			bool fits = true;
+			for (int i = start + 1; i < candidate && fits; i++)
+			{
+				const float factor = span > 0.0f ? (track.times[i] - track.times[start]) / span : 0.0f;
+				fits = KeyError(InterpolateKey(track.values[start], track.values[candidate], factor), track.values[i]) <= tolerance;
+			}
+			if (!fits)
+				break;
+			end = candidate;
+		}
+		kept.push_back(end);
+		start = end;
+	}
+	return kept;
+}
+
+/* Clip file assembly: appends 4 byte aligned blocks and returns their offsets */
+class ClipWriter
+{
+public:
+	std::vector<unsigned char> bytes;
+
+	uint32_t Append(const void* data, size_t size)
+	{
+		Align();
+		const uint32_t offset = static_cast<uint32_t>(bytes.size());
+		bytes.insert(bytes.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+		return offset;
+	}
+
+	uint32_t AppendString(const std::string& text)
+	{
+		const uint32_t offset = static_cast<uint32_t>(bytes.size());
+		bytes.insert(bytes.end(), text.begin(), text.end());
+		bytes.push_back(0);
+		return offset;
+	}
+
+	void Align()
+	{
+		while (bytes.size() % 4 != 0)
+			bytes.push_back(0);
+	}
+};
+
+// sample times and values of one baked channel, keyed or uniform
+template<typename T>
+void SelectKeys(const KeyTrack<T>& track, float tolerance, float duration, float ticksPerSecond, float sampleRate,
+	std::vector<float>& times, std::vector<T>& values)
+{
+	times.clear();
+	values.clear();
+	if (sampleRate > 0.0f)
+	{
+		if (IsConstantTrack(track, tolerance))
+		{
+			times.push_back(0.0f);
+			values.push_back(track.values[0]);
+			return;
+		}
+		const int keyCount = std::max(2, static_cast<int>(std::ceil(duration / ticksPerSecond * sampleRate)) + 1);
+		int cursor = 0;
+		for (int k = 0; k < keyCount; k++)
+		{
+			const float time = duration * k / (keyCount - 1);
+			times.push_back(time);
+			values.push_back(track.Sample(time, cursor));
+		}
+		return;
+	}
+
+	for (int key : ReduceKeys(track, tolerance))
+	{
+		times.push_back(track.times[key]);
+		values.push_back(track.values[key]);
+	}
+}
+
+inline ClipChannel WriteVec3Channel(ClipWriter& writer, const std::vector<float>& times, const std::vector<glm::vec3>& values, float duration, bool uniform)
+{
+	ClipChannel channel = {};
+	channel.keyCount = static_cast<uint32_t>(values.size());
+	glm::vec3 minimum = values[0], maximum = values[0];
+	for (const glm::vec3& value : values)
+	{
+		minimum = glm::min(minimum, value);
+		maximum = glm::max(maximum, value);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		channel.minimum[i] = minimum[i];
+		channel.extent[i] = maximum[i] - minimum[i];
+	}
+
+	std::vector<uint16_t> quantized(values.size() * 3);
+	for (size_t k = 0; k < values.size(); k++)
+		QuantizeVec3(values[k], channel.minimum, channel.extent, &quantized[k * 3]);
+	if (!uniform && values.size() > 1)
+	{
+		std::vector<uint16_t> quantizedTimes(times.size());
+		for (size_t k = 0; k < times.size(); k++)
+			quantizedTimes[k] = QuantizeUnit(duration > 0.0f ? times[k] / duration : 0.0f);
+		channel.timesOffset = writer.Append(quantizedTimes.data(), quantizedTimes.size() * sizeof(uint16_t));
+	}
+	channel.valuesOffset = writer.Append(quantized.data(), quantized.size() * sizeof(uint16_t));
+	return channel;
+}
+
+inline ClipChannel WriteRotationChannel(ClipWriter& writer, const std::vector<float>& times, const std::vector<glm::quat>& values, float duration, bool uniform)
+{
+	ClipChannel channel = {};
+	channel.keyCount = static_cast<uint32_t>(values.size());
+	std::vector<uint16_t> packed(values.size() * 3);
+	for (size_t k = 0; k < values.size(); k++)
+		PackQuaternion48(values[k], &packed[k * 3]);
+	if (!uniform && values.size() > 1)
+	{
+		std::vector<uint16_t> quantizedTimes(times.size());
+		for (size_t k = 0; k < times.size(); k++)
+			quantizedTimes[k] = QuantizeUnit(duration > 0.0f ? times[k] / duration : 0.0f);
+		channel.timesOffset = writer.Append(quantizedTimes.data(), quantizedTimes.size() * sizeof(uint16_t));
+	}
+	channel.valuesOffset = writer.Append(packed.data(), packed.size() * sizeof(uint16_t));
+	return channel;
+}
+
+// checks that every offset and count of a clip stays inside its size bytes, that every node, track and bone index
+// points at something that exists, and that the timing can be played
+inline bool ValidateClipData(const unsigned char* data, size_t size)
+{
+	if (size < sizeof(ClipFileHeader))
+		return false;
+	ClipFileHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, CLIP_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != CLIP_FILE_VERSION || header.fileSize != size)
+		return false;
+	// the duration wraps the play time, ticksPerSecond is stored as an int
+	if (!(header.duration > 0.0f) || !std::isfinite(header.duration) ||
+		!(header.ticksPerSecond > 0.0f && header.ticksPerSecond < static_cast<float>(std::numeric_limits<int>::max())))
+		return false;
+	if (header.nodeCount == 0)
+		return false;
+	if (static_cast<uint64_t>(header.nodesOffset) + static_cast<uint64_t>(header.nodeCount) * sizeof(ClipFileNode) > size ||
+		static_cast<uint64_t>(header.tracksOffset) + static_cast<uint64_t>(header.trackCount) * sizeof(ClipFileTrack) > size ||
+		header.nodesOffset % 4 != 0 || header.tracksOffset % 4 != 0)
+		return false;
+
+	auto validName = [&](uint32_t offset) { return offset < size && memchr(data + offset, 0, size - offset) != nullptr; };
+	auto validChannel = [&](const ClipChannel& channel)
+	{
+		const uint64_t keys = channel.keyCount;
+		return keys > 0 && channel.valuesOffset % 2 == 0 && channel.timesOffset % 2 == 0 &&
+			channel.valuesOffset + keys * 3 * sizeof(uint16_t) <= size &&
+			(channel.timesOffset == 0 || channel.timesOffset + keys * sizeof(uint16_t) <= size);
+	};
+
+	// parents come before their children; -1 is the only "none". The palette is as large as the largest bone index
+	// (see Skeleton), so a bone index is bounded by the node count and the tracks' bones by the palette
+	const ClipFileNode* nodes = reinterpret_cast<const ClipFileNode*>(data + header.nodesOffset);
+	int32_t paletteSize = 0;
+	for (uint32_t i = 0; i < header.nodeCount; i++)
+	{
+		if (!validName(nodes[i].nameOffset) || nodes[i].parentIndex < -1 || nodes[i].parentIndex >= static_cast<int32_t>(i) ||
+			nodes[i].trackIndex < -1 || nodes[i].trackIndex >= static_cast<int32_t>(header.trackCount) ||
+			nodes[i].boneIndex < -1 || nodes[i].boneIndex >= static_cast<int32_t>(header.nodeCount))
+			return false;
+		paletteSize = std::max(paletteSize, nodes[i].boneIndex + 1);
+	}
+	const ClipFileTrack* tracks = reinterpret_cast<const ClipFileTrack*>(data + header.tracksOffset);
+	for (uint32_t i = 0; i < header.trackCount; i++)
+	{
+		if (!validName(tracks[i].nameOffset) || tracks[i].boneID < -1 || tracks[i].boneID >= paletteSize ||
+			!validChannel(tracks[i].positions) || !validChannel(tracks[i].rotations) || !validChannel(tracks[i].scales))
+			return false;
+	}
+	return true;
+}
+
+// an Animation whose bones sample the clip's keys in place, data has to stay valid while it is used. The clip
+// shares skeleton (e.g. the model's or the one of a clip loaded before) when its nodes match.
+inline Animation CreateAnimationFromClip(const unsigned char* data, std::shared_ptr<const Skeleton> skeleton = nullptr)
+{
+	const ClipFileHeader* header = reinterpret_cast<const ClipFileHeader*>(data);
+	const ClipFileNode* fileNodes = reinterpret_cast<const ClipFileNode*>(data + header->nodesOffset);
+	const ClipFileTrack* fileTracks = reinterpret_cast<const ClipFileTrack*>(data + header->tracksOffset);
+
+	std::vector<AnimationNode> nodes(header->nodeCount);
+	std::vector<std::string> nodeNames(header->nodeCount);
+	std::vector<int> nodeTracks(header->nodeCount);
+	for (uint32_t i = 0; i < header->nodeCount; i++)
+	{
+		nodes[i].transformation = fileNodes[i].transformation;
+		nodes[i].offset = fileNodes[i].offset;
+		nodes[i].parentIndex = fileNodes[i].parentIndex;
+		nodes[i].boneIndex = fileNodes[i].boneIndex;
+		nodeTracks[i] = fileNodes[i].trackIndex;
+		nodeNames[i] = reinterpret_cast<const char*>(data + fileNodes[i].nameOffset);
+	}
+	if (!skeleton || !skeleton->Matches(nodes, nodeNames))
+		skeleton = std::make_shared<const Skeleton>(nodes, nodeNames);
+
+	std::vector<Bone> bones;
+	bones.reserve(header->trackCount);
+	for (uint32_t i = 0; i < header->trackCount; i++)
+		bones.push_back(Bone(reinterpret_cast<const char*>(data + fileTracks[i].nameOffset), fileTracks[i].boneID, data, &fileTracks[i], header->duration));
+
+	return Animation(header->duration, static_cast<int>(header->ticksPerSecond), skeleton, nodeTracks, bones);
+}
+
+// largest difference between the source and the baked bones at every source key and halfway between them
+inline void MeasureClipError(const Animation& source, const Animation& baked, ClipBakeReport& report)
+{
+	for (size_t t = 0; t < source.GetBones().size(); t++)
+	{
+		const Bone& sourceBone = source.GetBones()[t];
+		const Bone& bakedBone = baked.GetBones()[t];
+		std::vector<float> times;
+		const std::vector<float>* keyTimes[3] = { &sourceBone.GetPositionKeys().times, &sourceBone.GetRotationKeys().times, &sourceBone.GetScaleKeys().times };
+		for (const std::vector<float>* channelTimes : keyTimes)
+		{
+			for (size_t k = 0; k < channelTimes->size(); k++)
+			{
+				times.push_back((*channelTimes)[k]);
+				if (k + 1 < channelTimes->size())
+					times.push_back(((*channelTimes)[k] + (*channelTimes)[k + 1]) * 0.5f);
+			}
+		}
+
+		BoneCursor sourceCursor, bakedCursor;
+		for (float time : times)
+		{
+			const BonePose expected = sourceBone.SamplePose(time, sourceCursor);
+			const BonePose actual = bakedBone.SamplePose(time, bakedCursor);
+			report.maxPositionError = std::max(report.maxPositionError, KeyError(expected.translation, actual.translation));
+			report.maxRotationError = std::max(report.maxRotationError, KeyError(expected.rotation, actual.rotation));
+			report.maxScaleError = std::max(report.maxScaleError, KeyError(expected.scale, actual.scale));
+		}
+	}
+}
+
+// writes the clip of animation to path, report (optional) receives the sizes and the measured error
+inline bool BakeAnimationClip(const Animation& animation, const std::string& path, const ClipBakeSettings& settings = ClipBakeSettings(), ClipBakeReport* report = nullptr)
+{
+	const std::vector<AnimationNode>& nodes = animation.GetNodes();
+	const std::vector<Bone>& bones = animation.GetBones();
+	const float duration = animation.GetDuration();
+	const float ticksPerSecond = animation.GetTicksPerSecond() > 0.0f ? animation.GetTicksPerSecond() : 25.0f;
+	const bool uniform = settings.sampleRate > 0.0f;
+
+	ClipBakeReport result;
+	ClipWriter writer;
+	ClipFileHeader header = {};
+	writer.Append(&header, sizeof(header));
+	std::vector<ClipFileNode> fileNodes(nodes.size());
+	std::vector<ClipFileTrack> fileTracks(bones.size());
+	header.nodesOffset = writer.Append(fileNodes.data(), fileNodes.size() * sizeof(ClipFileNode));
+	header.tracksOffset = writer.Append(fileTracks.data(), fileTracks.size() * sizeof(ClipFileTrack));
+
+	std::vector<float> times;
+	std::vector<glm::vec3> vectors;
+	std::vector<glm::quat> rotations;
+	for (size_t t = 0; t < bones.size(); t++)
+	{
+		const Bone& bone = bones[t];
+		if (bone.IsBaked() || bone.GetPositionKeys().Size() == 0 || bone.GetRotationKeys().Size() == 0 || bone.GetScaleKeys().Size() == 0)
+		{
+			std::cout << "ERROR::ANIMATION_CLIP::TRACK_WITHOUT_KEYS: " << bone.GetBoneName() << std::endl;
+			return false;
+		}
+		ClipFileTrack& track = fileTracks[t];
+		track.boneID = bones[t].GetBoneID();
+
+		SelectKeys(bone.GetPositionKeys(), settings.positionTolerance, duration, ticksPerSecond, settings.sampleRate, times, vectors);
+		track.positions = WriteVec3Channel(writer, times, vectors, duration, uniform);
+		SelectKeys(bone.GetRotationKeys(), settings.rotationTolerance, duration, ticksPerSecond, settings.sampleRate, times, rotations);
+		track.rotations = WriteRotationChannel(writer, times, rotations, duration, uniform);
+		SelectKeys(bone.GetScaleKeys(), settings.scaleTolerance, duration, ticksPerSecond, settings.sampleRate, times, vectors);
+		track.scales = WriteVec3Channel(writer, times, vectors, duration, uniform);
+
+		result.sourceKeys += bone.GetPositionKeys().Size() + bone.GetRotationKeys().Size() + bone.GetScaleKeys().Size();
+		result.sourceKeyBytes += bone.GetPositionKeys().Size() * (sizeof(float) + sizeof(glm::vec3)) +
+			bone.GetRotationKeys().Size() * (sizeof(float) + sizeof(glm::quat)) + bone.GetScaleKeys().Size() * (sizeof(float) + sizeof(glm::vec3));
+		const ClipChannel* channels[3] = { &track.positions, &track.rotations, &track.scales };
+		for (const ClipChannel* channel : channels)
+		{
+			result.bakedKeys += channel->keyCount;
+			result.bakedKeyBytes += channel->keyCount * 3 * sizeof(uint16_t) + (channel->timesOffset ? channel->keyCount * sizeof(uint16_t) : 0);
+		}
+	}
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		fileNodes[i].transformation = nodes[i].transformation;
+		fileNodes[i].offset = nodes[i].offset;
+		fileNodes[i].parentIndex = nodes[i].parentIndex;
+		fileNodes[i].boneIndex = nodes[i].boneIndex;
+		fileNodes[i].trackIndex = animation.GetNodeTracks()[i];
+		fileNodes[i].nameOffset = writer.AppendString(animation.GetNodeName(static_cast<int>(i)));
+	}
+	for (size_t t = 0; t < bones.size(); t++)
+		fileTracks[t].nameOffset = writer.AppendString(bones[t].GetBoneName());
+	writer.Align();
+
+	memcpy(header.magic, CLIP_FILE_MAGIC, sizeof(header.magic));
+	header.version = CLIP_FILE_VERSION;
+	header.fileSize = static_cast<uint32_t>(writer.bytes.size());
+	header.duration = duration;
+	header.ticksPerSecond = ticksPerSecond;
+	header.nodeCount = static_cast<uint32_t>(nodes.size());
+	header.trackCount = static_cast<uint32_t>(bones.size());
+	memcpy(writer.bytes.data(), &header, sizeof(header));
+	if (!fileNodes.empty())
+		memcpy(writer.bytes.data() + header.nodesOffset, fileNodes.data(), fileNodes.size() * sizeof(ClipFileNode));
+	if (!fileTracks.empty())
+		memcpy(writer.bytes.data() + header.tracksOffset, fileTracks.data(), fileTracks.size() * sizeof(ClipFileTrack));
+	result.fileBytes = writer.bytes.size();
+
+	if (report)
+	{
+		Animation baked = CreateAnimationFromClip(writer.bytes.data(), animation.GetSkeleton());
+		MeasureClipError(animation, baked, result);
+		*report = result;
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(writer.bytes.data()), writer.bytes.size());
+	if (!file)
+	{
+		std::cout << "ERROR::ANIMATION_CLIP::FILE_NOT_SUCCESSFULLY_WRITTEN: " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/* A baked clip mapped into memory, its Animation reads the keys straight from the mapping */
+class AnimationClipFile
+{
+public:
+	AnimationClipFile() = default;
+	explicit AnimationClipFile(const std::string& path) { Open(path); }
+	~AnimationClipFile() { Close(); }
+
+	AnimationClipFile(const AnimationClipFile&) = delete;
+	AnimationClipFile& operator=(const AnimationClipFile&) = delete;
+
+	bool Open(const std::string& path)
+	{
+		Close();
+#ifdef _WIN32
+		m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		LARGE_INTEGER size;
+		if (m_File != INVALID_HANDLE_VALUE && GetFileSizeEx(m_File, &size) && size.QuadPart > 0)
+		{
+			m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (m_Mapping)
+			{
+				m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+				m_Size = static_cast<size_t>(size.QuadPart);
+			}
+		}
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if (file >= 0 && fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* mapped = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED)
+			{
+				m_Data = static_cast<const unsigned char*>(mapped);
+				m_Size = static_cast<size_t>(info.st_size);
+			}
+		}
+		if (file >= 0)
+			close(file); // the mapping stays valid
+#endif
+		if (!m_Data)
+		{
+			std::cout << "ERROR::ANIMATION_CLIP::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+			Close();
+			return false;
+		}
+		if (!ValidateClipData(m_Data, m_Size))
+		{
+			std::cout << "ERROR::ANIMATION_CLIP::INVALID_FILE: " << path << std::endl;
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		if (m_File != INVALID_HANDLE_VALUE)
+			CloseHandle(m_File);
+		m_Mapping = NULL;
+		m_File = INVALID_HANDLE_VALUE;
+#else
+		if (m_Data)
+			munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	size_t GetSize() const { return m_Size; }
+
+	// the file has to stay open while the animation is used, see CreateAnimationFromClip for skeleton
+	Animation CreateAnimation(std::shared_ptr<const Skeleton> skeleton = nullptr) const { return CreateAnimationFromClip(m_Data, skeleton); }
+
+private:
+	const unsigned char* m_Data = nullptr;
+	size_t m_Size = 0;
+#ifdef _WIN32
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = NULL;
+#endif
+};
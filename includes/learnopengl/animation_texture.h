@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/animator.h>
+
+/*
+	Final bone matrices of whole clips baked into one RGBA32F texture, so many skinned instances can be drawn
+	without an Animator per character. Each row is one sampled frame: three texels per bone holding the first
+	three rows of its matrix (the last row of an affine matrix is always 0 0 0 1). Clips of the same skeleton are
+	stacked below each other. An instance picks its clip and time offset with GetInstanceAnimation and the
+	vertex shader fetches and blends the two frames around its time (see anim_instanced.vs).
+*/
+class AnimationTexture
+{
+public:
+	unsigned int ID = 0;
+
+	AnimationTexture(const std::vector<Animation*>& clips, float framesPerSecond = 30.0f)
+	{
+		for (Animation* clip : clips)
+			m_BoneCount = std::max(m_BoneCount, clip->GetBoneMatrixCount());
+
+		// a clip of n frames covers its duration with n - 1 intervals, the last frame equals the first when it loops
+		int rows = 0;
+		for (Animation* clip : clips)
+		{
+			const float seconds = clip->GetDuration() / (clip->GetTicksPerSecond() > 0.0f ? clip->GetTicksPerSecond() : 25.0f);
+			ClipRows info;
+			info.firstRow = rows;
+			info.frameCount = std::max(2, static_cast<int>(std::ceil(seconds * framesPerSecond)) + 1);
+			info.framesPerSecond = seconds > 0.0f ? (info.frameCount - 1) / seconds : framesPerSecond;
+			m_Clips.push_back(info);
+			rows += info.frameCount;
+		}
+
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		const int width = m_BoneCount * 3;
+		if (width == 0 || width > maxSize || rows > maxSize)
+		{
+			std::cout << "ERROR::ANIMATION_TEXTURE::TOO_LARGE: " << width << " x " << rows << std::endl;
+			return;
+		}
+
+		std::vector<glm::vec4> texels(static_cast<size_t>(width) * rows, glm::vec4(0.0f));
+		for (size_t c = 0; c < clips.size(); c++)
+		{
+			Animator animator(clips[c]);
+			const ClipRows& info = m_Clips[c];
+			for (int frame = 0; frame < info.frameCount; frame++)
+			{
+				animator.SetCurrentTime(clips[c]->GetDuration() * frame / (info.frameCount - 1));
+				animator.CalculateBoneTransforms();
+				const std::vector<glm::mat4>& matrices = animator.GetFinalBoneMatrices();
+				glm::vec4* row = &texels[static_cast<size_t>(info.firstRow + frame) * width];
+				for (int bone = 0; bone < m_BoneCount; bone++)
+				{
+					const glm::mat4 transposed = glm::transpose(bone < static_cast<int>(matrices.size()) ? matrices[bone] : glm::mat4(1.0f));
+					row[bone * 3 + 0] = transposed[0];
+					row[bone * 3 + 1] = transposed[1];
+					row[bone * 3 + 2] = transposed[2];
+				}
+			}
+		}
+
+		// fetched with texelFetch, the shader blends frames itself
+		glGenTextures(1, &ID);
+		glBindTexture(GL_TEXTURE_2D, ID);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, rows, 0, GL_RGBA, GL_FLOAT, texels.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		m_Rows = rows;
+	}
+
+	~AnimationTexture()
+	{
+		if (ID)
+			glDeleteTextures(1, &ID);
+	}
+
+	AnimationTexture(const AnimationTexture&) = delete;
+	AnimationTexture& operator=(const AnimationTexture&) = delete;
+
+	void Bind(unsigned int unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, ID);
+	}
+
+	// per instance attribute for the vertex shader: first row and frame count of the clip, frames per second
+	// (scaled by speed) and the time offset in seconds
+	glm::vec4 GetInstanceAnimation(int clip, float timeOffset, float speed = 1.0f) const
+	{
+		const ClipRows& info = m_Clips[clip];
+		return glm::vec4(static_cast<float>(info.firstRow), static_cast<float>(info.frameCount), info.framesPerSecond * speed, timeOffset);
+	}
+
+	int GetClipCount() const { return static_cast<int>(m_Clips.size()); }
+	int GetBoneCount() const { return m_BoneCount; }
+	size_t GetSizeInBytes() const { return static_cast<size_t>(m_BoneCount) * 3 * m_Rows * sizeof(glm::vec4); }
+
+private:
+	struct ClipRows
+	{
+		int firstRow;
+		int frameCount;
+		float framesPerSecond;
+	};
+
+	std::vector<ClipRows> m_Clips;
+	int m_BoneCount = 0;
+	int m_Rows = 0;
+};
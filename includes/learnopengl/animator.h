@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <vector>
 #include <assimp/scene.h>
@@ -8,73 +10,588 @@
 #include <learnopengl/animation.h>
 #include <learnopengl/bone.h>
 
+/* Weight per compiled node of the animator's skeleton for a layer, see Animator::CreateBoneMask */
+typedef std::vector<float> BoneMask;
+
+/*
+	Plays one clip or blends several in local space: the base pose is a weighted blend of any number of clips
+	(cross-fades are a blend whose weights move over time), layers are applied on top of it, either replacing
+	the pose they reach (override) or adding their offset from their own first frame (additive), optionally
+	limited to some nodes by a mask. All clips must belong to the skeleton of the animation the animator was
+	created with / last hard cut to, they are matched to its nodes by name (clips sharing its Skeleton use their
+	own node tracks as they are). Skeletons and clips are only read, an animator itself holds the playback state:
+	clip times and weights, key cursors and the final bone matrices. The per node scratch of an update is per
+	thread and shared by every animator updated on it, it only grows the first time a larger skeleton comes by.
+*/
 class Animator
 {
 public:
-	Animator(Animation* animation)
+	Animator(const Animation* animation)
 	{
-		m_CurrentTime = 0.0;
-		m_CurrentAnimation = animation;
-
-		m_FinalBoneMatrices.reserve(100);
+		PlayAnimation(animation);
+	}
 
-		for (int i = 0; i < 100; i++)
-			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+	// writes the final bone matrices into palette instead (e.g. this character's slice of one contiguous crowd
+	// buffer). palette needs animation->GetBoneMatrixCount() matrices and has to outlive the animator.
+	Animator(const Animation* animation, glm::mat4* palette)
+	{
+		m_ExternalPalette = palette;
+		PlayAnimation(animation);
 	}
 
 	void UpdateAnimation(float dt)
 	{
 		m_DeltaTime = dt;
-		if (m_CurrentAnimation)
+		m_Evaluated = false;
+		if (!m_CurrentAnimation)
+			return;
+		if (m_UpdateInterval <= 0.0f)
 		{
-			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+			AdvanceClips(dt);
+			CalculateBoneTransforms();
+			m_Evaluated = true;
+			return;
 		}
+
+		// fixed rate: evaluate once per elapsed step (a single time after a hitch), blend the last two in between
+		m_Accumulator += dt;
+		if (m_Accumulator >= m_UpdateInterval)
+		{
+			const float steps = std::floor(m_Accumulator / m_UpdateInterval);
+			m_Accumulator -= steps * m_UpdateInterval;
+			AdvanceClips(steps * m_UpdateInterval);
+			CalculateBoneTransforms();
+			m_PreviousPalette.swap(m_CurrentPalette);
+			std::copy(GetPalette(), GetPalette() + m_CurrentPalette.size(), m_CurrentPalette.begin());
+			if (steps > 1.0f)
+				m_PreviousPalette = m_CurrentPalette;
+			m_Evaluated = true;
+		}
+		InterpolatePalette(m_Accumulator / m_UpdateInterval);
 	}
 
-	void PlayAnimation(Animation* pAnimation)
+	// Evaluates the skeleton updatesPerSecond times a second instead of on every UpdateAnimation, which only
+	// interpolates the bone matrices of the last two evaluations in between: the palette shows the pose of one
+	// step ago. Lower rates suit distant characters. phase in [0, 1) offsets when the steps fall so characters
+	// with the same rate don't all evaluate in the same frame. 0 evaluates on every update (the default).
+	void SetUpdateRate(float updatesPerSecond, float phase = 0.0f)
 	{
+		const float interval = updatesPerSecond > 0.0f ? 1.0f / updatesPerSecond : 0.0f;
+		if (interval == m_UpdateInterval)
+			return;
+		const bool starting = m_UpdateInterval <= 0.0f;
+		m_UpdateInterval = interval;
+		if (interval <= 0.0f)
+			return;
+		if (starting)
+		{
+			// both poses start at the current one
+			m_Accumulator = phase * interval;
+			AllocateTransforms();
+			if (m_CurrentAnimation)
+			{
+				CalculateBoneTransforms();
+				std::copy(GetPalette(), GetPalette() + m_CurrentPalette.size(), m_CurrentPalette.begin());
+				m_PreviousPalette = m_CurrentPalette;
+			}
+		}
+		else
+		{
+			m_Accumulator = std::min(m_Accumulator, interval);
+		}
+	}
+
+	float GetUpdateRate() const { return m_UpdateInterval > 0.0f ? 1.0f / m_UpdateInterval : 0.0f; }
+
+	// whether the last UpdateAnimation evaluated the skeleton, false when it only interpolated
+	bool WasEvaluated() const { return m_Evaluated; }
+
+	// hard cut: pAnimation replaces every clip of the base blend (layers keep playing)
+	void PlayAnimation(const Animation* pAnimation)
+	{
+		if (m_ExternalPalette && m_CurrentAnimation && pAnimation->GetBoneMatrixCount() > m_CurrentAnimation->GetBoneMatrixCount())
+		{
+			std::cout << "ERROR::ANIMATOR::PALETTE_TOO_SMALL" << std::endl;
+			return;
+		}
 		m_CurrentAnimation = pAnimation;
-		m_CurrentTime = 0.0f;
+		m_ClipCount = 0;
+		if (!m_CurrentAnimation)
+			return;
+		AllocateTransforms();
+		for (Layer& layer : m_Layers)
+			MapClip(layer.clip);
+		AddClip(pAnimation, 1.0f);
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+	// blends from the clips playing now to next over duration seconds, next starts at its beginning unless it
+	// is still playing (e.g. fading out from an earlier cross-fade)
+	void CrossFade(const Animation* next, float duration)
 	{
-		std::string nodeName = node->name;
-		glm::mat4 nodeTransform = node->transformation;
+		if (!m_CurrentAnimation || duration <= 0.0f)
+		{
+			PlayAnimation(next);
+			return;
+		}
+		const int index = AddClip(next, 0.0f);
+		for (int i = 0; i < m_ClipCount; i++)
+		{
+			m_Clips[i].targetWeight = i == index ? 1.0f : 0.0f;
+			m_Clips[i].fadeSpeed = 1.0f / duration;
+		}
+	}
 
-		Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
+	// N-way blend: adds animation to the base blend (or finds it) and returns its clip index. The weights of
+	// the clips are normalized, so they don't have to add up to one.
+	int AddClip(const Animation* animation, float weight)
+	{
+		for (int i = 0; i < m_ClipCount; i++)
+		{
+			if (m_Clips[i].animation == animation)
+				return i;
+		}
+		// reuse a slot of a clip that faded out, its vectors keep their capacity
+		if (m_ClipCount == static_cast<int>(m_Clips.size()))
+			m_Clips.push_back(ClipState());
+		ClipState& clip = m_Clips[m_ClipCount];
+		clip.animation = animation;
+		clip.time = 0.0f;
+		clip.weight = clip.targetWeight = weight;
+		clip.fadeSpeed = 0.0f;
+		MapClip(clip);
+		return m_ClipCount++;
+	}
+
+	// sets the weight of a clip of the base blend right away (and stops its fade), e.g. every frame from the
+	// character's speed. A clip at weight 0 stays in the blend until RemoveClip.
+	void SetClipWeight(const Animation* animation, float weight)
+	{
+		for (int i = 0; i < m_ClipCount; i++)
+		{
+			if (m_Clips[i].animation == animation)
+			{
+				m_Clips[i].weight = m_Clips[i].targetWeight = weight;
+				m_Clips[i].fadeSpeed = 0.0f;
+			}
+		}
+	}
 
-		if (Bone)
+	void RemoveClip(const Animation* animation)
+	{
+		for (int i = 0; i < m_ClipCount; i++)
 		{
-			Bone->Update(m_CurrentTime);
-			nodeTransform = Bone->GetLocalTransform();
+			if (m_Clips[i].animation == animation)
+			{
+				RemoveClipAt(i);
+				return;
+			}
 		}
+	}
 
-		glm::mat4 globalTransformation = parentTransform * nodeTransform;
+	int GetClipCount() const { return m_ClipCount; }
 
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+	// a clip applied on top of the base blend, weighted by weight * mask[node] (an empty mask covers every node).
+	// An override layer blends toward its own pose, an additive layer adds the difference between its pose
+	// and its first frame (breathing, leaning, recoil...). Returns the index for SetLayerWeight.
+	int AddLayer(const Animation* animation, float weight, bool additive, const BoneMask& mask = BoneMask())
+	{
+		if (!mask.empty() && mask.size() != m_CurrentAnimation->GetNodes().size())
+			std::cout << "ERROR::ANIMATOR::MASK_SIZE_MISMATCH" << std::endl;
+
+		m_Layers.push_back(Layer());
+		Layer& layer = m_Layers.back();
+		layer.clip.animation = animation;
+		layer.clip.weight = layer.clip.targetWeight = weight;
+		layer.additive = additive;
+		layer.mask = mask;
+		MapClip(layer.clip);
+		return static_cast<int>(m_Layers.size()) - 1;
+	}
+
+	// fades the layer to weight over duration seconds, 0 sets it right away
+	void SetLayerWeight(int layer, float weight, float duration = 0.0f)
+	{
+		ClipState& clip = m_Layers[layer].clip;
+		clip.targetWeight = weight;
+		clip.fadeSpeed = duration > 0.0f ? 1.0f / duration : 0.0f;
+		if (duration <= 0.0f)
+			clip.weight = weight;
+	}
+
+	int GetLayerCount() const { return static_cast<int>(m_Layers.size()); }
+
+	// weight for the named node and everything below it, 0 for the rest (e.g. "upper body" from the spine)
+	BoneMask CreateBoneMask(const std::string& nodeName, float weight = 1.0f) const
+	{
+		const std::vector<AnimationNode>& nodes = m_CurrentAnimation->GetNodes();
+		BoneMask mask(nodes.size(), 0.0f);
+		std::vector<bool> inside(nodes.size(), false);
+		for (size_t i = 0; i < nodes.size(); i++)
 		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
-			m_FinalBoneMatrices[index] = globalTransformation * offset;
+			// parents come first, so a node is inside once its parent is
+			inside[i] = m_CurrentAnimation->GetNodeName(static_cast<int>(i)) == nodeName || (nodes[i].parentIndex >= 0 && inside[nodes[i].parentIndex]);
+			if (inside[i])
+				mask[i] = weight;
 		}
+		return mask;
+	}
+
+	// walks the compiled nodes of the animation in order, parents are always evaluated before their children.
+	// the clips are only read (the key cursors live in the animator), so animators sharing them can run in parallel.
+	void CalculateBoneTransforms()
+	{
+		const std::vector<AnimationNode>& nodes = m_CurrentAnimation->GetNodes();
+		glm::mat4* palette = m_ExternalPalette ? m_ExternalPalette : m_FinalBoneMatrices.data();
+		Scratch& scratch = GetScratch(nodes.size());
+		std::vector<glm::mat4>& globalTransforms = scratch.globalTransforms;
+
+		// a single clip without layers goes straight from the keys to matrices
+		const bool blended = m_ClipCount != 1 || HasActiveLayers();
+		if (blended)
+			BlendLocalPoses(scratch.localPoses);
+		ClipState* clip = m_ClipCount ? &m_Clips[0] : nullptr;
+		const Bone* bones = clip ? clip->animation->GetBones().data() : nullptr;
+		const int* tracks = clip ? GetTracks(*clip) : nullptr;
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const AnimationNode& node = nodes[i];
+			glm::mat4 nodeTransform = node.transformation;
+
+			if (blended)
+			{
+				nodeTransform = PoseToMatrix(scratch.localPoses[i]);
+			}
+			else
+			{
+				const int track = tracks[i];
+				if (track >= 0)
+					nodeTransform = bones[track].SampleLocalTransform(clip->time, clip->cursors[track]);
+			}
+
+			globalTransforms[i] = node.parentIndex < 0 ? nodeTransform : globalTransforms[node.parentIndex] * nodeTransform;
 
-		for (int i = 0; i < node->childrenCount; i++)
-			CalculateBoneTransform(&node->children[i], globalTransformation);
+			if (node.boneIndex >= 0)
+			{
+				palette[node.boneIndex] = globalTransforms[i] * node.offset;
+				if (m_DualQuaternionSkinning)
+					m_FinalDualQuaternions[node.boneIndex] = MatrixToDualQuaternion(palette[node.boneIndex]);
+			}
+		}
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	// empty when the animator plays into an external palette, use GetPalette then
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
 		return m_FinalBoneMatrices;
 	}
 
+	const glm::mat4* GetPalette() const { return m_ExternalPalette ? m_ExternalPalette : m_FinalBoneMatrices.data(); }
+
+	// also keep every bone as a unit dual quaternion (see MatrixToDualQuaternion): half the palette of matrices
+	// to upload, and blending them in the vertex shader keeps the volume of twisted joints (no candy wrapper).
+	// Only for rigs whose final bone matrices are rigid, scale is dropped.
+	void SetDualQuaternionSkinning(bool enabled)
+	{
+		m_DualQuaternionSkinning = enabled;
+		AllocateTransforms();
+		if (enabled && m_CurrentAnimation)
+			CalculateBoneTransforms();
+	}
+
+	// empty unless SetDualQuaternionSkinning(true), upload with glUniformMatrix2x4fv
+	const std::vector<glm::mat2x4>& GetFinalDualQuaternions() const
+	{
+		return m_FinalDualQuaternions;
+	}
+
+	// time in ticks of the first clip of the base blend (the longest playing one)
+	float GetCurrentTime() const { return m_ClipCount ? m_Clips[0].time : 0.0f; }
+	void SetCurrentTime(float time)
+	{
+		if (m_ClipCount)
+			m_Clips[0].time = time;
+	}
+
+	// memory held by this animator alone (not the shared skeleton and clips, nor an external palette)
+	size_t GetSizeInBytes() const
+	{
+		size_t size = sizeof(Animator) + m_FinalBoneMatrices.capacity() * sizeof(glm::mat4) + m_FinalDualQuaternions.capacity() * sizeof(glm::mat2x4) +
+			(m_PreviousPalette.capacity() + m_CurrentPalette.capacity()) * sizeof(glm::mat4) + m_Clips.capacity() * sizeof(ClipState) + m_Layers.capacity() * sizeof(Layer);
+		for (const ClipState& clip : m_Clips)
+			size += clip.tracks.capacity() * sizeof(int) + clip.cursors.capacity() * sizeof(BoneCursor);
+		for (const Layer& layer : m_Layers)
+			size += layer.clip.tracks.capacity() * sizeof(int) + layer.clip.cursors.capacity() * sizeof(BoneCursor) +
+				layer.mask.capacity() * sizeof(float) + layer.reference.capacity() * sizeof(BonePose);
+		return size;
+	}
+
 private:
+	struct ClipState
+	{
+		const Animation* animation = nullptr;
+		float time = 0.0f; // in ticks of animation
+		float weight = 0.0f;
+		float targetWeight = 0.0f;
+		float fadeSpeed = 0.0f; // weight change per second towards targetWeight, 0 when not fading
+		std::vector<int> tracks; // per node of m_CurrentAnimation: index in animation->GetBones(), -1 if not animated. Empty when the clip shares its skeleton, see GetTracks
+		std::vector<BoneCursor> cursors; // per bone track of animation
+	};
+
+	struct Layer
+	{
+		ClipState clip;
+		bool additive = false;
+		BoneMask mask;
+		std::vector<BonePose> reference; // additive layers: the clip's first frame per node
+	};
+
+	// per update scratch, per node of the skeleton being evaluated
+	struct Scratch
+	{
+		std::vector<glm::mat4> globalTransforms;
+		std::vector<BonePose> localPoses;
+	};
+
+	static Scratch& GetScratch(size_t nodeCount)
+	{
+		thread_local Scratch scratch;
+		if (scratch.globalTransforms.size() < nodeCount)
+		{
+			scratch.globalTransforms.resize(nodeCount);
+			scratch.localPoses.resize(nodeCount);
+		}
+		return scratch;
+	}
+
+	// matches the clip's tracks to the nodes of m_CurrentAnimation, a clip of the same skeleton needs no copy
+	void MapClip(ClipState& clip)
+	{
+		const std::vector<AnimationNode>& nodes = m_CurrentAnimation->GetNodes();
+		if (clip.animation->GetSkeleton() == m_CurrentAnimation->GetSkeleton())
+		{
+			clip.tracks.clear();
+			clip.tracks.shrink_to_fit();
+		}
+		else
+		{
+			clip.tracks.resize(nodes.size());
+			for (size_t i = 0; i < nodes.size(); i++)
+				clip.tracks[i] = clip.animation->FindTrackIndex(m_CurrentAnimation->GetNodeName(static_cast<int>(i)));
+		}
+		clip.cursors.assign(clip.animation->GetBones().size(), BoneCursor());
+
+		for (Layer& layer : m_Layers)
+		{
+			if (&layer.clip != &clip || !layer.additive)
+				continue;
+			const std::vector<BonePose>& bindPoses = m_CurrentAnimation->GetBindPoses();
+			const int* tracks = GetTracks(clip);
+			layer.reference.resize(nodes.size());
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				BoneCursor cursor;
+				const int track = tracks[i];
+				layer.reference[i] = track >= 0 ? clip.animation->GetBones()[track].SamplePose(0.0f, cursor) : bindPoses[i];
+			}
+		}
+	}
+
+	static const int* GetTracks(const ClipState& clip)
+	{
+		return clip.tracks.empty() ? clip.animation->GetNodeTracks().data() : clip.tracks.data();
+	}
+
+	void RemoveClipAt(int index)
+	{
+		// keeps the order (clip 0 is the longest playing one), the slot moves to the back for reuse
+		std::rotate(m_Clips.begin() + index, m_Clips.begin() + index + 1, m_Clips.begin() + m_ClipCount);
+		m_ClipCount--;
+	}
+
+	static void AdvanceClip(ClipState& clip, float dt)
+	{
+		clip.time += clip.animation->GetTicksPerSecond() * dt;
+		clip.time = fmod(clip.time, clip.animation->GetDuration());
+		if (clip.fadeSpeed > 0.0f)
+		{
+			const float step = clip.fadeSpeed * dt;
+			if (std::abs(clip.targetWeight - clip.weight) <= step)
+			{
+				clip.weight = clip.targetWeight;
+				clip.fadeSpeed = 0.0f;
+			}
+			else
+			{
+				clip.weight += clip.targetWeight > clip.weight ? step : -step;
+			}
+		}
+	}
+
+	void AdvanceClips(float dt)
+	{
+		for (int i = 0; i < m_ClipCount; i++)
+		{
+			const bool fading = m_Clips[i].fadeSpeed > 0.0f;
+			AdvanceClip(m_Clips[i], dt);
+			// clips that finished fading out leave the blend
+			if (fading && m_Clips[i].fadeSpeed == 0.0f && m_Clips[i].weight <= 0.0f)
+				RemoveClipAt(i--);
+		}
+		for (Layer& layer : m_Layers)
+			AdvanceClip(layer.clip, dt);
+	}
+
+	bool HasActiveLayers() const
+	{
+		for (const Layer& layer : m_Layers)
+		{
+			if (layer.clip.weight > 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	static glm::quat Nlerp(const glm::quat& a, const glm::quat& b, float factor)
+	{
+		// through the shorter arc
+		const float sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+		return glm::normalize(a * (1.0f - factor) + b * (factor * sign));
+	}
+
+	// the base blend into localPoses, then the layers on top of it
+	void BlendLocalPoses(std::vector<BonePose>& localPoses)
+	{
+		const std::vector<BonePose>& bindPoses = m_CurrentAnimation->GetBindPoses();
+		const size_t nodeCount = bindPoses.size();
+
+		float totalWeight = 0.0f;
+		for (int c = 0; c < m_ClipCount; c++)
+			totalWeight += std::max(0.0f, m_Clips[c].weight);
+
+		// weighted sums, rotations flipped to the hemisphere of the first clip and normalized afterwards
+		// (nlerp generalized to N clips)
+		bool first = true;
+		for (int c = 0; c < m_ClipCount; c++)
+		{
+			ClipState& clip = m_Clips[c];
+			if (clip.weight <= 0.0f)
+				continue;
+			const float weight = clip.weight / totalWeight;
+			const Bone* bones = clip.animation->GetBones().data();
+			const int* tracks = GetTracks(clip);
+			for (size_t i = 0; i < nodeCount; i++)
+			{
+				const int track = tracks[i];
+				const BonePose pose = track >= 0 ? bones[track].SamplePose(clip.time, clip.cursors[track]) : bindPoses[i];
+				BonePose& blended = localPoses[i];
+				if (first)
+				{
+					blended.translation = pose.translation * weight;
+					blended.rotation = pose.rotation * weight;
+					blended.scale = pose.scale * weight;
+				}
+				else
+				{
+					blended.translation += pose.translation * weight;
+					blended.rotation = blended.rotation + pose.rotation * (glm::dot(blended.rotation, pose.rotation) < 0.0f ? -weight : weight);
+					blended.scale += pose.scale * weight;
+				}
+			}
+			first = false;
+		}
+
+		if (first)
+		{
+			std::copy(bindPoses.begin(), bindPoses.end(), localPoses.begin());
+		}
+		else
+		{
+			for (size_t i = 0; i < nodeCount; i++)
+				localPoses[i].rotation = glm::normalize(localPoses[i].rotation);
+		}
+
+		for (Layer& layer : m_Layers)
+		{
+			ClipState& clip = layer.clip;
+			if (clip.weight <= 0.0f)
+				continue;
+			const Bone* bones = clip.animation->GetBones().data();
+			const int* tracks = GetTracks(clip);
+			for (size_t i = 0; i < nodeCount; i++)
+			{
+				const int track = tracks[i];
+				const float weight = clip.weight * (i < layer.mask.size() ? layer.mask[i] : 1.0f);
+				// nodes the layer doesn't animate keep the pose below it
+				if (track < 0 || weight <= 0.0f)
+					continue;
+
+				const BonePose pose = bones[track].SamplePose(clip.time, clip.cursors[track]);
+				BonePose& blended = localPoses[i];
+				if (layer.additive)
+				{
+					const BonePose& reference = layer.reference[i];
+					blended.translation += (pose.translation - reference.translation) * weight;
+					blended.rotation = glm::normalize(blended.rotation * Nlerp(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::conjugate(reference.rotation) * pose.rotation, weight));
+					blended.scale *= glm::mix(glm::vec3(1.0f), pose.scale / reference.scale, weight);
+				}
+				else
+				{
+					const float factor = std::min(weight, 1.0f);
+					blended.translation = glm::mix(blended.translation, pose.translation, factor);
+					blended.rotation = Nlerp(blended.rotation, pose.rotation, factor);
+					blended.scale = glm::mix(blended.scale, pose.scale, factor);
+				}
+			}
+		}
+	}
+
+	// palette = mix(previous, current, factor), linear per matrix element: for the small rotations between two
+	// steps the shrinking is far below what the skin shows
+	void InterpolatePalette(float factor)
+	{
+		glm::mat4* palette = m_ExternalPalette ? m_ExternalPalette : m_FinalBoneMatrices.data();
+		for (size_t i = 0; i < m_CurrentPalette.size(); i++)
+		{
+			const glm::mat4& previous = m_PreviousPalette[i];
+			const glm::mat4& current = m_CurrentPalette[i];
+			for (int c = 0; c < 4; c++)
+				palette[i][c] = previous[c] + (current[c] - previous[c]) * factor;
+			if (m_DualQuaternionSkinning)
+				m_FinalDualQuaternions[i] = MatrixToDualQuaternion(palette[i]);
+		}
+	}
+
+	// sized once per skeleton so updating never allocates
+	void AllocateTransforms()
+	{
+		if (!m_CurrentAnimation)
+			return;
+		if (!m_ExternalPalette && m_CurrentAnimation->GetBoneMatrixCount() > static_cast<int>(m_FinalBoneMatrices.size()))
+			m_FinalBoneMatrices.resize(m_CurrentAnimation->GetBoneMatrixCount(), glm::mat4(1.0f));
+		// as many as the matrices, identity is rotation (0 0 0 1) without translation
+		const size_t dualQuaternionCount = std::max<size_t>(m_CurrentAnimation->GetBoneMatrixCount(), m_FinalBoneMatrices.size());
+		if (m_DualQuaternionSkinning && dualQuaternionCount > m_FinalDualQuaternions.size())
+			m_FinalDualQuaternions.resize(dualQuaternionCount, glm::mat2x4(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f)));
+		if (m_UpdateInterval > 0.0f)
+		{
+			m_PreviousPalette.resize(m_CurrentAnimation->GetBoneMatrixCount(), glm::mat4(1.0f));
+			m_CurrentPalette.resize(m_CurrentAnimation->GetBoneMatrixCount(), glm::mat4(1.0f));
+		}
+	}
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
-	Animation* m_CurrentAnimation;
-	float m_CurrentTime;
+	std::vector<ClipState> m_Clips; // the base blend, the first m_ClipCount are playing
+	int m_ClipCount = 0;
+	std::vector<Layer> m_Layers;
+	glm::mat4* m_ExternalPalette = nullptr;
+	bool m_DualQuaternionSkinning = false;
+	std::vector<glm::mat2x4> m_FinalDualQuaternions;
+	float m_UpdateInterval = 0.0f; // seconds between evaluations, 0 for every update
+	float m_Accumulator = 0.0f; // time since the last evaluation
+	bool m_Evaluated = false;
+	std::vector<glm::mat4> m_PreviousPalette, m_CurrentPalette; // the last two evaluated palettes at a fixed rate
+	const Animation* m_CurrentAnimation = nullptr; // the skeleton: its nodes are what every clip is mapped to
 	float m_DeltaTime;
 
 };
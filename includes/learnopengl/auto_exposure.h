@@ -0,0 +1,103 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader_c.h>
+
+// Shader storage binding of the histogram, shared by both compute passes
+const unsigned int LUMINANCE_HISTOGRAM_BINDING = 0;
+const unsigned int LUMINANCE_HISTOGRAM_BINS    = 256;
+
+// Automatic exposure from a log luminance histogram, entirely on the GPU. The first pass sorts every pixel of the
+// HDR buffer into 256 bins between minLogLuminance and maxLogLuminance (bin 0 takes the black pixels), counting into
+// shared memory first so each workgroup adds only 256 global atomics. The second pass averages the log luminance
+// of the bins between lowPercentile and highPercentile of the non-black pixels, so a few very dark or bright
+// pixels (the sky, a light source) don't pull the exposure around, and adapts the result to it over time, faster
+// towards brighter than towards darker scenes like an eye. It also clears the histogram for the next frame.
+// The result is a 1x1 RG32F texture: the exposure (keyValue / adapted luminance) in red and the adapted luminance in
+// green, read by the tonemapping shaders with texelFetch, so the CPU never waits for a readback.
+class AutoExposure
+{
+public:
+    float minLogLuminance = -8.0f; // log2 of the darkest luminance still told apart from black
+    float maxLogLuminance = 4.0f;
+    float lowPercentile = 0.1f;    // share of the darkest pixels left out of the average
+    float highPercentile = 0.95f;  // pixels above this share are left out as well
+    float speedUp = 3.0f;          // adaptation rate (per second) towards brighter scenes
+    float speedDown = 1.0f;        // and towards darker ones
+    float keyValue = 0.5f;         // what the adapted average luminance is mapped to before tonemapping
+
+    AutoExposure(const char* histogramPath, const char* averagePath)
+        : histogramShader(histogramPath), averageShader(averagePath)
+    {
+        // zeroed once, the average pass clears it again after reading
+        const GLuint zeros[LUMINANCE_HISTOGRAM_BINS] = { 0 };
+        glGenBuffers(1, &histogramBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, histogramBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zeros), zeros, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // adapted luminance 0 tells the average pass to start from the current frame instead of adapting
+        const float initial[2] = { 1.0f, 0.0f };
+        glGenTextures(1, &exposureTexture);
+        glBindTexture(GL_TEXTURE_2D, exposureTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32F, 1, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RG, GL_FLOAT, initial);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        histogramShader.use();
+        histogramShader.setInt("hdrBuffer", 0);
+    }
+
+    ~AutoExposure()
+    {
+        glDeleteBuffers(1, &histogramBuffer);
+        glDeleteTextures(1, &exposureTexture);
+        glDeleteProgram(histogramShader.ID);
+        glDeleteProgram(averageShader.ID);
+    }
+
+    AutoExposure(const AutoExposure&) = delete;
+    AutoExposure& operator=(const AutoExposure&) = delete;
+
+    // measures hdrTexture (width x height) and adapts the exposure by deltaTime seconds; returns the exposure texture
+    unsigned int update(unsigned int hdrTexture, unsigned int width, unsigned int height, float deltaTime)
+    {
+        const float logRange = maxLogLuminance - minLogLuminance;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LUMINANCE_HISTOGRAM_BINDING, histogramBuffer);
+
+        histogramShader.use();
+        histogramShader.setFloat("minLogLuminance", minLogLuminance);
+        histogramShader.setFloat("inverseLogRange", 1.0f / logRange);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hdrTexture);
+        glDispatchCompute((width + 15) / 16, (height + 15) / 16, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        averageShader.use();
+        averageShader.setFloat("minLogLuminance", minLogLuminance);
+        averageShader.setFloat("logRange", logRange);
+        averageShader.setFloat("lowPercentile", lowPercentile);
+        averageShader.setFloat("highPercentile", highPercentile);
+        averageShader.setFloat("speedUp", speedUp);
+        averageShader.setFloat("speedDown", speedDown);
+        averageShader.setFloat("keyValue", keyValue);
+        averageShader.setFloat("deltaTime", deltaTime);
+        glBindImageTexture(0, exposureTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RG32F);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        return exposureTexture;
+    }
+
+    unsigned int getExposureTexture() const { return exposureTexture; }
+
+private:
+    ComputeShader histogramShader;
+    ComputeShader averageShader;
+    unsigned int histogramBuffer;
+    unsigned int exposureTexture;
+};
+#endif
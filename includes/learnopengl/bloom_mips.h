@@ -0,0 +1,191 @@
+#ifndef BLOOM_MIPS_H
+#define BLOOM_MIPS_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/render_graph.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Physically based bloom (Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare"). The HDR
+// scene is filtered down a chain of half size mips with a 13 tap filter, then the chain is walked back up, adding
+// each mip's tent filtered smaller neighbour to it. The wide part of the blur comes from the small mips, so no pass
+// touches more than a half resolution image and the whole chain costs about a third of a full resolution pass each
+// way, against the 10 full resolution passes of the ping-pong gaussian.
+// The first downsample weights its taps with the Karis average (by 1 / (1 + luminance)) so lone very bright pixels
+// don't flicker, and applies a soft threshold: with threshold 0 everything blooms, which is the energy conserving
+// (physically based) setting.
+class BloomMips
+{
+public:
+    static const unsigned int MAX_MIPS = 8;
+
+    BloomMips(const char* vertexPath, const char* downsamplePath, const char* upsamplePath, unsigned int width, unsigned int height)
+        : downsampleShader(vertexPath, downsamplePath), upsampleShader(vertexPath, upsamplePath)
+    {
+        glGenVertexArrays(1, &emptyVAO); // the passes draw one screen covering triangle from gl_VertexID
+        unsigned int mipWidth = width, mipHeight = height;
+        for (unsigned int i = 0; i < MAX_MIPS && mipWidth > 1 && mipHeight > 1; i++)
+        {
+            Mip mip;
+            mip.texture = 0; // render() creates the chain the first time, render graphs bring their own
+            mip.width = mipWidth = mipWidth / 2;
+            mip.height = mipHeight = mipHeight / 2;
+            mips.push_back(mip);
+        }
+
+        downsampleShader.use();
+        downsampleShader.setInt("source", 0);
+        upsampleShader.use();
+        upsampleShader.setInt("source", 0);
+    }
+
+    ~BloomMips()
+    {
+        for (const Mip& mip : mips)
+            glDeleteTextures(1, &mip.texture);
+        glDeleteFramebuffers(1, &framebuffer); // 0 (ignored) if render() was never called
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteProgram(downsampleShader.ID);
+        glDeleteProgram(upsampleShader.ID);
+    }
+
+    BloomMips(const BloomMips&) = delete;
+    BloomMips& operator=(const BloomMips&) = delete;
+
+    // the deepest chain this resolution allows
+    unsigned int getMipCount() const { return (unsigned int)mips.size(); }
+
+    // blooms hdrTexture through mipCount mips and returns the half resolution result; the sum of mipCount levels, so
+    // scale it by about 1 / mipCount when adding it to the scene. knee softens the threshold over [threshold - knee,
+    // threshold + knee], filterRadius scales the upsample tent (in texels of the mip it reads).
+    unsigned int render(unsigned int hdrTexture, unsigned int mipCount, float threshold, float knee, float filterRadius)
+    {
+        mipCount = std::max(1u, std::min(mipCount, getMipCount()));
+        if (framebuffer == 0)
+            createChain();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glBindVertexArray(emptyVAO);
+        glActiveTexture(GL_TEXTURE0);
+
+        downsampleShader.use();
+        downsampleShader.setFloat("threshold", threshold);
+        downsampleShader.setFloat("knee", knee);
+        unsigned int source = hdrTexture;
+        for (unsigned int i = 0; i < mipCount; i++)
+        {
+            downsampleShader.setBool("firstMip", i == 0);
+            drawInto(mips[i], source);
+            source = mips[i].texture;
+        }
+
+        // each mip keeps its own downsample and gets everything below it added on top
+        upsampleShader.use();
+        upsampleShader.setFloat("filterRadius", filterRadius);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (unsigned int i = mipCount - 1; i > 0; i--)
+            drawInto(mips[i - 1], mips[i].texture);
+        glDisable(GL_BLEND);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        return mips[0].texture;
+    }
+
+    // the same chain as passes of a render graph, one per mip and direction, with the mips transient textures of the
+    // graph instead of this object's own; returns the resource of the half resolution result
+    RenderGraph::Resource addPasses(RenderGraph& graph, RenderGraph::Resource hdrColor, unsigned int mipCount, float threshold, float knee, float filterRadius)
+    {
+        mipCount = std::max(1u, std::min(mipCount, getMipCount()));
+        std::vector<RenderGraph::Resource> chain;
+        for (unsigned int i = 0; i < mipCount; i++)
+            chain.push_back(graph.createTexture("bloom mip " + std::to_string(i), RenderGraphTexture(mips[i].width, mips[i].height, GL_R11F_G11F_B10F)));
+
+        for (unsigned int i = 0; i < mipCount; i++)
+        {
+            const RenderGraph::Resource source = i == 0 ? hdrColor : chain[i - 1];
+            graph.addPass("bloom downsample " + std::to_string(i), PASS_RASTER, [this, &graph, source, i, threshold, knee]() {
+                downsampleShader.use();
+                downsampleShader.setFloat("threshold", threshold);
+                downsampleShader.setFloat("knee", knee);
+                downsampleShader.setBool("firstMip", i == 0);
+                draw(graph.getTexture(source));
+            }).read(source).write(chain[i]);
+        }
+        for (unsigned int i = mipCount - 1; i > 0; i--)
+        {
+            const RenderGraph::Resource source = chain[i];
+            graph.addPass("bloom upsample " + std::to_string(i), PASS_RASTER, [this, &graph, source, filterRadius]() {
+                upsampleShader.use();
+                upsampleShader.setFloat("filterRadius", filterRadius);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                draw(graph.getTexture(source));
+                glDisable(GL_BLEND);
+            }).read(source).write(chain[i - 1], true);
+        }
+        return chain[0];
+    }
+
+private:
+    struct Mip
+    {
+        unsigned int texture;
+        unsigned int width, height;
+    };
+
+    Shader downsampleShader;
+    Shader upsampleShader;
+    std::vector<Mip> mips;
+    unsigned int framebuffer = 0;
+    unsigned int emptyVAO;
+
+    void createChain()
+    {
+        for (Mip& mip : mips)
+        {
+            glGenTextures(1, &mip.texture);
+            glBindTexture(GL_TEXTURE_2D, mip.texture);
+            // no alpha and a third of the bytes of RGBA16F, bloom never goes negative
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, mip.width, mip.height, 0, GL_RGB, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mips[0].texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::BLOOM_MIPS::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void drawInto(const Mip& target, unsigned int source)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+        glViewport(0, 0, target.width, target.height);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    // into the framebuffer and viewport the render graph set up
+    void draw(unsigned int source)
+    {
+        glBindVertexArray(emptyVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+};
+#endif
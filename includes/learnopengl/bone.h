@@ -5,27 +5,130 @@
 #include <vector>
 #include <assimp/scene.h>
 #include <list>
+#include <algorithm>
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 #include <learnopengl/assimp_glm_helpers.h>
+#include <learnopengl/clip_format.h>
 
-struct KeyPosition
+inline glm::vec3 InterpolateKey(const glm::vec3& a, const glm::vec3& b, float factor)
 {
-	glm::vec3 position;
-	float timeStamp;
-};
+	return glm::mix(a, b, factor);
+}
+
+// neighbouring keys are usually a few degrees apart, where nlerp is within 1e-4 radians of slerp without its
+// acos and sines
+inline glm::quat InterpolateKey(const glm::quat& a, const glm::quat& b, float factor)
+{
+	const float cosTheta = glm::dot(a, b);
+	if (std::abs(cosTheta) > 0.99f)
+		return glm::normalize(a * (1.0f - factor) + b * (cosTheta < 0.0f ? -factor : factor));
+	return glm::normalize(glm::slerp(a, b, factor));
+}
+
+// index of the key that starts the segment containing time, clamped to the first/last segment. cursor is the
+// caller's result of the previous lookup: forward playback only moves it by a key or two (amortized O(1)),
+// seeks and loop wrap-arounds fall back to a binary search.
+template<typename Time>
+int FindKeyInTimes(const Time* times, int keyCount, float time, int& cursor)
+{
+	const int lastSegment = keyCount - 2;
+	if (lastSegment <= 0)
+		return 0;
+
+	if (cursor >= 0 && cursor <= lastSegment && time >= times[cursor])
+	{
+		for (int step = 0; step < 4; ++step)
+		{
+			if (cursor == lastSegment || time < times[cursor + 1])
+				return cursor;
+			++cursor;
+		}
+	}
+
+	// first key after time, the segment starts one before it
+	const Time* next = std::upper_bound(times + 1, times + lastSegment + 1, time);
+	cursor = static_cast<int>(next - times) - 1;
+	return cursor;
+}
 
-struct KeyRotation
+/* Keyframes of one channel, times and values in separate arrays so the lookup only touches the times */
+template<typename T>
+struct KeyTrack
 {
-	glm::quat orientation;
-	float timeStamp;
+	std::vector<float> times;
+	std::vector<T> values;
+
+	int Size() const { return static_cast<int>(times.size()); }
+
+	int FindKey(float animationTime, int& cursor) const
+	{
+		return FindKeyInTimes(times.data(), Size(), animationTime, cursor);
+	}
+
+	// times before the first or after the last key hold the first/last value
+	T Sample(float animationTime, int& cursor) const
+	{
+		if (Size() == 1)
+			return values[0];
+
+		int p0Index = FindKey(animationTime, cursor);
+		int p1Index = p0Index + 1;
+		float framesDiff = times[p1Index] - times[p0Index];
+		float scaleFactor = framesDiff > 0.0f ? (animationTime - times[p0Index]) / framesDiff : 0.0f;
+		return InterpolateKey(values[p0Index], values[p1Index], glm::clamp(scaleFactor, 0.0f, 1.0f));
+	}
 };
 
-struct KeyScale
+/* Local transform of a node split into its parts, the space animations are blended in */
+struct BonePose
 {
+	glm::vec3 translation;
+	glm::quat rotation;
 	glm::vec3 scale;
-	float timeStamp;
+};
+
+// translation * rotation * scale, written out instead of two full matrix products
+inline glm::mat4 PoseToMatrix(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	glm::mat3 r = glm::toMat3(rotation);
+	return glm::mat4(glm::vec4(r[0] * scale.x, 0.0f), glm::vec4(r[1] * scale.y, 0.0f),
+		glm::vec4(r[2] * scale.z, 0.0f), glm::vec4(translation, 1.0f));
+}
+
+inline glm::mat4 PoseToMatrix(const BonePose& pose)
+{
+	return PoseToMatrix(pose.translation, pose.rotation, pose.scale);
+}
+
+// inverse of PoseToMatrix for matrices without shear
+inline BonePose MatrixToPose(const glm::mat4& transform)
+{
+	BonePose pose;
+	pose.translation = glm::vec3(transform[3]);
+	pose.scale = glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+	glm::mat3 rotation(glm::vec3(transform[0]) / pose.scale.x, glm::vec3(transform[1]) / pose.scale.y, glm::vec3(transform[2]) / pose.scale.z);
+	pose.rotation = glm::normalize(glm::quat_cast(rotation));
+	return pose;
+}
+
+// unit dual quaternion of a rigid transform for dual-quaternion skinning: column 0 is the rotation r, column 1
+// the translation part 0.5 * (t, 0) * r, both x y z w. Scale (and shear) of transform is dropped.
+inline glm::mat2x4 MatrixToDualQuaternion(const glm::mat4& transform)
+{
+	glm::mat3 rotation(glm::normalize(glm::vec3(transform[0])), glm::normalize(glm::vec3(transform[1])), glm::normalize(glm::vec3(transform[2])));
+	const glm::quat r = glm::normalize(glm::quat_cast(rotation));
+	const glm::quat d = glm::quat(0.0f, transform[3].x, transform[3].y, transform[3].z) * r * 0.5f;
+	return glm::mat2x4(glm::vec4(r.x, r.y, r.z, r.w), glm::vec4(d.x, d.y, d.z, d.w));
+}
+
+/* Last looked up key per track of one Bone, lets every animator play a shared clip with its own cursors */
+struct BoneCursor
+{
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
 };
 
 class Bone
@@ -37,152 +140,173 @@ public:
 		m_ID(ID),
 		m_LocalTransform(1.0f)
 	{
-		m_NumPositions = channel->mNumPositionKeys;
-
-		for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex)
+		m_Positions.times.reserve(channel->mNumPositionKeys);
+		m_Positions.values.reserve(channel->mNumPositionKeys);
+		for (unsigned int positionIndex = 0; positionIndex < channel->mNumPositionKeys; ++positionIndex)
 		{
-			aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-			float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-			KeyPosition data;
-			data.position = AssimpGLMHelpers::GetGLMVec(aiPosition);
-			data.timeStamp = timeStamp;
-			m_Positions.push_back(data);
+			m_Positions.times.push_back(static_cast<float>(channel->mPositionKeys[positionIndex].mTime));
+			m_Positions.values.push_back(AssimpGLMHelpers::GetGLMVec(channel->mPositionKeys[positionIndex].mValue));
 		}
 
-		m_NumRotations = channel->mNumRotationKeys;
-		for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex)
+		m_Rotations.times.reserve(channel->mNumRotationKeys);
+		m_Rotations.values.reserve(channel->mNumRotationKeys);
+		for (unsigned int rotationIndex = 0; rotationIndex < channel->mNumRotationKeys; ++rotationIndex)
 		{
-			aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-			float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-			KeyRotation data;
-			data.orientation = AssimpGLMHelpers::GetGLMQuat(aiOrientation);
-			data.timeStamp = timeStamp;
-			m_Rotations.push_back(data);
+			m_Rotations.times.push_back(static_cast<float>(channel->mRotationKeys[rotationIndex].mTime));
+			m_Rotations.values.push_back(glm::normalize(AssimpGLMHelpers::GetGLMQuat(channel->mRotationKeys[rotationIndex].mValue)));
 		}
 
-		m_NumScalings = channel->mNumScalingKeys;
-		for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex)
+		m_Scales.times.reserve(channel->mNumScalingKeys);
+		m_Scales.values.reserve(channel->mNumScalingKeys);
+		for (unsigned int keyIndex = 0; keyIndex < channel->mNumScalingKeys; ++keyIndex)
 		{
-			aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-			float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-			KeyScale data;
-			data.scale = AssimpGLMHelpers::GetGLMVec(scale);
-			data.timeStamp = timeStamp;
-			m_Scales.push_back(data);
+			m_Scales.times.push_back(static_cast<float>(channel->mScalingKeys[keyIndex].mTime));
+			m_Scales.values.push_back(AssimpGLMHelpers::GetGLMVec(channel->mScalingKeys[keyIndex].mValue));
 		}
 	}
-	
+
+	// keys read in place from a baked clip (see animation_clip.h), clipData has to outlive the bone
+	Bone(const std::string& name, int ID, const unsigned char* clipData, const ClipFileTrack* track, float duration)
+		:
+		m_ClipData(clipData),
+		m_ClipTrack(track),
+		m_ClipDuration(duration),
+		m_LocalTransform(1.0f),
+		m_Name(name),
+		m_ID(ID)
+	{
+	}
+
 	void Update(float animationTime)
 	{
-		glm::mat4 translation = InterpolatePosition(animationTime);
-		glm::mat4 rotation = InterpolateRotation(animationTime);
-		glm::mat4 scale = InterpolateScaling(animationTime);
-		m_LocalTransform = translation * rotation * scale;
+		m_LocalTransform = SampleLocalTransform(animationTime, m_Cursor);
+	}
+
+	// same as Update, without touching the bone: safe to call from several threads with separate cursors
+	glm::mat4 SampleLocalTransform(float animationTime, BoneCursor& cursor) const
+	{
+		if (m_ClipTrack)
+			return PoseToMatrix(SampleBakedPose(animationTime, cursor));
+		return PoseToMatrix(m_Positions.Sample(animationTime, cursor.position), m_Rotations.Sample(animationTime, cursor.rotation),
+			m_Scales.Sample(animationTime, cursor.scale));
+	}
+
+	// the local transform before it is turned into a matrix, for blending
+	BonePose SamplePose(float animationTime, BoneCursor& cursor) const
+	{
+		if (m_ClipTrack)
+			return SampleBakedPose(animationTime, cursor);
+		BonePose pose;
+		pose.translation = m_Positions.Sample(animationTime, cursor.position);
+		pose.rotation = m_Rotations.Sample(animationTime, cursor.rotation);
+		pose.scale = m_Scales.Sample(animationTime, cursor.scale);
+		return pose;
 	}
 	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
 	std::string GetBoneName() const { return m_Name; }
-	int GetBoneID() { return m_ID; }
-	
+	int GetBoneID() const { return m_ID; }
+
 
 
 	int GetPositionIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumPositions - 1; ++index)
-		{
-			if (animationTime < m_Positions[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		float factor;
+		return m_ClipTrack ? FindBakedKey(m_ClipTrack->positions, animationTime, m_Cursor.position, factor)
+			: m_Positions.FindKey(animationTime, m_Cursor.position);
 	}
 
 	int GetRotationIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumRotations - 1; ++index)
-		{
-			if (animationTime < m_Rotations[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		float factor;
+		return m_ClipTrack ? FindBakedKey(m_ClipTrack->rotations, animationTime, m_Cursor.rotation, factor)
+			: m_Rotations.FindKey(animationTime, m_Cursor.rotation);
 	}
 
 	int GetScaleIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumScalings - 1; ++index)
-		{
-			if (animationTime < m_Scales[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		float factor;
+		return m_ClipTrack ? FindBakedKey(m_ClipTrack->scales, animationTime, m_Cursor.scale, factor)
+			: m_Scales.FindKey(animationTime, m_Cursor.scale);
 	}
 
+	// the imported keys, empty for a baked bone
+	const KeyTrack<glm::vec3>& GetPositionKeys() const { return m_Positions; }
+	const KeyTrack<glm::quat>& GetRotationKeys() const { return m_Rotations; }
+	const KeyTrack<glm::vec3>& GetScaleKeys() const { return m_Scales; }
+	bool IsBaked() const { return m_ClipTrack != nullptr; }
 
-private:
-
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
-	{
-		float scaleFactor = 0.0f;
-		float midWayLength = animationTime - lastTimeStamp;
-		float framesDiff = nextTimeStamp - lastTimeStamp;
-		scaleFactor = midWayLength / framesDiff;
-		return scaleFactor;
-	}
 
-	glm::mat4 InterpolatePosition(float animationTime)
+private:
+	// key that starts the segment containing animationTime in a baked channel and the factor towards the next key
+	int FindBakedKey(const ClipChannel& channel, float animationTime, int& cursor, float& factor) const
 	{
-		if (1 == m_NumPositions)
-			return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+		const int keyCount = static_cast<int>(channel.keyCount);
+		factor = 0.0f;
+		if (keyCount == 1)
+			return 0;
 
-		int p0Index = GetPositionIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
-			m_Positions[p1Index].timeStamp, animationTime);
-		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
-			, scaleFactor);
-		return glm::translate(glm::mat4(1.0f), finalPosition);
-	}
-
-	glm::mat4 InterpolateRotation(float animationTime)
-	{
-		if (1 == m_NumRotations)
+		const float normalizedTime = m_ClipDuration > 0.0f ? glm::clamp(animationTime / m_ClipDuration, 0.0f, 1.0f) : 0.0f;
+		if (channel.timesOffset == 0)
 		{
-			auto rotation = glm::normalize(m_Rotations[0].orientation);
-			return glm::toMat4(rotation);
+			// uniformly sampled: the key follows from the time, no search
+			const float position = normalizedTime * (keyCount - 1);
+			cursor = std::min(static_cast<int>(position), keyCount - 2);
+			factor = position - cursor;
+			return cursor;
 		}
 
-		int p0Index = GetRotationIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
-			m_Rotations[p1Index].timeStamp, animationTime);
-		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
-			, scaleFactor);
-		finalRotation = glm::normalize(finalRotation);
-		return glm::toMat4(finalRotation);
+		const uint16_t* times = reinterpret_cast<const uint16_t*>(m_ClipData + channel.timesOffset);
+		const float time = normalizedTime * 65535.0f;
+		const int key = FindKeyInTimes(times, keyCount, time, cursor);
+		const float framesDiff = static_cast<float>(times[key + 1]) - static_cast<float>(times[key]);
+		factor = framesDiff > 0.0f ? glm::clamp((time - times[key]) / framesDiff, 0.0f, 1.0f) : 0.0f;
+		return key;
+	}
 
+	glm::vec3 SampleBakedVec3(const ClipChannel& channel, float animationTime, int& cursor) const
+	{
+		float factor;
+		const int key = FindBakedKey(channel, animationTime, cursor, factor);
+		const uint16_t* values = reinterpret_cast<const uint16_t*>(m_ClipData + channel.valuesOffset) + key * 3;
+		const glm::vec3 value = DequantizeVec3(values, channel.minimum, channel.extent);
+		if (channel.keyCount == 1)
+			return value;
+		return InterpolateKey(value, DequantizeVec3(values + 3, channel.minimum, channel.extent), factor);
 	}
 
-	glm::mat4 InterpolateScaling(float animationTime)
+	glm::quat SampleBakedRotation(const ClipChannel& channel, float animationTime, int& cursor) const
 	{
-		if (1 == m_NumScalings)
-			return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+		float factor;
+		const int key = FindBakedKey(channel, animationTime, cursor, factor);
+		const uint16_t* values = reinterpret_cast<const uint16_t*>(m_ClipData + channel.valuesOffset) + key * 3;
+		const glm::quat value = UnpackQuaternion48(values);
+		if (channel.keyCount == 1)
+			return value;
+		return InterpolateKey(value, UnpackQuaternion48(values + 3), factor);
+	}
 
-		int p0Index = GetScaleIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
-			m_Scales[p1Index].timeStamp, animationTime);
-		glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
-			, scaleFactor);
-		return glm::scale(glm::mat4(1.0f), finalScale);
+	BonePose SampleBakedPose(float animationTime, BoneCursor& cursor) const
+	{
+		BonePose pose;
+		pose.translation = SampleBakedVec3(m_ClipTrack->positions, animationTime, cursor.position);
+		pose.rotation = SampleBakedRotation(m_ClipTrack->rotations, animationTime, cursor.rotation);
+		pose.scale = SampleBakedVec3(m_ClipTrack->scales, animationTime, cursor.scale);
+		return pose;
 	}
 
-	std::vector<KeyPosition> m_Positions;
-	std::vector<KeyRotation> m_Rotations;
-	std::vector<KeyScale> m_Scales;
-	int m_NumPositions;
-	int m_NumRotations;
-	int m_NumScalings;
+	KeyTrack<glm::vec3> m_Positions;
+	KeyTrack<glm::quat> m_Rotations;
+	KeyTrack<glm::vec3> m_Scales;
+
+	// baked bones read their keys from the clip instead of the tracks above
+	const unsigned char* m_ClipData = nullptr;
+	const ClipFileTrack* m_ClipTrack = nullptr;
+	float m_ClipDuration = 0.0f;
+
+	// cursors of Update, only a hint: any value gives the right key
+	BoneCursor m_Cursor;
 
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int m_ID;
 };
-
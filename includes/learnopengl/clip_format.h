@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+
+/*
+	Layout of a baked animation clip (see animation_clip.h). The file is read in place after mapping it into
+	memory, so everything is plain data with offsets from the start of the file, 4 byte aligned:
+
+	ClipFileHeader
+	ClipFileNode[nodeCount]    the compiled hierarchy (AnimationNode)
+	ClipFileTrack[trackCount]  one per Bone, three channels each
+	key data                   per channel: uint16 key times (keyed channels only), 3 x uint16 per key value
+	names                      0 terminated strings
+*/
+
+const char CLIP_FILE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'C', 'L', 'I', 'P' };
+const uint32_t CLIP_FILE_VERSION = 1;
+
+struct ClipFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t fileSize;
+	float duration; // in ticks
+	float ticksPerSecond;
+	uint32_t nodeCount;
+	uint32_t nodesOffset;
+	uint32_t trackCount;
+	uint32_t tracksOffset;
+};
+
+struct ClipFileNode
+{
+	glm::mat4 transformation;
+	glm::mat4 offset;
+	int32_t parentIndex;
+	int32_t boneIndex;
+	int32_t trackIndex;
+	uint32_t nameOffset;
+};
+
+/*
+	Keys of one channel. Keyed channels store the time of every key quantized over the clip's duration
+	(time = times[k] / 65535 * duration), uniformly sampled ones (timesOffset == 0) have their keys evenly
+	spread from 0 to duration. Positions and scales are quantized to 16 bits per component within the
+	channel's bounds, rotations are 48 bit smallest-three quaternions (PackQuaternion48).
+*/
+struct ClipChannel
+{
+	uint32_t keyCount;
+	uint32_t timesOffset;
+	uint32_t valuesOffset;
+	uint32_t reserved;
+	float minimum[3];
+	float extent[3];
+};
+
+struct ClipFileTrack
+{
+	uint32_t nameOffset;
+	int32_t boneID;
+	ClipChannel positions;
+	ClipChannel rotations;
+	ClipChannel scales;
+};
+
+inline uint16_t QuantizeUnit(float value)
+{
+	return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline void QuantizeVec3(const glm::vec3& value, const float minimum[3], const float extent[3], uint16_t* out)
+{
+	for (int i = 0; i < 3; i++)
+		out[i] = extent[i] > 0.0f ? QuantizeUnit((value[i] - minimum[i]) / extent[i]) : 0;
+}
+
+inline glm::vec3 DequantizeVec3(const uint16_t* in, const float minimum[3], const float extent[3])
+{
+	const float scale = 1.0f / 65535.0f;
+	return glm::vec3(minimum[0] + in[0] * scale * extent[0], minimum[1] + in[1] * scale * extent[1], minimum[2] + in[2] * scale * extent[2]);
+}
+
+// smallest three: the largest component is dropped (its sign made positive, q and -q are the same rotation) and
+// rebuilt from the unit length, the other three lie within +-1/sqrt(2) and get 15 bits each, 2 bits say which
+// one was dropped. 47 of the 48 bits are used.
+inline void PackQuaternion48(const glm::quat& rotation, uint16_t* out)
+{
+	const glm::quat q = glm::normalize(rotation);
+	const float components[4] = { q.x, q.y, q.z, q.w };
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+	{
+		if (std::abs(components[i]) > std::abs(components[largest]))
+			largest = i;
+	}
+	const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+	uint64_t bits = static_cast<uint64_t>(largest) << 45;
+	int shift = 30;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		const float normalized = (components[i] * sign * glm::root_two<float>() + 1.0f) * 0.5f;
+		bits |= static_cast<uint64_t>(std::lround(glm::clamp(normalized, 0.0f, 1.0f) * 32767.0f)) << shift;
+		shift -= 15;
+	}
+	out[0] = static_cast<uint16_t>(bits >> 32);
+	out[1] = static_cast<uint16_t>(bits >> 16);
+	out[2] = static_cast<uint16_t>(bits);
+}
+
+inline glm::quat UnpackQuaternion48(const uint16_t* in)
+{
+	const uint64_t bits = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 16) | in[2];
+	const int largest = static_cast<int>(bits >> 45) & 3;
+	float components[4];
+	float sumOfSquares = 0.0f;
+	int shift = 30;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		const float normalized = static_cast<float>((bits >> shift) & 0x7FFF) / 32767.0f;
+		components[i] = (normalized * 2.0f - 1.0f) / glm::root_two<float>();
+		sumOfSquares += components[i] * components[i];
+		shift -= 15;
+	}
+	components[largest] = std::sqrt(std::max(0.0f, 1.0f - sumOfSquares));
+	// unit length up to the quantization, InterpolateKey normalizes anyway
+	return glm::quat(components[3], components[0], components[1], components[2]);
+}
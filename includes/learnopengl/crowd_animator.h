@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/animator.h>
+#include <learnopengl/job_system.h>
+
+/* Update rate for the characters up to maxDistance from the camera, see CrowdAnimator::SetUpdateRates */
+struct AnimationLod
+{
+	float maxDistance;
+	float updatesPerSecond; // 0 evaluates every frame
+};
+
+/*
+	Many characters sharing one rig. Every Animator writes its final bone matrices straight into its slice
+	of one contiguous palette (instance * GetPaletteStride() + boneID), which can be uploaded with a single
+	glBufferSubData into an SSBO or texture buffer. The animators only read the shared clips, so they are
+	updated in parallel on a JobSystem.
+*/
+class CrowdAnimator
+{
+public:
+	CrowdAnimator(const Animation* animation, unsigned int instanceCount, JobSystem& jobs)
+		: m_Jobs(jobs)
+	{
+		m_PaletteStride = std::max(1, animation->GetBoneMatrixCount());
+		m_Palette.assign(static_cast<size_t>(instanceCount) * m_PaletteStride, glm::mat4(1.0f));
+
+		// the palette is never resized afterwards, so the slices handed to the animators stay valid
+		m_Animators.reserve(instanceCount);
+		for (unsigned int i = 0; i < instanceCount; i++)
+			m_Animators.push_back(Animator(animation, &m_Palette[static_cast<size_t>(i) * m_PaletteStride]));
+	}
+
+	// no copies: the animators point into this crowd's palette
+	CrowdAnimator(const CrowdAnimator&) = delete;
+	CrowdAnimator& operator=(const CrowdAnimator&) = delete;
+
+	void UpdateAnimation(float dt)
+	{
+		std::atomic<unsigned int> evaluated(0);
+		m_Jobs.parallelFor(0, static_cast<unsigned int>(m_Animators.size()), 32, [&](unsigned int first, unsigned int last)
+		{
+			unsigned int count = 0;
+			for (unsigned int i = first; i < last; i++)
+			{
+				m_Animators[i].UpdateAnimation(dt);
+				count += m_Animators[i].WasEvaluated() ? 1 : 0;
+			}
+			evaluated += count;
+		});
+		m_EvaluatedCount = evaluated;
+	}
+
+	// picks every instance's update rate from its distance to the camera: the first lod whose maxDistance
+	// reaches it (lods sorted by distance), the last one beyond. Steps are staggered over the instances so those
+	// sharing a rate don't all evaluate in the same frame.
+	void SetUpdateRates(const glm::vec3& cameraPosition, const glm::vec3* instancePositions, const std::vector<AnimationLod>& lods)
+	{
+		if (lods.empty())
+			return;
+		for (size_t i = 0; i < m_Animators.size(); i++)
+		{
+			const float distance = glm::length(instancePositions[i] - cameraPosition);
+			size_t lod = 0;
+			while (lod + 1 < lods.size() && distance > lods[lod].maxDistance)
+				lod++;
+			const float phase = std::fmod(static_cast<float>(i) * 0.618034f, 1.0f);
+			m_Animators[i].SetUpdateRate(lods[lod].updatesPerSecond, phase);
+		}
+	}
+
+	// skeletons evaluated by the last UpdateAnimation, the other instances only interpolated their palettes
+	unsigned int GetEvaluatedCount() const { return m_EvaluatedCount; }
+	unsigned int GetInterpolatedCount() const { return static_cast<unsigned int>(m_Animators.size()) - m_EvaluatedCount; }
+
+	Animator& GetAnimator(unsigned int instance) { return m_Animators[instance]; }
+	unsigned int GetInstanceCount() const { return static_cast<unsigned int>(m_Animators.size()); }
+
+	// the bone matrices of every instance, GetPaletteStride() matrices per instance
+	const glm::mat4* GetPalette() const { return m_Palette.data(); }
+	const glm::mat4* GetInstancePalette(unsigned int instance) const { return &m_Palette[static_cast<size_t>(instance) * m_PaletteStride]; }
+	unsigned int GetPaletteStride() const { return static_cast<unsigned int>(m_PaletteStride); }
+	size_t GetPaletteSizeInBytes() const { return m_Palette.size() * sizeof(glm::mat4); }
+
+private:
+	JobSystem& m_Jobs;
+	int m_PaletteStride;
+	std::vector<glm::mat4> m_Palette;
+	std::vector<Animator> m_Animators;
+	unsigned int m_EvaluatedCount = 0;
+};
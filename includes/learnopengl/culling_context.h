@@ -0,0 +1,142 @@
+#ifndef CULLING_CONTEXT_H
+#define CULLING_CONTEXT_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Frustum culling with per-object state kept across frames:
+// - the planes are extracted from the view-projection matrix once per frame (createFrustumFromMatrix)
+// - plane coherence: the plane that rejected an object last frame is tested first, an object that stays
+//   outside usually fails that single test again
+// - temporal coherence: an object that was fully inside by some margin is accepted without any test while
+//   the accumulated plane motion since then stays below that margin and the frame to frame motion stays
+//   below coherenceThreshold (a faster camera starts over with full tests)
+// Objects are identified by a caller chosen dense id. The test is conservative like AABB::isOnFrustum.
+class CullingContext
+{
+public:
+    bool planeCoherence = true;
+    bool temporalCoherence = true;
+
+    // worldRadius bounds the distance of every tested object from the origin, it turns the change of the plane
+    // normals into a distance. coherenceThreshold is the largest per-frame plane motion (in world units) that
+    // still reuses last frame's results.
+    CullingContext(float worldRadius = 1000.0f, float coherenceThreshold = 10.0f)
+        : worldRadius(worldRadius), coherenceThreshold(coherenceThreshold)
+    {}
+
+    void beginFrame(const glm::mat4& viewProjection)
+    {
+        frustum = createFrustumFromMatrix(viewProjection);
+        const Plane current[6] = { frustum.leftFace, frustum.rightFace, frustum.bottomFace, frustum.topFace, frustum.nearFace, frustum.farFace };
+
+        // largest change of a signed distance for any point within worldRadius
+        float motion = 0.0f;
+        for (int i = 0; i < 6; i++)
+        {
+            motion = std::max(motion, glm::length(current[i].normal - planes[i].normal) * worldRadius + std::abs(current[i].distance - planes[i].distance));
+            planes[i] = current[i];
+        }
+
+        if (firstFrame || motion > coherenceThreshold)
+        {
+            epoch++;
+            accumulatedMotion = 0.0f;
+        }
+        else
+        {
+            accumulatedMotion += motion;
+        }
+        firstFrame = false;
+    }
+
+    bool isVisible(unsigned int id, const glm::vec3& center, const glm::vec3& extents)
+    {
+        if (id >= states.size())
+            states.resize(id + 1);
+        ObjectState& state = states[id];
+        objectsTested++;
+
+        // still inside: same bounds, same epoch and the planes haven't moved past the margin
+        if (temporalCoherence && state.epoch == epoch && state.center == center && state.extents == extents &&
+            accumulatedMotion - state.accumulatedMotion < state.insideMargin)
+        {
+            objectsSkipped++;
+            return true;
+        }
+
+        int p = planeCoherence ? state.lastPlane : 0;
+        float margin = std::numeric_limits<float>::max();
+        for (int i = 0; i < 6; i++, p = p == 5 ? 0 : p + 1)
+        {
+            const Plane& plane = planes[p];
+            const float r = extents.x * std::abs(plane.normal.x) + extents.y * std::abs(plane.normal.y) + extents.z * std::abs(plane.normal.z);
+            const float distance = plane.getSignedDistanceToPlane(center);
+            planesTested++;
+            if (distance < -r)
+            {
+                state.lastPlane = static_cast<unsigned char>(p);
+                state.epoch = 0;
+                return false;
+            }
+            margin = std::min(margin, distance - r);
+        }
+
+        // intersecting objects (margin < 0) are never skipped
+        state.epoch = epoch;
+        state.center = center;
+        state.extents = extents;
+        state.insideMargin = margin;
+        state.accumulatedMotion = accumulatedMotion;
+        return true;
+    }
+
+    bool isVisible(unsigned int id, const AABB& box) { return isVisible(id, box.center, box.extents); }
+    bool isVisible(unsigned int id, Entity& entity) { return isVisible(id, entity.getGlobalAABB()); }
+
+    // forgets the cached results, e.g. after teleporting the camera or reusing ids
+    void reset()
+    {
+        states.clear();
+        firstFrame = true;
+    }
+
+    const Frustum& getFrustum() const { return frustum; }
+
+    // statistics since the last resetStats()
+    unsigned long long getPlanesTested() const { return planesTested; }
+    unsigned long long getObjectsTested() const { return objectsTested; }
+    unsigned long long getObjectsSkipped() const { return objectsSkipped; }
+    float getPlanesPerObject() const { return objectsTested ? static_cast<float>(planesTested) / static_cast<float>(objectsTested) : 0.0f; }
+    void resetStats() { planesTested = objectsTested = objectsSkipped = 0; }
+
+private:
+    struct ObjectState
+    {
+        glm::vec3 center{ 0.0f };
+        glm::vec3 extents{ 0.0f };
+        float insideMargin = -1.0f;
+        float accumulatedMotion = 0.0f;
+        unsigned int epoch = 0; // 0: no cached inside result
+        unsigned char lastPlane = 0;
+    };
+
+    float worldRadius, coherenceThreshold;
+    Frustum frustum;
+    Plane planes[6]; // left, right, bottom, top, near, far
+    bool firstFrame = true;
+    unsigned int epoch = 0;
+    float accumulatedMotion = 0.0f;
+    std::vector<ObjectState> states;
+
+    unsigned long long planesTested = 0, objectsTested = 0, objectsSkipped = 0;
+};
+#endif
@@ -342,6 +342,33 @@ Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, flo
 	return frustum;
 }
 
+//Gribb/Hartmann: the planes are sums/differences of the rows of the view-projection matrix, no camera needed
+Frustum createFrustumFromMatrix(const glm::mat4& viewProjection)
+{
+	const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	//inside when dot(xyz, p) + w >= 0, Plane keeps dot(normal, p) - distance
+	const auto toPlane = [](const glm::vec4& equation) {
+		const float length = glm::length(glm::vec3(equation));
+		Plane plane;
+		plane.normal = glm::vec3(equation) / length;
+		plane.distance = -equation.w / length;
+		return plane;
+	};
+
+	Frustum frustum;
+	frustum.leftFace = toPlane(row3 + row0);
+	frustum.rightFace = toPlane(row3 - row0);
+	frustum.bottomFace = toPlane(row3 + row1);
+	frustum.topFace = toPlane(row3 - row1);
+	frustum.nearFace = toPlane(row3 + row2);
+	frustum.farFace = toPlane(row3 - row2);
+	return frustum;
+}
+
 AABB generateAABB(const Model& model)
 {
 	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
@@ -0,0 +1,107 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// What the geometry pass stores per pixel
+enum GBufferLayout
+{
+    GBUFFER_STANDARD, // RGBA16F position, RGBA16F normal, RGBA8 albedo + specular, 24 bit depth
+    GBUFFER_COMPACT   // RG16 octahedral normal, RGBA8 albedo + specular, 24 bit depth the position is reconstructed from
+};
+
+// A deferred renderer's G-buffer in either layout. The geometry pass writes position to location 0, normal to 1 and
+// albedo + specular to 2 in both; with the compact layout there is no position target (its output is dropped) and
+// the shader writes the normal octahedral encoded (uniform bool compactGBuffer). Passes reading the compact layout
+// rebuild the position from the depth texture and the inverse (view) projection matrix.
+class GBuffer
+{
+public:
+    unsigned int framebuffer;
+    unsigned int position = 0; // standard layout only
+    unsigned int normal;
+    unsigned int albedoSpec;
+    unsigned int depth;
+
+    GBuffer(unsigned int width, unsigned int height, GBufferLayout layout)
+        : layout(layout)
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        if (layout == GBUFFER_STANDARD)
+        {
+            position = createTarget(width, height, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, position, 0);
+            normal = createTarget(width, height, normalFormat(layout), GL_RGBA, GL_FLOAT);
+        }
+        else
+        {
+            normal = createTarget(width, height, normalFormat(layout), GL_RG, GL_UNSIGNED_SHORT);
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+        albedoSpec = createTarget(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, albedoSpec, 0);
+        // a texture rather than a renderbuffer, the compact layout reads it back
+        depth = createTarget(width, height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+
+        unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        if (layout == GBUFFER_COMPACT)
+            attachments[0] = GL_NONE;
+        glDrawBuffers(3, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::GBUFFER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~GBuffer()
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        unsigned int textures[4] = { position, normal, albedoSpec, depth };
+        glDeleteTextures(4, textures);
+    }
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // position (standard layout) on texture unit 0, normal on 1, albedo + specular on 2 and depth on 3
+    void bindTextures() const
+    {
+        unsigned int textures[4] = { position, normal, albedoSpec, depth };
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    GBufferLayout getLayout() const { return layout; }
+
+    // the normal target's internal format; position is RGBA16F, albedo + specular RGBA8 and depth 24 bit in both
+    static GLenum normalFormat(GBufferLayout layout) { return layout == GBUFFER_STANDARD ? GL_RGBA16F : GL_RG16; }
+
+    // bandwidth of one pixel: what the geometry pass writes (every target and the depth) and what a full screen
+    // pass reads to get position, normal and albedo + specular (depth instead of position for the compact layout)
+    static unsigned int bytesWrittenPerPixel(GBufferLayout layout) { return layout == GBUFFER_STANDARD ? 8 + 8 + 4 + 4 : 4 + 4 + 4; }
+    static unsigned int bytesReadPerPixel(GBufferLayout layout) { return layout == GBUFFER_STANDARD ? 8 + 8 + 4 : 4 + 4 + 4; }
+
+private:
+    GBufferLayout layout;
+
+    static unsigned int createTarget(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format, GLenum type)
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+};
+#endif
@@ -0,0 +1,75 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+// GPU time of the frames of a render loop without stalling it: every frame goes into the next of a few
+// GL_TIME_ELAPSED queries and a query is only read when its frame has come round again, by then long finished.
+// Frames whose result isn't there yet are left out of the average rather than waited for.
+class GpuTimer
+{
+public:
+    static const unsigned int QUERY_COUNT = 4; // frames in flight
+
+    GpuTimer()
+    {
+        glGenQueries(QUERY_COUNT, queries);
+    }
+
+    ~GpuTimer()
+    {
+        glDeleteQueries(QUERY_COUNT, queries);
+    }
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // around everything the frame renders; GL_TIME_ELAPSED queries don't nest, nothing inside may start one
+    void begin()
+    {
+        collect(current);
+        glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    }
+
+    void end()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        // the first frame also pays for the driver's lazy setup (llvmpipe even reports a nonsense time for it), leave it out
+        issued[current] = !firstFrame;
+        firstFrame = false;
+        current = (current + 1) % QUERY_COUNT;
+    }
+
+    // average milliseconds of the frames collected since the last call, 0 when there were none
+    float takeAverageMs()
+    {
+        const float average = frames ? static_cast<float>(totalNanoseconds / frames) / 1000000.0f : 0.0f;
+        totalNanoseconds = 0;
+        frames = 0;
+        return average;
+    }
+
+private:
+    unsigned int queries[QUERY_COUNT];
+    bool issued[QUERY_COUNT] = {};
+    unsigned int current = 0;
+    bool firstFrame = true;
+    GLuint64 totalNanoseconds = 0;
+    unsigned int frames = 0;
+
+    void collect(unsigned int query)
+    {
+        if (!issued[query])
+            return;
+        issued[query] = false;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &elapsed);
+        totalNanoseconds += elapsed;
+        frames++;
+    }
+};
+#endif
@@ -0,0 +1,203 @@
+#ifndef INSTANCE_CULLER_H
+#define INSTANCE_CULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_c.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <vector>
+
+// command layout consumed by glDrawElementsIndirect (see the GL 4.3 spec, section 10.4)
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+// Shader storage / attribute bindings shared by the cull compute shader and the instanced vertex shader
+const unsigned int INSTANCE_TRANSFORM_BINDING = 0;
+const unsigned int INSTANCE_BOUNDS_BINDING    = 1;
+const unsigned int VISIBLE_INSTANCE_BINDING   = 2;
+const unsigned int DRAW_COMMAND_BINDING       = 3;
+const unsigned int VISIBLE_INDEX_ATTRIBUTE    = 7; // first free location after the Vertex attributes of Mesh
+
+const unsigned int MAX_INSTANCE_LODS = 4;
+const unsigned int MAX_INSTANCE_COMMANDS = 16; // one per mesh of every LOD
+
+// GPU-driven culling of a static set of instances. Every frame a compute shader tests each instance's
+// bounding sphere against the view frustum, picks a LOD from the camera distance and appends the index
+// of every visible instance into a compacted per-LOD list. The instance counts of the indirect draw
+// commands are written on the GPU as well, so drawing never needs to know how many instances survived.
+class InstanceCuller
+{
+public:
+    // constructor, uploads the instance transforms and their world space bounding spheres.
+    // localCenter/localRadius describe the bounding sphere of the instanced mesh in model space.
+    InstanceCuller(const char* cullShaderPath, const glm::mat4* modelMatrices, unsigned int amount, const glm::vec3& localCenter, float localRadius)
+        : cullShader(cullShaderPath), totalCount(amount)
+    {
+        std::vector<glm::vec4> bounds(amount);
+        for (unsigned int i = 0; i < amount; i++)
+        {
+            const glm::mat4& model = modelMatrices[i];
+            const float maxScale = std::max(std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))), glm::length(glm::vec3(model[2])));
+            bounds[i] = glm::vec4(glm::vec3(model * glm::vec4(localCenter, 1.0f)), localRadius * maxScale);
+        }
+
+        glGenBuffers(1, &transformBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+
+        glGenBuffers(1, &boundsBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, amount * sizeof(glm::vec4), &bounds[0], GL_STATIC_DRAW);
+
+        // one compacted list of `amount` entries per LOD, commands[lod].baseInstance points at the start of its list
+        glGenBuffers(1, &visibleBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_INSTANCE_LODS * amount * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+
+        glGenBuffers(1, &commandBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_INSTANCE_COMMANDS * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~InstanceCuller()
+    {
+        glDeleteBuffers(1, &transformBuffer);
+        glDeleteBuffers(1, &boundsBuffer);
+        glDeleteBuffers(1, &visibleBuffer);
+        glDeleteBuffers(1, &commandBuffer);
+        glDeleteProgram(cullShader.ID);
+    }
+
+    // registers the next (coarser) LOD. Instances closer than maxDistance that are not claimed by a finer LOD
+    // are drawn with every one of these meshes (usually a Model's meshes); instances beyond the last LOD's
+    // maxDistance are culled. Each mesh gets an indirect command of its own, all of them draw the LOD's list.
+    // note: the visible index is added as an instanced attribute to the meshes' VAOs, so the vertex shader
+    // can fetch its transform with modelMatrices[aInstanceIndex].
+    void addLod(std::vector<Mesh>& meshes, float maxDistance)
+    {
+        if (lodDistances.size() == MAX_INSTANCE_LODS)
+        {
+            std::cout << "ERROR::INSTANCE_CULLER::TOO_MANY_LODS" << std::endl;
+            return;
+        }
+        if (commands.size() + meshes.size() > MAX_INSTANCE_COMMANDS)
+        {
+            std::cout << "ERROR::INSTANCE_CULLER::TOO_MANY_MESHES" << std::endl;
+            return;
+        }
+
+        lodFirstCommands.push_back(static_cast<int>(commands.size()));
+        lodCommandCounts.push_back(static_cast<int>(meshes.size()));
+        for (Mesh& mesh : meshes)
+        {
+            DrawElementsIndirectCommand command;
+            command.count = static_cast<GLuint>(mesh.indices.size());
+            command.instanceCount = 0;
+            command.firstIndex = 0;
+            command.baseVertex = 0;
+            command.baseInstance = static_cast<GLuint>(lodDistances.size()) * totalCount;
+
+            glBindVertexArray(mesh.VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+            glEnableVertexAttribArray(VISIBLE_INDEX_ATTRIBUTE);
+            glVertexAttribIPointer(VISIBLE_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+            glVertexAttribDivisor(VISIBLE_INDEX_ATTRIBUTE, 1); // baseInstance offsets this fetch into the LOD's list
+            glBindVertexArray(0);
+
+            vaos.push_back(mesh.VAO);
+            commands.push_back(command);
+        }
+        lodDistances.push_back(maxDistance);
+    }
+
+    // runs the cull pass for the current camera. Results are only consumed by the GPU (draw), no CPU sync.
+    void cull(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& cameraPos)
+    {
+        // reset the instance counts, the compute shader appends to them
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        // the shader keeps the planes as dot(xyz, p) + w >= 0 for inside
+        const Frustum frustum = createFrustumFromMatrix(projection * view);
+        const Plane* faces[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.bottomFace, &frustum.topFace, &frustum.nearFace, &frustum.farFace };
+        glm::vec4 planes[6];
+        for (int i = 0; i < 6; i++)
+            planes[i] = glm::vec4(faces[i]->normal, -faces[i]->distance);
+
+        cullShader.use();
+        glUniform4fv(glGetUniformLocation(cullShader.ID, "frustumPlanes"), 6, &planes[0][0]);
+        glUniform1fv(glGetUniformLocation(cullShader.ID, "lodDistances"), static_cast<GLsizei>(lodDistances.size()), lodDistances.data());
+        cullShader.setVec3("cameraPos", cameraPos);
+        cullShader.setInt("instanceCount", static_cast<int>(totalCount));
+        glUniform1iv(glGetUniformLocation(cullShader.ID, "lodFirstCommands"), static_cast<GLsizei>(lodFirstCommands.size()), lodFirstCommands.data());
+        glUniform1iv(glGetUniformLocation(cullShader.ID, "lodCommandCounts"), static_cast<GLsizei>(lodCommandCounts.size()), lodCommandCounts.data());
+        cullShader.setInt("lodCount", static_cast<int>(lodDistances.size()));
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_TRANSFORM_BINDING, transformBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BOUNDS_BINDING, boundsBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_INSTANCE_BINDING, visibleBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COMMAND_BINDING, commandBuffer);
+
+        glDispatchCompute((totalCount + 63) / 64, 1, 1);
+
+        // make the appended indices visible to vertex fetch and the counts visible to the indirect draw, to
+        // readVisibleCount and to the next frame's reset
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+
+    // draws every LOD with the instance counts written by the last cull pass.
+    // the caller is expected to have bound the (instanced) shader and its textures.
+    void draw()
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_TRANSFORM_BINDING, transformBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        for (unsigned int i = 0; i < vaos.size(); i++)
+        {
+            glBindVertexArray(vaos[i]);
+            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(DrawElementsIndirectCommand)));
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // reads back the number of surviving instances (summed over all LODs, each counted by its first mesh).
+    // note: this waits for the cull pass to finish, so only call it when you actually want the statistic.
+    unsigned int readVisibleCount()
+    {
+        std::vector<DrawElementsIndirectCommand> results(commands.size());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, results.size() * sizeof(DrawElementsIndirectCommand), results.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        unsigned int visible = 0;
+        for (int first : lodFirstCommands)
+            visible += results[first].instanceCount;
+        return visible;
+    }
+
+    unsigned int getTotalCount() const { return totalCount; }
+
+private:
+    ComputeShader cullShader;
+    unsigned int totalCount;
+    unsigned int transformBuffer, boundsBuffer, visibleBuffer, commandBuffer;
+
+    std::vector<unsigned int> vaos; // VAO per command
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<float> lodDistances;
+    std::vector<int> lodFirstCommands, lodCommandCounts; // the LOD's meshes' commands
+};
+#endif
@@ -0,0 +1,154 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool for data parallel loops. The threads are created once and sleep between jobs.
+// parallelFor splits the range into chunks and deals them out to one queue per thread; a thread works through
+// its own queue from the back and, once it is empty, steals from the front of the others, so uneven chunks
+// still keep every thread busy. The calling thread takes part in the work and returns when all chunks are done.
+class JobSystem
+{
+public:
+    // threadCount includes the calling thread, 0 uses every hardware thread
+    JobSystem(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; i++)
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (unsigned int i = 1; i < threadCount; i++)
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto&& worker : workers)
+            worker.join();
+    }
+
+    // calls func(first, last) for chunks of about grainSize indices covering [begin, end)
+    void parallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& func)
+    {
+        if (begin >= end)
+            return;
+        grainSize = std::max(1u, grainSize);
+        const unsigned int chunkCount = (end - begin + grainSize - 1) / grainSize;
+        if (queues.size() == 1 || chunkCount == 1)
+        {
+            func(begin, end);
+            return;
+        }
+
+        job = &func;
+        pending = chunkCount;
+        for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+        {
+            Queue& queue = *queues[chunk % queues.size()];
+            const unsigned int first = begin + chunk * grainSize;
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.push_back({ first, std::min(end, first + grainSize) });
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            generation++;
+        }
+        wake.notify_all();
+
+        work(0);
+        // the last chunks may still be running on other threads
+        while (pending.load() != 0)
+            std::this_thread::yield();
+        job = nullptr;
+    }
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(queues.size()); }
+
+private:
+    struct Chunk
+    {
+        unsigned int first, last;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // one per thread, index 0 is the calling thread
+    std::vector<std::thread> workers;
+    const std::function<void(unsigned int, unsigned int)>* job = nullptr;
+    std::atomic<unsigned int> pending{ 0 };
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    bool popOwn(unsigned int thread, Chunk& chunk)
+    {
+        Queue& queue = *queues[thread];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty())
+            return false;
+        chunk = queue.chunks.back();
+        queue.chunks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned int thread, Chunk& chunk)
+    {
+        for (unsigned int i = 1; i < queues.size(); i++)
+        {
+            Queue& queue = *queues[(thread + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.chunks.empty())
+                continue;
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void work(unsigned int thread)
+    {
+        Chunk chunk;
+        while (popOwn(thread, chunk) || steal(thread, chunk))
+        {
+            (*job)(chunk.first, chunk.last);
+            pending--;
+        }
+    }
+
+    void workerLoop(unsigned int thread)
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            work(thread);
+        }
+    }
+};
+#endif
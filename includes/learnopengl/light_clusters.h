@@ -0,0 +1,249 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_c.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// one point light as the shaders read it (std430: every vec3 is followed by a float)
+struct PointLight
+{
+    glm::vec3 position;
+    float radius; // beyond it the light contributes less than 5/256, see pointLightRadius
+    glm::vec3 color;
+    float linear;
+    float quadratic;
+    float padding[3];
+};
+
+// Shader storage bindings shared by the cluster assignment compute shader and the lighting pass
+const unsigned int CLUSTER_LIGHT_BINDING       = 0;
+const unsigned int CLUSTER_COUNT_BINDING       = 1;
+const unsigned int CLUSTER_LIGHT_INDEX_BINDING = 2;
+
+// the assignment shader runs one invocation per cluster with a 16 x 9 x 4 workgroup, so the grid is 16 x 9
+// tiles on screen and a multiple of 4 slices in depth
+const unsigned int CLUSTER_TILES_X = 16;
+const unsigned int CLUSTER_TILES_Y = 9;
+const unsigned int CLUSTER_SLICES  = 24;
+
+// distance at which a light of the given color falls below 5/256 with attenuation 1 / (1 + linear * d + quadratic * d^2)
+inline float pointLightRadius(const glm::vec3& color, float linear, float quadratic)
+{
+    const float maxBrightness = std::max(std::max(color.r, color.g), color.b);
+    return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * (1.0f - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
+}
+
+// The view frustum cut into CLUSTER_TILES_X x CLUSTER_TILES_Y screen tiles and CLUSTER_SLICES depth slices.
+// Slices are spaced exponentially between zNear and zFar so every cluster is roughly as deep as it is wide.
+// The math matches light_cluster.cs and the lighting pass exactly, so the CPU reference assigns the same lights.
+struct ClusterGrid
+{
+    float zNear;
+    float zFar;
+
+    unsigned int clusterCount() const { return CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES; }
+
+    // distance in front of the camera where slice k starts (k == CLUSTER_SLICES is zFar)
+    float sliceDepth(unsigned int slice) const
+    {
+        return zNear * std::pow(zFar / zNear, static_cast<float>(slice) / static_cast<float>(CLUSTER_SLICES));
+    }
+
+    // view space bounding box of a cluster: the tile's corner rays between the slice's near and far depth
+    void clusterBounds(unsigned int x, unsigned int y, unsigned int slice, const glm::mat4& inverseProjection, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+    {
+        const glm::vec2 tileMin = glm::vec2(x, y) / glm::vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y) * 2.0f - 1.0f;
+        const glm::vec2 tileMax = glm::vec2(x + 1, y + 1) / glm::vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y) * 2.0f - 1.0f;
+        const float depths[2] = { sliceDepth(slice), sliceDepth(slice + 1) };
+        boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (int corner = 0; corner < 4; corner++)
+        {
+            const glm::vec2 ndc((corner & 1) ? tileMax.x : tileMin.x, (corner & 2) ? tileMax.y : tileMin.y);
+            const glm::vec4 onNearPlane = inverseProjection * glm::vec4(ndc, -1.0f, 1.0f);
+            const glm::vec3 point = glm::vec3(onNearPlane) / onNearPlane.w;
+            const glm::vec3 ray = point / -point.z; // one unit in front of the camera
+            for (float depth : depths)
+            {
+                boundsMin = glm::min(boundsMin, ray * depth);
+                boundsMax = glm::max(boundsMax, ray * depth);
+            }
+        }
+    }
+};
+
+inline bool sphereOverlapsBox(const glm::vec3& center, float radius, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    const glm::vec3 offset = glm::clamp(center, boundsMin, boundsMax) - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+// CPU reference of light_cluster.cs. counts receives the number of lights touching every cluster (which may
+// exceed maxLightsPerCluster), indices the first maxLightsPerCluster of them per cluster in light order.
+inline void assignLightsToClusters(const ClusterGrid& grid, const glm::mat4& projection, const glm::mat4& view, const std::vector<PointLight>& lights,
+    unsigned int maxLightsPerCluster, std::vector<unsigned int>& counts, std::vector<unsigned int>& indices)
+{
+    const unsigned int tileCount = CLUSTER_TILES_X * CLUSTER_TILES_Y;
+    const glm::mat4 inverseProjection = glm::inverse(projection);
+    std::vector<glm::vec3> boundsMin(grid.clusterCount()), boundsMax(grid.clusterCount());
+    for (unsigned int slice = 0; slice < CLUSTER_SLICES; slice++)
+        for (unsigned int y = 0; y < CLUSTER_TILES_Y; y++)
+            for (unsigned int x = 0; x < CLUSTER_TILES_X; x++)
+            {
+                const unsigned int cluster = x + y * CLUSTER_TILES_X + slice * tileCount;
+                grid.clusterBounds(x, y, slice, inverseProjection, boundsMin[cluster], boundsMax[cluster]);
+            }
+
+    counts.assign(grid.clusterCount(), 0);
+    indices.assign(static_cast<size_t>(grid.clusterCount()) * maxLightsPerCluster, 0);
+    const float logDepthRange = std::log(grid.zFar / grid.zNear);
+    for (unsigned int i = 0; i < lights.size(); i++)
+    {
+        const glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        const float radius = lights[i].radius;
+        if (-center.z + radius < grid.zNear || -center.z - radius > grid.zFar)
+            continue;
+        // only the slices its depth range reaches can overlap, the box test decides
+        const float nearest = std::max(-center.z - radius, grid.zNear);
+        const float farthest = std::min(-center.z + radius, grid.zFar);
+        const int firstSlice = std::max(0, static_cast<int>(std::floor(std::log(nearest / grid.zNear) / logDepthRange * CLUSTER_SLICES)) - 1);
+        const int lastSlice = std::min(static_cast<int>(CLUSTER_SLICES) - 1, static_cast<int>(std::floor(std::log(farthest / grid.zNear) / logDepthRange * CLUSTER_SLICES)) + 1);
+        for (int slice = firstSlice; slice <= lastSlice; slice++)
+        {
+            for (unsigned int tile = 0; tile < tileCount; tile++)
+            {
+                const unsigned int cluster = tile + slice * tileCount;
+                if (!sphereOverlapsBox(center, radius, boundsMin[cluster], boundsMax[cluster]))
+                    continue;
+                if (counts[cluster] < maxLightsPerCluster)
+                    indices[static_cast<size_t>(cluster) * maxLightsPerCluster + counts[cluster]] = i;
+                counts[cluster]++;
+            }
+        }
+    }
+}
+
+// Clustered light assignment on the GPU. The lights live in an SSBO; every frame a compute pass finds the
+// lights whose sphere touches each cluster of the view frustum and writes their indices into a fixed size
+// list per cluster. The lighting pass then only shades with the lights of the fragment's cluster.
+class LightClusters
+{
+public:
+    // maxLightsPerCluster bounds the index list of each cluster, lights beyond it are dropped from that cluster
+    LightClusters(const char* assignShaderPath, float zNear, float zFar, unsigned int maxLightsPerCluster = 256)
+        : assignShader(assignShaderPath), maxLightsPerCluster(maxLightsPerCluster)
+    {
+        grid.zNear = zNear;
+        grid.zFar = zFar;
+
+        glGenBuffers(1, &lightBuffer);
+
+        glGenBuffers(1, &countBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, grid.clusterCount() * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<size_t>(grid.clusterCount()) * maxLightsPerCluster * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~LightClusters()
+    {
+        glDeleteBuffers(1, &lightBuffer);
+        glDeleteBuffers(1, &countBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        glDeleteProgram(assignShader.ID);
+    }
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // uploads the lights (world space), call again whenever they move
+    void setLights(const std::vector<PointLight>& lights)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+        if (lights.size() > lightCapacity)
+        {
+            lightCapacity = static_cast<unsigned int>(lights.size());
+            glBufferData(GL_SHADER_STORAGE_BUFFER, lightCapacity * sizeof(PointLight), lights.data(), GL_DYNAMIC_DRAW);
+        }
+        else if (!lights.empty())
+        {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, lights.size() * sizeof(PointLight), lights.data());
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        lightCount = static_cast<unsigned int>(lights.size());
+    }
+
+    // assigns the lights to the clusters of this camera. Results stay on the GPU, no CPU sync.
+    void assign(const glm::mat4& projection, const glm::mat4& view)
+    {
+        assignShader.use();
+        assignShader.setMat4("view", view);
+        assignShader.setMat4("inverseProjection", glm::inverse(projection));
+        assignShader.setFloat("zNear", grid.zNear);
+        assignShader.setFloat("zFar", grid.zFar);
+        glUniform1ui(glGetUniformLocation(assignShader.ID, "lightCount"), lightCount);
+        glUniform1ui(glGetUniformLocation(assignShader.ID, "maxLightsPerCluster"), maxLightsPerCluster);
+        bind();
+
+        glDispatchCompute(1, 1, CLUSTER_SLICES / 4);
+
+        // the lighting pass reads the lists from its fragment shader
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // binds the lights and cluster lists and sets the uniforms the lighting pass needs to find its cluster
+    void bind() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHT_BINDING, lightBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT_BINDING, countBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHT_INDEX_BINDING, indexBuffer);
+    }
+
+    void setLightingUniforms(unsigned int program, const glm::vec2& screenSize) const
+    {
+        glUniform1f(glGetUniformLocation(program, "zNear"), grid.zNear);
+        glUniform1f(glGetUniformLocation(program, "zFar"), grid.zFar);
+        glUniform2f(glGetUniformLocation(program, "screenSize"), screenSize.x, screenSize.y);
+        glUniform1ui(glGetUniformLocation(program, "lightCount"), lightCount);
+        glUniform1ui(glGetUniformLocation(program, "maxLightsPerCluster"), maxLightsPerCluster);
+    }
+
+    // reads back the results of the last assign, in the layout of assignLightsToClusters.
+    // note: this waits for the assignment to finish, only meant for checks and statistics.
+    void readBack(std::vector<unsigned int>& counts, std::vector<unsigned int>& indices) const
+    {
+        counts.resize(grid.clusterCount());
+        indices.resize(static_cast<size_t>(grid.clusterCount()) * maxLightsPerCluster);
+        // assign() only orders the compute writes before shader storage reads, buffer reads need their own bit
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, counts.size() * sizeof(GLuint), counts.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    const ClusterGrid& getGrid() const { return grid; }
+    unsigned int getLightCount() const { return lightCount; }
+    unsigned int getMaxLightsPerCluster() const { return maxLightsPerCluster; }
+
+private:
+    ComputeShader assignShader;
+    ClusterGrid grid;
+    unsigned int maxLightsPerCluster;
+    unsigned int lightBuffer, countBuffer, indexBuffer;
+    unsigned int lightCount = 0;
+    unsigned int lightCapacity = 0;
+};
+#endif
@@ -14,6 +14,20 @@ using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
 
+// bone ids and weights are packed: 8 bit ids (up to 256 bones) and 8 bit normalized weights, or 16 bits each
+// when MESH_16BIT_BONE_DATA is defined before including this header
+#ifdef MESH_16BIT_BONE_DATA
+typedef unsigned short BoneIndex;
+typedef unsigned short BoneWeight;
+#define BONE_DATA_GL_TYPE GL_UNSIGNED_SHORT
+#else
+typedef unsigned char BoneIndex;
+typedef unsigned char BoneWeight;
+#define BONE_DATA_GL_TYPE GL_UNSIGNED_BYTE
+#endif
+const unsigned int MAX_BONE_INDEX = (1u << (8 * sizeof(BoneIndex))) - 1;
+const unsigned int MAX_BONE_WEIGHT = (1u << (8 * sizeof(BoneWeight))) - 1;
+
 struct Vertex {
     // position
     glm::vec3 Position;
@@ -25,12 +39,17 @@ struct Vertex {
     glm::vec3 Tangent;
     // bitangent
     glm::vec3 Bitangent;
-	//bone indexes which will influence this vertex
-	int m_BoneIDs[MAX_BONE_INFLUENCE];
-	//weights from each bone
-	float m_Weights[MAX_BONE_INFLUENCE];
+	//bone indexes which will influence this vertex, strongest first
+	BoneIndex m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone, summing to MAX_BONE_WEIGHT (1.0 in the shader), unused slots are 0
+	BoneWeight m_Weights[MAX_BONE_INFLUENCE];
 };
 
+inline float GetBoneWeight(const Vertex& vertex, int influence)
+{
+    return vertex.m_Weights[influence] / static_cast<float>(MAX_BONE_WEIGHT);
+}
+
 struct Texture {
     unsigned int id;
     string type;
@@ -135,11 +154,11 @@ private:
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 		// ids
 		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+		glVertexAttribIPointer(5, 4, BONE_DATA_GL_TYPE, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
 
-		// weights
+		// weights, normalized to [0, 1]
 		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+		glVertexAttribPointer(6, 4, BONE_DATA_GL_TYPE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
         glBindVertexArray(0);
     }
 };
@@ -18,9 +18,11 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 #include <learnopengl/assimp_glm_helpers.h>
 #include <learnopengl/animdata.h>
+#include <learnopengl/skeleton.h>
 
 using namespace std;
 
@@ -50,12 +52,15 @@ public:
     
 	auto& GetBoneInfoMap() { return m_BoneInfoMap; }
 	int& GetBoneCount() { return m_BoneCounter; }
+	// the node hierarchy and bones, shared by every Animation of this model
+	const std::shared_ptr<const Skeleton>& GetSkeleton() const { return m_Skeleton; }
 	
 
 private:
 
 	std::map<string, BoneInfo> m_BoneInfoMap;
 	int m_BoneCounter = 0;
+	std::shared_ptr<const Skeleton> m_Skeleton;
 
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
@@ -74,6 +79,9 @@ private:
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        // the bones are known once every mesh is processed
+        m_Skeleton = std::make_shared<const Skeleton>(scene->mRootNode, m_BoneInfoMap);
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -95,12 +103,19 @@ private:
 
     }
 
+	// the strongest influences on a vertex while its weights are read, before they are packed into it
+	struct VertexBoneWeights
+	{
+		int boneIDs[MAX_BONE_INFLUENCE] = { -1, -1, -1, -1 };
+		float weights[MAX_BONE_INFLUENCE] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	};
+
 	void SetVertexBoneDataToDefault(Vertex& vertex)
 	{
 		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
 		{
-			vertex.m_BoneIDs[i] = -1;
-			vertex.m_Weights[i] = 0.0f;
+			vertex.m_BoneIDs[i] = 0;
+			vertex.m_Weights[i] = 0;
 		}
 	}
 
@@ -152,17 +167,44 @@ private:
 		return Mesh(vertices, indices, textures);
 	}
 
-	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
+	// keeps the MAX_BONE_INFLUENCE strongest influences sorted by weight, weaker ones are dropped
+	void SetVertexBoneData(VertexBoneWeights& vertex, int boneID, float weight)
 	{
-		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+		int slot = MAX_BONE_INFLUENCE;
+		while (slot > 0 && (vertex.boneIDs[slot - 1] < 0 || vertex.weights[slot - 1] < weight))
+			slot--;
+		if (slot == MAX_BONE_INFLUENCE)
+			return;
+		for (int i = MAX_BONE_INFLUENCE - 1; i > slot; --i)
 		{
-			if (vertex.m_BoneIDs[i] < 0)
-			{
-				vertex.m_Weights[i] = weight;
-				vertex.m_BoneIDs[i] = boneID;
-				break;
-			}
+			vertex.boneIDs[i] = vertex.boneIDs[i - 1];
+			vertex.weights[i] = vertex.weights[i - 1];
+		}
+		vertex.boneIDs[slot] = boneID;
+		vertex.weights[slot] = weight;
+	}
+
+	// renormalizes the kept weights and quantizes them so they sum to exactly MAX_BONE_WEIGHT, the rounding
+	// error goes to the strongest influence
+	void PackVertexBoneData(Vertex& vertex, const VertexBoneWeights& influences)
+	{
+		float total = 0.0f;
+		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+			total += influences.boneIDs[i] < 0 ? 0.0f : influences.weights[i];
+		if (total <= 0.0f)
+			return;
+
+		unsigned int packedTotal = 0;
+		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+		{
+			if (influences.boneIDs[i] < 0)
+				continue;
+			const unsigned int weight = static_cast<unsigned int>(influences.weights[i] / total * MAX_BONE_WEIGHT + 0.5f);
+			vertex.m_BoneIDs[i] = static_cast<BoneIndex>(influences.boneIDs[i]);
+			vertex.m_Weights[i] = static_cast<BoneWeight>(weight);
+			packedTotal += weight;
 		}
+		vertex.m_Weights[0] = static_cast<BoneWeight>(vertex.m_Weights[0] + MAX_BONE_WEIGHT - packedTotal);
 	}
 
 
@@ -170,6 +212,7 @@ private:
 	{
 		auto& boneInfoMap = m_BoneInfoMap;
 		int& boneCount = m_BoneCounter;
+		std::vector<VertexBoneWeights> influences(vertices.size());
 
 		for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
 		{
@@ -189,6 +232,11 @@ private:
 				boneID = boneInfoMap[boneName].id;
 			}
 			assert(boneID != -1);
+			if (boneID > static_cast<int>(MAX_BONE_INDEX))
+			{
+				std::cout << "ERROR::MODEL::TOO_MANY_BONES: " << boneName << " (define MESH_16BIT_BONE_DATA)" << std::endl;
+				continue;
+			}
 			auto weights = mesh->mBones[boneIndex]->mWeights;
 			int numWeights = mesh->mBones[boneIndex]->mNumWeights;
 
@@ -197,9 +245,12 @@ private:
 				int vertexId = weights[weightIndex].mVertexId;
 				float weight = weights[weightIndex].mWeight;
 				assert(vertexId <= vertices.size());
-				SetVertexBoneData(vertices[vertexId], boneID, weight);
+				SetVertexBoneData(influences[vertexId], boneID, weight);
 			}
 		}
+
+		for (size_t i = 0; i < vertices.size(); i++)
+			PackVertexBoneData(vertices[i], influences[i]);
 	}
 
 
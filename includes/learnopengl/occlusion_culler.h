@@ -0,0 +1,205 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_c.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// world space box tested against the occluders, laid out for the std430 bounds buffer
+struct OcclusionBounds
+{
+    glm::vec4 minCorner;
+    glm::vec4 maxCorner;
+};
+
+// Hierarchical-Z occlusion culling. The selected occluders are rendered into a small depth-only target,
+// a compute shader reduces it into a mip pyramid where every texel keeps the farthest depth of the texels
+// it covers, and the boxes of the objects are then tested against the level where they span about 2x2 texels.
+// An object is occluded when its nearest depth lies behind the farthest occluder depth of that footprint.
+// Without compute shaders use OcclusionRasterizer (occlusion_rasterizer.h), the same test on the CPU.
+class HiZOcclusionCuller
+{
+public:
+    // constructor, width/height is the resolution of the occluder depth pass (level 0 of the pyramid)
+    HiZOcclusionCuller(const char* reducePath, const char* cullPath, unsigned int width, unsigned int height)
+        : reduceShader(reducePath), cullShader(cullPath), width(width), height(height)
+    {
+        levels = 1 + static_cast<unsigned int>(std::floor(std::log2(static_cast<float>(std::max(width, height)))));
+
+        // depth-only target of the occluder pre-pass
+        glGenFramebuffers(1, &depthFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+        glGenTextures(1, &depthMap);
+        glBindTexture(GL_TEXTURE_2D, depthMap);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Occlusion depth framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // the pyramid itself, immutable storage so every level can be bound as an image
+        glGenTextures(1, &hiZMap);
+        glBindTexture(GL_TEXTURE_2D, hiZMap);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenBuffers(1, &boundsBuffer);
+        glGenBuffers(1, &visibilityBuffer);
+        glGenBuffers(1, &statsBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), NULL, GL_DYNAMIC_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glGenQueries(1, &timerQuery);
+    }
+
+    // binds the occluder depth target, draw the occluders with a depth-only shader afterwards
+    void beginOccluderPass()
+    {
+        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+        glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+        glViewport(0, 0, width, height);
+        // depth is only written with the depth test enabled
+        depthTestWasEnabled = glIsEnabled(GL_DEPTH_TEST);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // restores the default framebuffer and builds the pyramid from the occluder depth
+    void endOccluderPass(unsigned int screenWidth, unsigned int screenHeight)
+    {
+        if (!depthTestWasEnabled)
+            glDisable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, screenWidth, screenHeight);
+        buildPyramid();
+    }
+
+    // registers an object and returns its index for the visibility queries
+    unsigned int addObject(const glm::vec3& minCorner, const glm::vec3& maxCorner)
+    {
+        objects.push_back({ glm::vec4(minCorner, 1.0f), glm::vec4(maxCorner, 1.0f) });
+        visibility.push_back(1);
+        return static_cast<unsigned int>(objects.size() - 1);
+    }
+
+    void setObjectBounds(unsigned int index, const glm::vec3& minCorner, const glm::vec3& maxCorner)
+    {
+        objects[index] = { glm::vec4(minCorner, 1.0f), glm::vec4(maxCorner, 1.0f) };
+    }
+
+    // tests every object against the pyramid and reads the visibility list back for the draw path.
+    // note: the read back waits for the test to finish; with only a handful of objects that's cheaper than
+    // the draws it saves, for large counts keep the list on the GPU (see InstanceCuller) instead.
+    void cull(const glm::mat4& viewProjection)
+    {
+        const GLuint zero = 0;
+        const GLsizeiptr count = static_cast<GLsizeiptr>(objects.size());
+        if (count == 0)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            return;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(OcclusionBounds), objects.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(GLuint), NULL, GL_STREAM_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+
+        cullShader.use();
+        cullShader.setMat4("viewProjection", viewProjection);
+        cullShader.setInt("objectCount", static_cast<int>(count));
+        cullShader.setInt("hiZLevels", static_cast<int>(levels));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hiZMap);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, boundsBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibilityBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, statsBuffer);
+        glDispatchCompute(static_cast<GLuint>((count + 63) / 64), 1, 1);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(GLuint), visibility.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &occludedCount);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    bool isVisible(unsigned int index) const { return visibility[index] != 0; }
+
+    unsigned int getOccludedCount() const { return occludedCount; }
+    unsigned int getObjectCount() const { return static_cast<unsigned int>(objects.size()); }
+
+    // gpu time of the last finished pre-pass + pyramid + test, in milliseconds
+    float getGpuTimeMs()
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(timerQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+            gpuTimeMs = static_cast<float>(elapsed) / 1000000.0f;
+        }
+        return gpuTimeMs;
+    }
+
+    unsigned int getHiZMap() const { return hiZMap; }
+
+private:
+    ComputeShader reduceShader, cullShader;
+    unsigned int width, height, levels;
+    unsigned int depthFBO, depthMap, hiZMap;
+    unsigned int boundsBuffer, visibilityBuffer, statsBuffer;
+    unsigned int timerQuery;
+    float gpuTimeMs = 0.0f;
+    GLboolean depthTestWasEnabled = GL_FALSE;
+
+    std::vector<OcclusionBounds> objects;
+    std::vector<GLuint> visibility;
+    GLuint occludedCount = 0;
+
+    void buildPyramid()
+    {
+        reduceShader.use();
+        reduceShader.setBool("reduceMax", true);
+
+        // level 0: copy of the occluder depth
+        reduceShader.setBool("copyDepth", true);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthMap);
+        glBindImageTexture(1, hiZMap, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((width + 7) / 8, (height + 7) / 8, 1);
+
+        reduceShader.setBool("copyDepth", false);
+        for (unsigned int level = 1; level < levels; level++)
+        {
+            const unsigned int levelWidth = std::max(1u, width >> level);
+            const unsigned int levelHeight = std::max(1u, height >> level);
+
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            glBindImageTexture(0, hiZMap, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            glBindImageTexture(1, hiZMap, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+        }
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+};
+#endif
@@ -0,0 +1,415 @@
+#ifndef OCCLUSION_RASTERIZER_H
+#define OCCLUSION_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_RASTERIZER_SSE
+#include <emmintrin.h>
+#endif
+
+// triangles of an AABB, indexed like AABB::getVertice()
+const unsigned int OCCLUSION_BOX_INDICES[36] = {
+    0, 2, 1, 1, 2, 3, // -z
+    4, 5, 6, 5, 7, 6, // +z
+    0, 4, 2, 2, 4, 6, // -x
+    1, 3, 5, 3, 7, 5, // +x
+    0, 1, 4, 1, 5, 4, // -y
+    2, 6, 3, 3, 6, 7  // +y
+};
+
+// CPU depth rasterizer for occlusion culling without touching the GPU.
+// Occluders (simplified meshes or plain boxes) are transformed, clipped against the near plane and binned into
+// screen tiles on the threads of a JobSystem; the tiles are then rasterized in parallel, 4 pixels at a time, into a low
+// resolution depth buffer that keeps the nearest occluder depth. Objects are tested by comparing the nearest
+// depth of their box with the occluder depths inside its screen rectangle, before any draw call is recorded.
+class OcclusionRasterizer
+{
+public:
+    static const int TILE_WIDTH = 32; // multiple of the 4 pixel SIMD width
+    static const int TILE_HEIGHT = 16;
+
+    // the SSE paths where they are compiled in; false runs the scalar code, which gives the same depths and results
+    bool simd = true;
+
+    // width/height is the resolution of the depth buffer; the triangles are split into one share per thread of jobs
+    OcclusionRasterizer(unsigned int width, unsigned int height, JobSystem& jobs)
+        : width(width), height(height), jobs(jobs)
+    {
+        tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+        tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+        stride = tilesX * TILE_WIDTH;
+        depth.assign(stride * tilesY * TILE_HEIGHT, 1.0f);
+
+        shareCount = jobs.getThreadCount();
+        shareTriangles.resize(shareCount);
+        shareBins.resize(shareCount, std::vector<std::vector<unsigned int>>(tilesX * tilesY));
+    }
+
+    // starts a new frame, the occluders of the previous frame are dropped
+    void beginFrame(const glm::mat4& viewProjection)
+    {
+        this->viewProjection = viewProjection;
+        batches.clear();
+        boxCorners.clear();
+    }
+
+    // the mesh is only referenced, it has to stay alive until rasterize() returns
+    void addOccluder(const Mesh& mesh, const glm::mat4& modelMatrix)
+    {
+        if (mesh.indices.empty())
+            return;
+        OccluderBatch batch;
+        batch.positions = reinterpret_cast<const unsigned char*>(&mesh.vertices[0].Position);
+        batch.stride = sizeof(Vertex);
+        batch.indices = mesh.indices.data();
+        batch.triangleCount = static_cast<unsigned int>(mesh.indices.size() / 3);
+        batch.mvp = viewProjection * modelMatrix;
+        batches.push_back(batch);
+    }
+
+    void addOccluder(const Model& model, const glm::mat4& modelMatrix)
+    {
+        for (unsigned int i = 0; i < model.meshes.size(); i++)
+            addOccluder(model.meshes[i], modelMatrix);
+    }
+
+    // world space box as occluder, use boxes that lie inside the object they stand in for (conservative)
+    void addOccluder(const AABB& box)
+    {
+        const std::array<glm::vec3, 8> corners = box.getVertice();
+        OccluderBatch batch;
+        batch.positions = nullptr; // resolved in rasterize(), boxCorners may still grow
+        batch.stride = sizeof(glm::vec3);
+        batch.indices = OCCLUSION_BOX_INDICES;
+        batch.triangleCount = 12;
+        batch.mvp = viewProjection;
+        batch.boxIndex = static_cast<int>(boxCorners.size() / 8);
+        boxCorners.insert(boxCorners.end(), corners.begin(), corners.end());
+        batches.push_back(batch);
+    }
+
+    // bins and rasterizes every occluder of this frame into the depth buffer
+    void rasterize()
+    {
+        std::fill(depth.begin(), depth.end(), 1.0f);
+
+        triangleCount = 0;
+        for (unsigned int i = 0; i < batches.size(); i++)
+        {
+            if (batches[i].boxIndex >= 0)
+                batches[i].positions = reinterpret_cast<const unsigned char*>(&boxCorners[batches[i].boxIndex * 8]);
+            batches[i].firstTriangle = triangleCount;
+            triangleCount += batches[i].triangleCount;
+        }
+
+        // 1. every share of the triangles is set up and binned into bins of its own
+        jobs.parallelFor(0, shareCount, 1, [this](unsigned int first, unsigned int last) {
+            for (unsigned int share = first; share < last; share++)
+                binTriangles(share);
+        });
+
+        // 2. the tiles are handed out to the threads, each tile walks the bins of all shares
+        jobs.parallelFor(0, tilesX * tilesY, 1, [this](unsigned int first, unsigned int last) {
+            for (unsigned int tile = first; tile < last; tile++)
+                rasterizeTile(tile);
+        });
+    }
+
+    // true when some part of the world space box may be visible: in front of the camera plane,
+    // on screen and not completely behind the occluders
+    bool isVisible(const AABB& box) const
+    {
+        glm::vec2 screenMin(std::numeric_limits<float>::max()), screenMax(-std::numeric_limits<float>::max());
+        float nearestDepth = 1.0f;
+        const std::array<glm::vec3, 8> corners = box.getVertice();
+        for (int i = 0; i < 8; i++)
+        {
+            const glm::vec4 clip = viewProjection * glm::vec4(corners[i], 1.0f);
+            // crossing the near plane, it can't be bound on screen
+            if (clip.z < -clip.w || clip.w <= 0.0f)
+                return true;
+            const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            screenMin = glm::min(screenMin, glm::vec2((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height));
+            screenMax = glm::max(screenMax, glm::vec2((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height));
+            nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+        }
+
+        const int x0 = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+        const int y0 = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+        const int x1 = std::min(static_cast<int>(width) - 1, static_cast<int>(std::floor(screenMax.x)));
+        const int y1 = std::min(static_cast<int>(height) - 1, static_cast<int>(std::floor(screenMax.y)));
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        for (int y = y0; y <= y1; y++)
+        {
+            const float* row = &depth[y * stride];
+#ifdef OCCLUSION_RASTERIZER_SSE
+            if (simd)
+            {
+                const __m128 nearest = _mm_set1_ps(nearestDepth);
+                const __m128i first = _mm_set1_epi32(x0 - 1);
+                const __m128i last = _mm_set1_epi32(x1 + 1);
+                for (int x = x0 & ~3; x <= x1; x += 4)
+                {
+                    const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0));
+                    const __m128 inside = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(lanes, first), _mm_cmplt_epi32(lanes, last)));
+                    const __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), nearest);
+                    if (_mm_movemask_ps(_mm_and_ps(inside, behind)))
+                        return true;
+                }
+                continue;
+            }
+#endif
+            for (int x = x0; x <= x1; x++)
+            {
+                if (row[x] >= nearestDepth)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    bool isVisible(Entity& entity) const
+    {
+        return isVisible(entity.getGlobalAABB());
+    }
+
+    // walks the scene graph and collects the entities that pass the frustum test and aren't occluded.
+    // returns the number of entities rejected by the occlusion test.
+    unsigned int collectVisibleEntities(Entity& entity, const Frustum& frustum, std::vector<Entity*>& visible) const
+    {
+        unsigned int occluded = 0;
+        if (entity.boundingVolume->isOnFrustum(frustum, entity.transform))
+        {
+            if (isVisible(entity))
+                visible.push_back(&entity);
+            else
+                occluded++;
+        }
+
+        for (auto&& child : entity.children)
+            occluded += collectVisibleEntities(*child, frustum, visible);
+        return occluded;
+    }
+
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    unsigned int getTriangleCount() const { return triangleCount; }
+    float getDepth(unsigned int x, unsigned int y) const { return depth[y * stride + x]; }
+
+private:
+    // edge functions e(x, y) = a * x + b * y + c, positive inside; depth plane z(x, y) = zA * x + zB * y + zC
+    struct RasterTriangle
+    {
+        float a[3], b[3], c[3];
+        float zA, zB, zC;
+        int minX, minY, maxX, maxY;
+    };
+
+    struct OccluderBatch
+    {
+        const unsigned char* positions;
+        size_t stride;
+        const unsigned int* indices;
+        unsigned int triangleCount;
+        unsigned int firstTriangle = 0;
+        glm::mat4 mvp;
+        int boxIndex = -1;
+    };
+
+    unsigned int width, height, stride;
+    unsigned int tilesX, tilesY;
+    JobSystem& jobs;
+    unsigned int shareCount;
+    std::vector<float> depth; // padded to whole tiles, rows are `stride` floats apart
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<OccluderBatch> batches;
+    std::vector<glm::vec3> boxCorners;
+    unsigned int triangleCount = 0;
+
+    std::vector<std::vector<RasterTriangle>> shareTriangles;
+    std::vector<std::vector<std::vector<unsigned int>>> shareBins; // [share][tile] -> index into shareTriangles[share]
+
+    void binTriangles(unsigned int share)
+    {
+        std::vector<RasterTriangle>& triangles = shareTriangles[share];
+        std::vector<std::vector<unsigned int>>& bins = shareBins[share];
+        triangles.clear();
+        for (auto&& bin : bins)
+            bin.clear();
+
+        const unsigned int first = static_cast<unsigned int>(static_cast<unsigned long long>(triangleCount) * share / shareCount);
+        const unsigned int last = static_cast<unsigned int>(static_cast<unsigned long long>(triangleCount) * (share + 1) / shareCount);
+        for (unsigned int b = 0; b < batches.size(); b++)
+        {
+            const OccluderBatch& batch = batches[b];
+            const unsigned int begin = std::max(first, batch.firstTriangle);
+            const unsigned int end = std::min(last, batch.firstTriangle + batch.triangleCount);
+            for (unsigned int t = begin; t < end; t++)
+            {
+                const unsigned int* index = batch.indices + (t - batch.firstTriangle) * 3;
+                glm::vec4 clip[3];
+                for (int v = 0; v < 3; v++)
+                {
+                    const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(batch.positions + index[v] * batch.stride);
+                    clip[v] = batch.mvp * glm::vec4(position, 1.0f);
+                }
+                clipAndSetup(clip, triangles, bins);
+            }
+        }
+    }
+
+    // clips against the near plane (z >= -w), the other planes are handled by the bounding rectangle
+    void clipAndSetup(const glm::vec4 clip[3], std::vector<RasterTriangle>& triangles, std::vector<std::vector<unsigned int>>& bins)
+    {
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec4& current = clip[i];
+            const glm::vec4& next = clip[(i + 1) % 3];
+            const float dCurrent = current.z + current.w;
+            const float dNext = next.z + next.w;
+            if (dCurrent >= 0.0f)
+                polygon[count++] = current;
+            if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+                polygon[count++] = glm::mix(current, next, dCurrent / (dCurrent - dNext));
+        }
+
+        for (int i = 1; i + 1 < count; i++)
+            setupTriangle(polygon[0], polygon[i], polygon[i + 1], triangles, bins);
+    }
+
+    void setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2, std::vector<RasterTriangle>& triangles, std::vector<std::vector<unsigned int>>& bins)
+    {
+        if (c0.w <= 0.0f || c1.w <= 0.0f || c2.w <= 0.0f)
+            return;
+        glm::vec3 v[3] = { toScreen(c0), toScreen(c1), toScreen(c2) };
+
+        float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+        if (std::abs(area) < 1e-8f)
+            return;
+        // both windings occlude
+        if (area < 0.0f)
+        {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        RasterTriangle tri;
+        tri.minX = std::max(0, static_cast<int>(std::floor(std::min(std::min(v[0].x, v[1].x), v[2].x))));
+        tri.minY = std::max(0, static_cast<int>(std::floor(std::min(std::min(v[0].y, v[1].y), v[2].y))));
+        tri.maxX = std::min(static_cast<int>(width) - 1, static_cast<int>(std::ceil(std::max(std::max(v[0].x, v[1].x), v[2].x))));
+        tri.maxY = std::min(static_cast<int>(height) - 1, static_cast<int>(std::ceil(std::max(std::max(v[0].y, v[1].y), v[2].y))));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            return;
+
+        // edge i is opposite of vertex i, so e_i / area is the barycentric weight of vertex i
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec3& from = v[(i + 1) % 3];
+            const glm::vec3& to = v[(i + 2) % 3];
+            tri.a[i] = from.y - to.y;
+            tri.b[i] = to.x - from.x;
+            tri.c[i] = from.x * to.y - from.y * to.x;
+        }
+        const float invArea = 1.0f / area;
+        tri.zA = (tri.a[0] * v[0].z + tri.a[1] * v[1].z + tri.a[2] * v[2].z) * invArea;
+        tri.zB = (tri.b[0] * v[0].z + tri.b[1] * v[1].z + tri.b[2] * v[2].z) * invArea;
+        tri.zC = (tri.c[0] * v[0].z + tri.c[1] * v[1].z + tri.c[2] * v[2].z) * invArea;
+
+        const unsigned int index = static_cast<unsigned int>(triangles.size());
+        triangles.push_back(tri);
+        for (int ty = tri.minY / TILE_HEIGHT; ty <= tri.maxY / TILE_HEIGHT; ty++)
+        {
+            for (int tx = tri.minX / TILE_WIDTH; tx <= tri.maxX / TILE_WIDTH; tx++)
+                bins[ty * tilesX + tx].push_back(index);
+        }
+    }
+
+    glm::vec3 toScreen(const glm::vec4& clip) const
+    {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, std::max(ndc.z * 0.5f + 0.5f, 0.0f));
+    }
+
+    void rasterizeTile(unsigned int tile)
+    {
+        const int tileX0 = (tile % tilesX) * TILE_WIDTH;
+        const int tileY0 = (tile / tilesX) * TILE_HEIGHT;
+        const int tileX1 = tileX0 + TILE_WIDTH - 1;
+        const int tileY1 = tileY0 + TILE_HEIGHT - 1;
+
+        for (unsigned int share = 0; share < shareCount; share++)
+        {
+            const std::vector<RasterTriangle>& triangles = shareTriangles[share];
+            const std::vector<unsigned int>& bin = shareBins[share][tile];
+            for (unsigned int i = 0; i < bin.size(); i++)
+            {
+                const RasterTriangle& tri = triangles[bin[i]];
+                // x starts on a 4 pixel boundary inside the tile, so the SIMD loads never leave it
+                const int xStart = std::max(tri.minX, tileX0) & ~3;
+                const int xEnd = std::min(tri.maxX, tileX1);
+                const int yStart = std::max(tri.minY, tileY0);
+                const int yEnd = std::min(tri.maxY, tileY1);
+                for (int y = yStart; y <= yEnd; y++)
+                {
+                    const float py = y + 0.5f;
+                    float* row = &depth[y * stride];
+#ifdef OCCLUSION_RASTERIZER_SSE
+                    if (simd)
+                    {
+                        const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                        const __m128 zero = _mm_setzero_ps();
+                        const __m128 rowE0 = _mm_set1_ps(tri.b[0] * py + tri.c[0]);
+                        const __m128 rowE1 = _mm_set1_ps(tri.b[1] * py + tri.c[1]);
+                        const __m128 rowE2 = _mm_set1_ps(tri.b[2] * py + tri.c[2]);
+                        const __m128 rowZ = _mm_set1_ps(tri.zB * py + tri.zC);
+                        for (int x = xStart; x <= xEnd; x += 4)
+                        {
+                            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                            const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a[0]), px), rowE0);
+                            const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a[1]), px), rowE1);
+                            const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a[2]), px), rowE2);
+                            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                            if (!_mm_movemask_ps(inside))
+                                continue;
+                            const __m128 z = _mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.zA), px), rowZ), zero);
+                            const __m128 stored = _mm_loadu_ps(row + x);
+                            const __m128 nearest = _mm_min_ps(stored, z);
+                            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+                        }
+                        continue;
+                    }
+#endif
+                    // the row terms are summed first, as in the SSE path, so both round alike
+                    const float rowE0 = tri.b[0] * py + tri.c[0];
+                    const float rowE1 = tri.b[1] * py + tri.c[1];
+                    const float rowE2 = tri.b[2] * py + tri.c[2];
+                    const float rowZ = tri.zB * py + tri.zC;
+                    for (int x = xStart; x < xStart + ((xEnd - xStart) / 4 + 1) * 4; x++)
+                    {
+                        const float px = x + 0.5f;
+                        if (tri.a[0] * px + rowE0 < 0.0f || tri.a[1] * px + rowE1 < 0.0f || tri.a[2] * px + rowE2 < 0.0f)
+                            continue;
+                        const float z = std::max(tri.zA * px + rowZ, 0.0f);
+                        row[x] = std::min(row[x], z);
+                    }
+                }
+            }
+        }
+    }
+};
+#endif
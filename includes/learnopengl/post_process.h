@@ -0,0 +1,315 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/render_graph.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// the effects of the post-processing chain in the order they are applied; the names double as the defines that
+// switch them on in the uber shader
+enum PostEffect
+{
+    POST_BLOOM,         // adds the blurred bright pixels
+    POST_TONEMAP,       // exposure tonemapping, keyed or from auto_exposure.h
+    POST_COLOR_GRADING, // 3D LUT lookup
+    POST_KERNEL,        // 3x3 kernel of the framebuffers chapter, reads neighbouring pixels
+    POST_VIGNETTE,
+    POST_GAMMA,
+    POST_DITHER,
+    POST_EFFECT_COUNT
+};
+const char* const postEffectNames[POST_EFFECT_COUNT] = {
+    "POST_BLOOM", "POST_TONEMAP", "POST_COLOR_GRADING", "POST_KERNEL", "POST_VIGNETTE", "POST_GAMMA", "POST_DITHER" };
+
+// Post-processing chain that fuses its enabled effects into as few fullscreen passes as possible. Effects that only
+// look at their own pixel are chained inside one fragment shader, generated from the uber shader by defining the
+// effects of the pass, so the color stays in registers instead of going through a full resolution target between
+// them. A pass only ends where an effect reads neighbouring pixels (the 3x3 kernel): those need the effects before
+// them finished for the whole image, so they start a new pass that reads the previous one's RGBA16F result.
+// With fused off every effect gets its own pass, the classic one-target-per-effect chain, for comparison.
+// Programs are compiled the first time a combination of effects is used.
+class PostProcess
+{
+public:
+    bool enabled[POST_EFFECT_COUNT] = { true, true, false, false, false, true, false };
+    bool fused = true;
+    float bloomStrength = 1.0f;
+    float exposure = 1.0f;
+    bool autoExposure = false;
+    unsigned int exposureTexture = 0; // see AutoExposure::getExposureTexture
+    unsigned int colorGradingLUT = 0; // GL_TEXTURE_3D, linearly filtered
+    int kernelMode = 0;               // 0: sharpen, 1: blur, 2: edge detection
+    float vignetteStrength = 0.4f;
+
+    PostProcess(const char* vertexPath, const char* fragmentPath)
+    {
+        vertexCode = readFile(vertexPath);
+        fragmentCode = readFile(fragmentPath);
+        glGenFramebuffers(1, &framebuffer);
+        glGenVertexArrays(1, &emptyVAO); // the passes draw one screen covering triangle from gl_VertexID
+    }
+
+    ~PostProcess()
+    {
+        for (const auto& program : programs)
+            glDeleteProgram(program.second);
+        glDeleteTextures(2, intermediates);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    // the effects of every pass as a bit mask of (1 << PostEffect)
+    std::vector<unsigned int> planPasses() const
+    {
+        std::vector<unsigned int> passes;
+        for (int effect = 0; effect < POST_EFFECT_COUNT; effect++)
+        {
+            if (!enabled[effect])
+                continue;
+            if (passes.empty() || !fused || readsNeighbours((PostEffect)effect))
+                passes.push_back(0);
+            passes.back() |= 1u << effect;
+        }
+        return passes;
+    }
+
+    // runs the chain on the hdr source texture and writes the result into target (0 for the default framebuffer),
+    // all width x height
+    void render(unsigned int source, unsigned int bloomTexture, unsigned int width, unsigned int height, unsigned int target = 0)
+    {
+        std::vector<unsigned int> passes = planPasses();
+        if (passes.empty())
+            passes.push_back(0); // nothing enabled: a plain copy
+        if (passes.size() > 1)
+            resizeIntermediates(width, height);
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glViewport(0, 0, width, height);
+        for (size_t pass = 0; pass < passes.size(); pass++)
+        {
+            const bool last = pass + 1 == passes.size();
+            if (last)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, target);
+            }
+            else
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, intermediates[pass % 2], 0);
+            }
+            drawPass(passes[pass], pass == 0 ? source : intermediates[(pass - 1) % 2], bloomTexture);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    // the same chain as passes of a render graph, with the intermediates transient textures of the graph; the last
+    // pass draws into target, or the default framebuffer for NONE. bloomTexture may be NONE with the bloom disabled.
+    void addPasses(RenderGraph& graph, RenderGraph::Resource source, RenderGraph::Resource bloomTexture, RenderGraph::Resource target = RenderGraph::NONE)
+    {
+        std::vector<unsigned int> passes = planPasses();
+        if (passes.empty())
+            passes.push_back(0);
+        const RenderGraphTexture size = graph.getDescription(source);
+        RenderGraph::Resource input = source;
+        for (size_t pass = 0; pass < passes.size(); pass++)
+        {
+            const bool last = pass + 1 == passes.size();
+            const unsigned int effects = passes[pass];
+            const bool bloom = (effects & (1u << POST_BLOOM)) != 0;
+            RenderGraph::Resource output = target;
+            if (!last)
+                output = graph.createTexture("post intermediate", RenderGraphTexture(size.width, size.height, GL_RGBA16F));
+            RenderGraph::PassBuilder builder = graph.addPass(std::string("post process ") + std::to_string(pass), PASS_RASTER,
+                [this, &graph, effects, input, bloom, bloomTexture]() {
+                    drawPass(effects, graph.getTexture(input), bloom ? graph.getTexture(bloomTexture) : 0);
+                });
+            builder.read(input);
+            if (bloom)
+                builder.read(bloomTexture);
+            if (output != RenderGraph::NONE)
+                builder.write(output);
+            else
+                builder.sideEffect();
+            input = output;
+        }
+    }
+
+    // bytes the passes read from and write to full screen targets for one width x height frame: the hdr source, the
+    // RGBA16F intermediates, the bloom texture and an 8 bit RGBA target. Lookups of the LUT and the exposure texel
+    // stay in the texture cache and aren't counted, the kernel's 9 taps count once for the same reason.
+    unsigned long long estimateTraffic(unsigned int source, unsigned int bloomTexture, unsigned int width, unsigned int height) const
+    {
+        const unsigned long long pixels = (unsigned long long)width * height;
+        std::vector<unsigned int> passes = planPasses();
+        unsigned long long bytes = 0;
+        for (size_t pass = 0; pass < passes.size(); pass++)
+        {
+            bytes += pass == 0 ? textureBytes(source) : pixels * 8;
+            if (passes[pass] & (1u << POST_BLOOM))
+                bytes += textureBytes(bloomTexture);
+            bytes += pass + 1 == passes.size() ? pixels * 4 : pixels * 8;
+        }
+        return bytes;
+    }
+
+    static bool readsNeighbours(PostEffect effect) { return effect == POST_KERNEL; }
+
+private:
+    std::string vertexCode;
+    std::string fragmentCode;
+    std::map<unsigned int, unsigned int> programs; // by effect mask
+    unsigned int framebuffer;
+    unsigned int emptyVAO;
+    unsigned int intermediates[2] = { 0, 0 };
+    unsigned int intermediateWidth = 0, intermediateHeight = 0;
+
+    // one pass with the effects of the mask, into the bound framebuffer
+    void drawPass(unsigned int effects, unsigned int input, unsigned int bloomTexture)
+    {
+        usePass(effects);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, exposureTexture);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_3D, colorGradingLUT);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+
+    void usePass(unsigned int effects)
+    {
+        auto found = programs.find(effects);
+        unsigned int program = found != programs.end() ? found->second : (programs[effects] = buildProgram(effects));
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "source"), 0);
+        glUniform1i(glGetUniformLocation(program, "bloomBlur"), 1);
+        glUniform1i(glGetUniformLocation(program, "exposureTexture"), 2);
+        glUniform1i(glGetUniformLocation(program, "colorGradingLUT"), 3);
+        glUniform1f(glGetUniformLocation(program, "bloomStrength"), bloomStrength);
+        glUniform1f(glGetUniformLocation(program, "exposure"), exposure);
+        glUniform1i(glGetUniformLocation(program, "autoExposure"), (int)autoExposure);
+        glUniform1i(glGetUniformLocation(program, "kernelMode"), kernelMode);
+        glUniform1f(glGetUniformLocation(program, "vignetteStrength"), vignetteStrength);
+    }
+
+    // the uber shader with the pass' effects defined right after its #version line
+    unsigned int buildProgram(unsigned int effects)
+    {
+        std::string defines;
+        for (int effect = 0; effect < POST_EFFECT_COUNT; effect++)
+        {
+            if (effects & (1u << effect))
+                defines += std::string("#define ") + postEffectNames[effect] + "\n";
+        }
+        std::string fragment = fragmentCode;
+        fragment.insert(fragment.find('\n') + 1, defines);
+
+        unsigned int vertexShader = compile(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+        unsigned int fragmentShader = compile(GL_FRAGMENT_SHADER, fragment, "FRAGMENT");
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, 1024, NULL, infoLog);
+            std::cout << "ERROR::POST_PROCESS::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return program;
+    }
+
+    static unsigned int compile(GLenum type, const std::string& code, const char* typeName)
+    {
+        const char* source = code.c_str();
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::POST_PROCESS::SHADER_COMPILATION_ERROR of type: " << typeName << "\n" << infoLog << std::endl;
+        }
+        return shader;
+    }
+
+    static std::string readFile(const char* path)
+    {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            return stream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::POST_PROCESS::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+        }
+        return std::string();
+    }
+
+    void resizeIntermediates(unsigned int width, unsigned int height)
+    {
+        if (intermediates[0] != 0 && width == intermediateWidth && height == intermediateHeight)
+            return;
+        glDeleteTextures(2, intermediates);
+        glGenTextures(2, intermediates);
+        for (unsigned int texture : intermediates)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        intermediateWidth = width;
+        intermediateHeight = height;
+    }
+
+    // size of level 0 of a texture, by its internal format
+    static unsigned long long textureBytes(unsigned int texture)
+    {
+        GLint width = 0, height = 0, format = 0;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+        unsigned long long bytesPerTexel = 4; // RGBA8, R11F_G11F_B10F, RGB10_A2, R32F
+        if (format == GL_RGBA16F || format == GL_RG32F)
+            bytesPerTexel = 8;
+        else if (format == GL_RGB16F)
+            bytesPerTexel = 6;
+        else if (format == GL_RGBA32F)
+            bytesPerTexel = 16;
+        return (unsigned long long)width * height * bytesPerTexel;
+    }
+};
+#endif
@@ -0,0 +1,568 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// What a pass runs on: raster passes draw into a framebuffer the graph builds from their writes, compute passes
+// write their textures as images
+enum RenderGraphPassType
+{
+    PASS_RASTER,
+    PASS_COMPUTE
+};
+
+// How a pass touches a texture, decides the memory barriers in front of it
+enum RenderGraphAccess
+{
+    ACCESS_SAMPLED,    // through a sampler (texture, texelFetch)
+    ACCESS_ATTACHMENT, // as a color or depth attachment
+    ACCESS_IMAGE       // image load / store
+};
+
+// Size and format of a graph texture. Textures of the same size, format and level count alias each other, the filter
+// is set again whenever a texture is handed to another resource. With more than one level the minification filter
+// picks the nearest (or for linear, the blend of the nearest two) mips.
+struct RenderGraphTexture
+{
+    unsigned int width, height;
+    GLenum internalFormat;
+    GLenum filter;
+    unsigned int levels;
+
+    RenderGraphTexture(unsigned int width = 0, unsigned int height = 0, GLenum internalFormat = GL_RGBA8, GLenum filter = GL_LINEAR, unsigned int levels = 1)
+        : width(width), height(height), internalFormat(internalFormat), filter(filter), levels(levels) {}
+
+    bool aliases(const RenderGraphTexture& other) const
+    {
+        return width == other.width && height == other.height && internalFormat == other.internalFormat && levels == other.levels;
+    }
+
+    unsigned long long bytes() const
+    {
+        unsigned long long total = 0;
+        unsigned int levelWidth = width, levelHeight = height;
+        for (unsigned int level = 0; level < levels; level++)
+        {
+            total += (unsigned long long)levelWidth * levelHeight * bytesPerTexel(internalFormat);
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+        }
+        return total;
+    }
+
+    static unsigned int bytesPerTexel(GLenum internalFormat)
+    {
+        switch (internalFormat)
+        {
+        case GL_R8:                                     return 1;
+        case GL_RG8: case GL_R16F:                      return 2;
+        case GL_RGBA8: case GL_RG16: case GL_RG16F: case GL_R32F: case GL_R11F_G11F_B10F: case GL_RGB10_A2:
+        case GL_DEPTH_COMPONENT24: case GL_DEPTH24_STENCIL8: case GL_DEPTH_COMPONENT32F: return 4;
+        case GL_RGB16F:                                 return 6;
+        case GL_RGBA16F: case GL_RG32F:                 return 8;
+        case GL_RGBA32F:                                return 16;
+        }
+        std::cout << "ERROR::RENDER_GRAPH::UNKNOWN_FORMAT: 0x" << std::hex << internalFormat << std::dec << std::endl;
+        return 4;
+    }
+
+    bool isDepth() const
+    {
+        return internalFormat == GL_DEPTH_COMPONENT24 || internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH_COMPONENT32F;
+    }
+};
+
+// A frame graph (O'Donnell, "FrameGraph: Extensible Rendering Architecture in Frostbite"). Every frame the passes are
+// declared with the textures they read and write, then execute() works out what actually has to run:
+// - passes none of whose writes are read later (or are imported, exported or have side effects) are culled, so a
+//   disabled effect only has to stop reading a texture to drop every pass feeding it
+// - every transient texture lives from the first to the last pass that uses it, and textures whose lifetimes don't
+//   overlap share one GL texture. GL can't place textures of different formats into the same memory, so only
+//   textures of the same size and format alias; a 10 pass ping-pong blur still gets by with two.
+// - the GL textures are kept in a pool from frame to frame and only deleted after a few frames without use, so a
+//   steady frame creates nothing
+// - compute passes write through image stores, which GL doesn't order against later reads: the graph issues the
+//   glMemoryBarrier bits for how the next pass reads or writes each texture, and none otherwise
+// Raster passes get a framebuffer with their writes attached (color in the order declared, depth by its format) and
+// a viewport of their size; passes without writes draw into the default framebuffer with the viewport execute() was
+// called with. Textures are looked up with getTexture() inside the passes, the handles stay valid until reset().
+class RenderGraph
+{
+public:
+    typedef unsigned int Resource;
+    typedef std::function<void()> Execute;
+    static const Resource NONE = ~0u;               // an empty color attachment, keeps the later outputs' locations
+    static const unsigned int RETIRE_AFTER_FRAMES = 4;
+
+    // declares what a pass reads and writes
+    class PassBuilder
+    {
+    public:
+        PassBuilder(RenderGraph& graph, unsigned int pass) : graph(graph), pass(pass) {}
+
+        PassBuilder& read(Resource resource, RenderGraphAccess access = ACCESS_SAMPLED)
+        {
+            graph.passes[pass].reads.push_back({ resource, access });
+            return *this;
+        }
+
+        // preserve: the pass only adds to what's there (blending, in place) and reads the earlier contents
+        PassBuilder& write(Resource resource, bool preserve = false)
+        {
+            Pass& declared = graph.passes[pass];
+            RenderGraphAccess access = declared.type == PASS_RASTER ? ACCESS_ATTACHMENT : ACCESS_IMAGE;
+            declared.writes.push_back({ resource, access });
+            if (preserve && resource != NONE)
+                declared.reads.push_back({ resource, access });
+            return *this;
+        }
+
+        // the pass has effects outside the graph (the default framebuffer, a readback) and is never culled
+        PassBuilder& sideEffect()
+        {
+            graph.passes[pass].sideEffect = true;
+            return *this;
+        }
+
+    private:
+        RenderGraph& graph;
+        unsigned int pass;
+    };
+
+    RenderGraph() {}
+
+    ~RenderGraph()
+    {
+        for (const auto& framebuffer : framebuffers)
+            glDeleteFramebuffers(1, &framebuffer.second);
+        for (const PooledTexture& pooled : pool)
+            glDeleteTextures(1, &pooled.texture);
+    }
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // drops the passes and resources of the last frame, the pooled textures stay
+    void reset()
+    {
+        passes.clear();
+        resources.clear();
+        compiled = false;
+    }
+
+    // a texture only this frame's passes use, allocated (or aliased) by the graph
+    Resource createTexture(const std::string& name, const RenderGraphTexture& description)
+    {
+        resources.push_back(VirtualTexture(name, description));
+        return (Resource)resources.size() - 1;
+    }
+
+    // a texture owned outside the graph (history of earlier frames, the result of a precomputation); never aliased
+    // and the passes writing it are never culled
+    Resource importTexture(const std::string& name, unsigned int texture, const RenderGraphTexture& description)
+    {
+        resources.push_back(VirtualTexture(name, description));
+        resources.back().imported = texture;
+        return (Resource)resources.size() - 1;
+    }
+
+    // keeps a transient texture alive to the end of the frame, to be read with getTexture after execute()
+    void exportTexture(Resource resource) { resources[resource].exported = true; }
+
+    PassBuilder addPass(const std::string& name, RenderGraphPassType type, Execute execute)
+    {
+        passes.push_back(Pass(name, type, execute));
+        return PassBuilder(*this, (unsigned int)passes.size() - 1);
+    }
+
+    unsigned int getTexture(Resource resource) const
+    {
+        const VirtualTexture& virtualTexture = resources[resource];
+        return virtualTexture.imported != 0 ? virtualTexture.imported : virtualTexture.texture;
+    }
+
+    const RenderGraphTexture& getDescription(Resource resource) const { return resources[resource].description; }
+
+    // culls the passes and assigns the GL textures; execute() does it when it hasn't been done yet
+    void compile()
+    {
+        frame++;
+        cull();
+        allocate();
+        compiled = true;
+    }
+
+    void execute()
+    {
+        if (!compiled)
+            compile();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        barrierCount = 0;
+        for (Pass& pass : passes)
+        {
+            if (pass.culled)
+                continue;
+            insertBarriers(pass);
+            if (pass.type == PASS_RASTER)
+                bindFramebuffer(pass, viewport);
+            pass.execute();
+            if (pass.type == PASS_COMPUTE)
+            {
+                for (const Access& write : pass.writes)
+                {
+                    if (write.resource != NONE)
+                        pendingBarriers[getTexture(write.resource)] = ALL_BARRIERS;
+                }
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        retire();
+    }
+
+    // after compile(): passes declared and passes culled this frame, the memory barriers issued by the last execute()
+    unsigned int getPassCount() const { return (unsigned int)passes.size(); }
+    unsigned int getCulledPassCount() const
+    {
+        unsigned int culled = 0;
+        for (const Pass& pass : passes)
+            culled += pass.culled ? 1 : 0;
+        return culled;
+    }
+    unsigned int getBarrierCount() const { return barrierCount; }
+
+    // after compile(): bytes of the GL textures this frame's transient resources share, what they would take with a
+    // texture each, and what the pool holds in all (this frame's and the ones waiting to be retired)
+    unsigned long long getTextureBytes() const
+    {
+        unsigned long long bytes = 0;
+        for (const PooledTexture& pooled : pool)
+            bytes += pooled.lastFrame == frame ? pooled.description.bytes() : 0;
+        return bytes;
+    }
+    unsigned long long getUnaliasedTextureBytes() const
+    {
+        unsigned long long bytes = 0;
+        for (const VirtualTexture& virtualTexture : resources)
+            bytes += virtualTexture.imported == 0 && virtualTexture.texture != 0 ? virtualTexture.description.bytes() : 0;
+        return bytes;
+    }
+    unsigned long long getPoolBytes() const
+    {
+        unsigned long long bytes = 0;
+        for (const PooledTexture& pooled : pool)
+            bytes += pooled.description.bytes();
+        return bytes;
+    }
+
+private:
+    static const GLbitfield ALL_BARRIERS = GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+
+    struct Access
+    {
+        Resource resource;
+        RenderGraphAccess access;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        RenderGraphPassType type;
+        Execute execute;
+        std::vector<Access> reads, writes;
+        bool sideEffect = false;
+        bool culled = false;
+
+        Pass(const std::string& name, RenderGraphPassType type, Execute execute) : name(name), type(type), execute(execute) {}
+    };
+
+    struct VirtualTexture
+    {
+        std::string name;
+        RenderGraphTexture description;
+        unsigned int imported = 0; // the outside texture, 0 for a transient one
+        bool exported = false;
+        unsigned int texture = 0;  // the pooled texture it got this frame
+        int physical = -1;         // its index into the pool, while allocating
+        int firstPass = -1, lastPass = -1;
+
+        VirtualTexture(const std::string& name, const RenderGraphTexture& description) : name(name), description(description) {}
+    };
+
+    struct PooledTexture
+    {
+        unsigned int texture;
+        RenderGraphTexture description; // the filter as last set
+        bool busy;                      // handed to a resource whose lifetime hasn't ended at the pass being allocated
+        unsigned int lastFrame;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<VirtualTexture> resources;
+    std::vector<PooledTexture> pool;
+    std::map<std::vector<unsigned int>, unsigned int> framebuffers; // by the attached textures, NONE for empty ones
+    std::map<unsigned int, GLbitfield> pendingBarriers;             // barriers owed after image stores, by texture
+    unsigned int frame = 0;
+    unsigned int barrierCount = 0;
+    bool compiled = false;
+
+    // backwards through the passes: a pass is needed if it has side effects or writes something imported, exported
+    // or read by a needed pass after it; what it reads is then needed before it
+    void cull()
+    {
+        std::vector<bool> readLater(resources.size(), false);
+        for (int i = (int)passes.size() - 1; i >= 0; i--)
+        {
+            Pass& pass = passes[i];
+            bool needed = pass.sideEffect;
+            for (const Access& write : pass.writes)
+            {
+                if (write.resource != NONE)
+                    needed = needed || resources[write.resource].imported != 0 || resources[write.resource].exported || readLater[write.resource];
+            }
+            pass.culled = !needed;
+            if (!needed)
+                continue;
+            for (const Access& write : pass.writes)
+            {
+                if (write.resource != NONE)
+                    readLater[write.resource] = false;
+            }
+            for (const Access& read : pass.reads)
+                readLater[read.resource] = true;
+        }
+    }
+
+    // lifetimes over the remaining passes, then one walk through them handing out pooled textures at the first use
+    // and taking them back after the last
+    void allocate()
+    {
+        for (VirtualTexture& virtualTexture : resources)
+        {
+            virtualTexture.texture = 0;
+            virtualTexture.physical = -1;
+            virtualTexture.firstPass = virtualTexture.lastPass = -1;
+        }
+        for (int i = 0; i < (int)passes.size(); i++)
+        {
+            if (passes[i].culled)
+                continue;
+            for (const std::vector<Access>* accesses : { &passes[i].reads, &passes[i].writes })
+            {
+                for (const Access& access : *accesses)
+                {
+                    if (access.resource == NONE)
+                        continue;
+                    VirtualTexture& virtualTexture = resources[access.resource];
+                    if (virtualTexture.firstPass < 0)
+                    {
+                        virtualTexture.firstPass = i;
+                        if (accesses == &passes[i].reads && virtualTexture.imported == 0)
+                            std::cout << "ERROR::RENDER_GRAPH::READ_BEFORE_WRITE: " << virtualTexture.name << " in " << passes[i].name << std::endl;
+                    }
+                    virtualTexture.lastPass = virtualTexture.exported ? (int)passes.size() : i;
+                }
+            }
+        }
+
+        for (PooledTexture& pooled : pool)
+            pooled.busy = false;
+        for (int i = 0; i < (int)passes.size(); i++)
+        {
+            for (VirtualTexture& virtualTexture : resources)
+            {
+                if (virtualTexture.firstPass == i && virtualTexture.imported == 0)
+                {
+                    virtualTexture.physical = acquire(virtualTexture.description);
+                    virtualTexture.texture = pool[virtualTexture.physical].texture;
+                }
+            }
+            for (VirtualTexture& virtualTexture : resources)
+            {
+                if (virtualTexture.lastPass == i && virtualTexture.physical >= 0)
+                    pool[virtualTexture.physical].busy = false;
+            }
+        }
+    }
+
+    int acquire(const RenderGraphTexture& description)
+    {
+        int found = -1;
+        for (int i = 0; i < (int)pool.size() && found < 0; i++)
+        {
+            if (!pool[i].busy && pool[i].description.aliases(description))
+                found = i;
+        }
+        if (found < 0)
+        {
+            pool.push_back({ createTexture(description), description, false, frame });
+            found = (int)pool.size() - 1;
+        }
+
+        PooledTexture& pooled = pool[found];
+        pooled.busy = true;
+        pooled.lastFrame = frame;
+        if (pooled.description.filter != description.filter)
+        {
+            glBindTexture(GL_TEXTURE_2D, pooled.texture);
+            setFilter(description);
+            pooled.description.filter = description.filter;
+        }
+        return found;
+    }
+
+    static unsigned int createTexture(const RenderGraphTexture& description)
+    {
+        GLenum format = GL_RGBA, type = GL_FLOAT;
+        switch (description.internalFormat)
+        {
+        case GL_R8: case GL_R16F: case GL_R32F:                         format = GL_RED; break;
+        case GL_RG8: case GL_RG16: case GL_RG16F: case GL_RG32F:        format = GL_RG; break;
+        case GL_RGB16F: case GL_R11F_G11F_B10F:                         format = GL_RGB; break;
+        case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F:          format = GL_DEPTH_COMPONENT; break;
+        case GL_DEPTH24_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; break;
+        }
+
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        unsigned int width = description.width, height = description.height;
+        for (unsigned int level = 0; level < description.levels; level++)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, description.internalFormat, width, height, 0, format, type, NULL);
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, description.levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        setFilter(description);
+        return texture;
+    }
+
+    // on the bound texture
+    static void setFilter(const RenderGraphTexture& description)
+    {
+        GLenum minFilter = description.filter;
+        if (description.levels > 1)
+            minFilter = description.filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, description.filter);
+    }
+
+    // one glMemoryBarrier with the bits this pass' accesses owe to earlier image stores into the same textures
+    void insertBarriers(const Pass& pass)
+    {
+        GLbitfield bits = 0;
+        for (const std::vector<Access>* accesses : { &pass.reads, &pass.writes })
+        {
+            for (const Access& access : *accesses)
+            {
+                if (access.resource == NONE)
+                    continue;
+                auto pending = pendingBarriers.find(getTexture(access.resource));
+                if (pending == pendingBarriers.end())
+                    continue;
+                if (access.access == ACCESS_SAMPLED)
+                    bits |= pending->second & GL_TEXTURE_FETCH_BARRIER_BIT;
+                else if (access.access == ACCESS_ATTACHMENT)
+                    bits |= pending->second & GL_FRAMEBUFFER_BARRIER_BIT;
+                else
+                    bits |= pending->second & GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+            }
+        }
+        if (bits == 0)
+            return;
+        glMemoryBarrier(bits);
+        barrierCount++;
+        // the barrier is global, it covers every texture owing these bits
+        for (auto pending = pendingBarriers.begin(); pending != pendingBarriers.end();)
+        {
+            pending->second &= ~bits;
+            pending = pending->second == 0 ? pendingBarriers.erase(pending) : std::next(pending);
+        }
+    }
+
+    void bindFramebuffer(const Pass& pass, const GLint* defaultViewport)
+    {
+        std::vector<unsigned int> attachments;
+        const RenderGraphTexture* size = nullptr;
+        for (const Access& write : pass.writes)
+        {
+            attachments.push_back(write.resource == NONE ? NONE : getTexture(write.resource));
+            if (write.resource != NONE && size == nullptr)
+                size = &resources[write.resource].description;
+        }
+        if (size == nullptr)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(defaultViewport[0], defaultViewport[1], defaultViewport[2], defaultViewport[3]);
+            return;
+        }
+
+        auto found = framebuffers.find(attachments);
+        if (found == framebuffers.end())
+            found = framebuffers.insert(std::make_pair(attachments, createFramebuffer(pass))).first;
+        glBindFramebuffer(GL_FRAMEBUFFER, found->second);
+        glViewport(0, 0, size->width, size->height);
+    }
+
+    unsigned int createFramebuffer(const Pass& pass) const
+    {
+        unsigned int framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (const Access& write : pass.writes)
+        {
+            if (write.resource != NONE && resources[write.resource].description.isDepth())
+            {
+                GLenum attachment = resources[write.resource].description.internalFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, getTexture(write.resource), 0);
+                continue;
+            }
+            GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+            if (write.resource != NONE)
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, getTexture(write.resource), 0);
+            drawBuffers.push_back(write.resource != NONE ? attachment : GL_NONE);
+        }
+        if (drawBuffers.empty())
+            glDrawBuffer(GL_NONE);
+        else
+            glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_NOT_COMPLETE: " << pass.name << std::endl;
+        return framebuffer;
+    }
+
+    // deletes the pooled textures no frame has used for a while, and the framebuffers they are attached to
+    void retire()
+    {
+        for (int i = (int)pool.size() - 1; i >= 0; i--)
+        {
+            if (frame - pool[i].lastFrame <= RETIRE_AFTER_FRAMES)
+                continue;
+            const unsigned int texture = pool[i].texture;
+            for (auto framebuffer = framebuffers.begin(); framebuffer != framebuffers.end();)
+            {
+                bool attached = std::find(framebuffer->first.begin(), framebuffer->first.end(), texture) != framebuffer->first.end();
+                if (attached)
+                    glDeleteFramebuffers(1, &framebuffer->second);
+                framebuffer = attached ? framebuffers.erase(framebuffer) : std::next(framebuffer);
+            }
+            pendingBarriers.erase(texture);
+            glDeleteTextures(1, &texture);
+            pool.erase(pool.begin() + i);
+        }
+    }
+};
+#endif
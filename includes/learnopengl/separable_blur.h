@@ -0,0 +1,201 @@
+#ifndef SEPARABLE_BLUR_H
+#define SEPARABLE_BLUR_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_c.h>
+#include <learnopengl/render_graph.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Gaussian blur of any radius in two separable passes. With compute shaders (GL 4.3) every workgroup walks one row
+// (or column) of the image in tiles: the tile and the radius wide apron on both sides are fetched into shared memory
+// once, and all 2 * radius + 1 taps of a pixel then read shared memory instead of the texture. The apron of the next
+// tile is carried over from the current one, so every texel of a line is fetched exactly once per pass.
+// A line never reads a texel it has already written, so the passes may blur a texture in place (source ==
+// destination), e.g. a bloom mip, without a second texture.
+// Without compute shaders the fragment fallback folds every pair of neighbouring taps into a single bilinear fetch
+// (Rakos, "Efficient Gaussian blur with linear sampling"), about radius + 1 fetches per pixel instead of 2 * radius + 1.
+// It needs linearly filtered textures and a temporary texture of the same size.
+class SeparableBlur
+{
+public:
+    static const unsigned int MAX_RADIUS = 32; // keep in sync with the shaders
+
+    SeparableBlur(const char* computePath, const char* vertexPath, const char* fragmentPath)
+        : fragmentShader(vertexPath, fragmentPath)
+    {
+        if (GLAD_GL_VERSION_4_3)
+            computeShader.reset(new ComputeShader(computePath));
+        glGenFramebuffers(1, &framebuffer);
+        glGenVertexArrays(1, &emptyVAO); // the fragment passes draw one screen covering triangle from gl_VertexID
+
+        fragmentShader.use();
+        fragmentShader.setInt("source", 0);
+    }
+
+    ~SeparableBlur()
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteProgram(fragmentShader.ID);
+        if (computeShader)
+            glDeleteProgram(computeShader->ID);
+    }
+
+    SeparableBlur(const SeparableBlur&) = delete;
+    SeparableBlur& operator=(const SeparableBlur&) = delete;
+
+    // false on contexts below 4.3, every blur then takes the fragment path
+    bool hasCompute() const { return computeShader != nullptr; }
+
+    // normalized weights of the taps 0..radius of a gaussian, each of the taps 1..radius is used on both sides
+    static std::vector<float> gaussianWeights(unsigned int radius, float sigma)
+    {
+        std::vector<float> weights(radius + 1);
+        float sum = 0.0f;
+        for (unsigned int i = 0; i <= radius; i++)
+        {
+            weights[i] = std::exp(-0.5f * i * i / (sigma * sigma));
+            sum += i == 0 ? weights[i] : 2.0f * weights[i];
+        }
+        for (float& weight : weights)
+            weight /= sum;
+        return weights;
+    }
+
+    // blurs source into destination (both width x height) with 2 * radius + 1 taps per direction; sigma of 0 picks
+    // radius / 3, where the cut off tails hold about 0.3% of the kernel. source may be destination on the compute
+    // path; the fragment path (taken when fragmentPath is set or without compute shaders) goes through temporary.
+    void blur(unsigned int source, unsigned int destination, unsigned int temporary, unsigned int width, unsigned int height,
+              unsigned int radius, float sigma = 0.0f, bool fragmentPath = false)
+    {
+        const unsigned int maxRadius = MAX_RADIUS; // std::min binds a reference, MAX_RADIUS has no definition to bind to
+        radius = std::max(1u, std::min(radius, maxRadius));
+        std::vector<float> weights = gaussianWeights(radius, sigma > 0.0f ? sigma : radius / 3.0f);
+        if (computeShader && !fragmentPath)
+        {
+            blurCompute(source, destination, width, height, radius, weights);
+            // whatever comes next may read the destination
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        else
+        {
+            blurFragment(source, destination, temporary, width, height, radius, weights);
+        }
+    }
+
+    // the same blur as passes of a render graph: one compute pass, after which the graph issues only the barrier the
+    // destination's next use needs, or on the fragment path two raster passes through a transient temporary texture
+    void addPasses(RenderGraph& graph, RenderGraph::Resource source, RenderGraph::Resource destination, unsigned int radius, float sigma = 0.0f,
+                   bool fragmentPath = false)
+    {
+        const unsigned int maxRadius = MAX_RADIUS;
+        radius = std::max(1u, std::min(radius, maxRadius));
+        std::vector<float> weights = gaussianWeights(radius, sigma > 0.0f ? sigma : radius / 3.0f);
+        const RenderGraphTexture description = graph.getDescription(destination);
+        if (computeShader && !fragmentPath)
+        {
+            graph.addPass("separable blur", PASS_COMPUTE, [this, &graph, source, destination, description, radius, weights]() {
+                blurCompute(graph.getTexture(source), graph.getTexture(destination), description.width, description.height, radius, weights);
+            }).read(source).write(destination, source == destination);
+            return;
+        }
+
+        const RenderGraph::Resource temporary = graph.createTexture("blur temporary",
+            RenderGraphTexture(description.width, description.height, description.internalFormat, GL_LINEAR));
+        for (unsigned int vertical = 0; vertical < 2; vertical++)
+        {
+            const RenderGraph::Resource input = vertical ? temporary : source;
+            graph.addPass(vertical ? "separable blur vertical" : "separable blur horizontal", PASS_RASTER, [this, &graph, input, vertical, radius, weights]() {
+                useFragmentShader(radius, weights);
+                drawFragment(graph.getTexture(input), vertical == 1);
+            }).read(input).write(vertical ? destination : temporary);
+        }
+    }
+
+private:
+    std::unique_ptr<ComputeShader> computeShader;
+    Shader fragmentShader;
+    unsigned int framebuffer;
+    unsigned int emptyVAO;
+
+    void blurCompute(unsigned int source, unsigned int destination, unsigned int width, unsigned int height, unsigned int radius,
+                     const std::vector<float>& weights)
+    {
+        // the image is bound with the destination's own format, so any float or normalized color format works
+        GLint internalFormat = GL_RGBA16F;
+        glBindTexture(GL_TEXTURE_2D, destination);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+
+        computeShader->use();
+        computeShader->setInt("source", 0);
+        computeShader->setInt("radius", (int)radius);
+        glUniform1fv(glGetUniformLocation(computeShader->ID, "weights"), (GLsizei)weights.size(), weights.data());
+        glActiveTexture(GL_TEXTURE0);
+        glBindImageTexture(0, destination, 0, GL_FALSE, 0, GL_WRITE_ONLY, internalFormat);
+
+        // one workgroup per row, then one per column of the horizontal result
+        glBindTexture(GL_TEXTURE_2D, source);
+        computeShader->setVec2("direction", 1.0f, 0.0f);
+        glDispatchCompute(height, 1, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        glBindTexture(GL_TEXTURE_2D, destination);
+        computeShader->setVec2("direction", 0.0f, 1.0f);
+        glDispatchCompute(width, 1, 1);
+    }
+
+    void blurFragment(unsigned int source, unsigned int destination, unsigned int temporary, unsigned int width, unsigned int height,
+                      unsigned int radius, const std::vector<float>& weights)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glViewport(0, 0, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        useFragmentShader(radius, weights);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, temporary, 0);
+        drawFragment(source, false);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, destination, 0);
+        drawFragment(temporary, true);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    void useFragmentShader(unsigned int radius, const std::vector<float>& weights)
+    {
+        // taps i and i + 1 become one fetch between them, at the offset where the bilinear weights match theirs
+        std::vector<float> offsets(1, 0.0f), linearWeights(1, weights[0]);
+        for (unsigned int i = 1; i <= radius; i += 2)
+        {
+            float weight = weights[i] + (i < radius ? weights[i + 1] : 0.0f);
+            float offset = i < radius ? (i * weights[i] + (i + 1) * weights[i + 1]) / weight : (float)i;
+            offsets.push_back(offset);
+            linearWeights.push_back(weight);
+        }
+
+        fragmentShader.use();
+        fragmentShader.setInt("tapCount", (int)offsets.size());
+        glUniform1fv(glGetUniformLocation(fragmentShader.ID, "offsets"), (GLsizei)offsets.size(), offsets.data());
+        glUniform1fv(glGetUniformLocation(fragmentShader.ID, "weights"), (GLsizei)linearWeights.size(), linearWeights.data());
+    }
+
+    // one direction into the bound framebuffer
+    void drawFragment(unsigned int source, bool vertical)
+    {
+        fragmentShader.setVec2("direction", vertical ? 0.0f : 1.0f, vertical ? 1.0f : 0.0f);
+        glBindVertexArray(emptyVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+};
+#endif
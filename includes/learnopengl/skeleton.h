@@ -0,0 +1,159 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <assimp/scene.h>
+#include <learnopengl/animdata.h>
+#include <learnopengl/assimp_glm_helpers.h>
+#include <learnopengl/bone.h>
+
+struct AssimpNodeData
+{
+	glm::mat4 transformation;
+	std::string name;
+	int childrenCount;
+	std::vector<AssimpNodeData> children;
+};
+
+/* One node of the compiled hierarchy, parents always come before their children */
+struct AnimationNode
+{
+	glm::mat4 transformation; // local transform used when no bone track animates the node
+	glm::mat4 offset; // model space to bone space, valid when boneIndex >= 0
+	int parentIndex; // -1 for the root
+	int boneIndex; // index in the final bone matrices, -1 if no vertex is bound to the node
+};
+
+/*
+	The node hierarchy of a rig and the bones the skinned vertices are bound to. Built once per model and
+	never changed afterwards, so every clip of the model and every Animator playing them share one instance
+	(std::shared_ptr<const Skeleton>, see Model::GetSkeleton).
+*/
+class Skeleton
+{
+public:
+	// the node tree below root, nodes named in boneInfoMap write the final bone matrix of their id
+	Skeleton(const aiNode* root, const std::map<std::string, BoneInfo>& boneInfoMap)
+		: m_BoneInfoMap(boneInfoMap)
+	{
+		ReadHierarchyData(m_RootNode, root);
+		CompileNode(m_RootNode, -1);
+	}
+
+	// already compiled nodes, e.g. read from a baked clip (see animation_clip.h)
+	Skeleton(const std::vector<AnimationNode>& nodes, const std::vector<std::string>& nodeNames)
+		: m_Nodes(nodes), m_NodeNames(nodeNames)
+	{
+		std::vector<std::vector<int>> children(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			m_BindPoses.push_back(MatrixToPose(nodes[i].transformation));
+			m_NodeIndices[nodeNames[i]] = static_cast<int>(i);
+			if (nodes[i].parentIndex >= 0)
+				children[nodes[i].parentIndex].push_back(static_cast<int>(i));
+			if (nodes[i].boneIndex >= 0)
+			{
+				m_BoneInfoMap[nodeNames[i]].id = nodes[i].boneIndex;
+				m_BoneInfoMap[nodeNames[i]].offset = nodes[i].offset;
+				m_BoneMatrixCount = std::max(m_BoneMatrixCount, nodes[i].boneIndex + 1);
+			}
+		}
+		if (!nodes.empty())
+			RebuildHierarchyData(m_RootNode, 0, children);
+	}
+
+	// the hierarchy flattened at load time, evaluating it in order is a single loop (see Animator)
+	const std::vector<AnimationNode>& GetNodes() const { return m_Nodes; }
+	// per compiled node: its name and its untouched transform as a pose (what unanimated nodes blend with)
+	const std::string& GetNodeName(int node) const { return m_NodeNames[node]; }
+	const std::vector<BonePose>& GetBindPoses() const { return m_BindPoses; }
+
+	// index of the named node, -1 if the skeleton has none
+	int FindNode(const std::string& name) const
+	{
+		auto iter = m_NodeIndices.find(name);
+		return iter == m_NodeIndices.end() ? -1 : iter->second;
+	}
+
+	// same nodes in the same order, so per node data of one skeleton is valid for the other
+	bool Matches(const std::vector<AnimationNode>& nodes, const std::vector<std::string>& nodeNames) const
+	{
+		if (nodes.size() != m_Nodes.size())
+			return false;
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			if (nodes[i].parentIndex != m_Nodes[i].parentIndex || nodes[i].boneIndex != m_Nodes[i].boneIndex || nodeNames[i] != m_NodeNames[i])
+				return false;
+		}
+		return true;
+	}
+
+	const AssimpNodeData& GetRootNode() const { return m_RootNode; }
+	const std::map<std::string, BoneInfo>& GetBoneIDMap() const { return m_BoneInfoMap; }
+
+	// number of final bone matrices the nodes write to
+	int GetBoneMatrixCount() const { return m_BoneMatrixCount; }
+
+private:
+	void ReadHierarchyData(AssimpNodeData& dest, const aiNode* src)
+	{
+		dest.name = src->mName.data;
+		dest.transformation = AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation);
+		dest.childrenCount = src->mNumChildren;
+
+		for (unsigned int i = 0; i < src->mNumChildren; i++)
+		{
+			AssimpNodeData newData;
+			ReadHierarchyData(newData, src->mChildren[i]);
+			dest.children.push_back(newData);
+		}
+	}
+
+	// the node tree of GetRootNode from the compiled nodes
+	void RebuildHierarchyData(AssimpNodeData& dest, int node, const std::vector<std::vector<int>>& children)
+	{
+		dest.name = m_NodeNames[node];
+		dest.transformation = m_Nodes[node].transformation;
+		dest.childrenCount = static_cast<int>(children[node].size());
+		dest.children.resize(children[node].size());
+		for (size_t i = 0; i < children[node].size(); i++)
+			RebuildHierarchyData(dest.children[i], children[node][i], children);
+	}
+
+	// depth-first, so every parent is written before its children
+	void CompileNode(const AssimpNodeData& src, int parentIndex)
+	{
+		AnimationNode node;
+		node.transformation = src.transformation;
+		node.offset = glm::mat4(1.0f);
+		node.parentIndex = parentIndex;
+		node.boneIndex = -1;
+
+		auto boneInfo = m_BoneInfoMap.find(src.name);
+		if (boneInfo != m_BoneInfoMap.end())
+		{
+			node.boneIndex = boneInfo->second.id;
+			node.offset = boneInfo->second.offset;
+			m_BoneMatrixCount = std::max(m_BoneMatrixCount, node.boneIndex + 1);
+		}
+
+		const int index = static_cast<int>(m_Nodes.size());
+		m_Nodes.push_back(node);
+		m_NodeNames.push_back(src.name);
+		m_NodeIndices[src.name] = index;
+		m_BindPoses.push_back(MatrixToPose(src.transformation));
+		for (int i = 0; i < src.childrenCount; i++)
+			CompileNode(src.children[i], index);
+	}
+
+	AssimpNodeData m_RootNode;
+	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
+	std::vector<std::string> m_NodeNames; // parallel to m_Nodes, kept apart so the evaluation loop stays compact
+	std::vector<BonePose> m_BindPoses; // parallel to m_Nodes
+	std::unordered_map<std::string, int> m_NodeIndices; // node name -> index in m_Nodes
+	int m_BoneMatrixCount = 0;
+};
@@ -0,0 +1,265 @@
+#ifndef SKINNING_CACHE_H
+#define SKINNING_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_c.h>
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKINNING_CACHE_SSE
+#include <emmintrin.h>
+#endif
+
+// Shader storage bindings of the skinning compute shader
+const unsigned int SKINNING_BIND_POSE_BINDING = 0;
+const unsigned int SKINNING_PALETTE_BINDING   = 1;
+const unsigned int SKINNING_OUTPUT_BINDING    = 2;
+
+// std430 layout of the skinning input, one per Mesh vertex
+struct SkinningInputVertex
+{
+    glm::vec4 position;
+    glm::vec4 normal;
+    glm::vec4 tangent;
+    glm::vec4 bitangent;
+    glm::ivec4 boneIds;
+    glm::vec4 weights;
+};
+
+// std430 layout of the skinning output, read as vertex attributes 0, 1, 3 and 4 (like Vertex)
+struct SkinnedVertex
+{
+    glm::vec4 position;
+    glm::vec4 normal;
+    glm::vec4 tangent;
+    glm::vec4 bitangent;
+};
+
+// xyz normalized, w = 0. Zero vectors (meshes without tangents) stay zero.
+inline glm::vec4 normalizeDirection(const glm::vec4& direction)
+{
+    const glm::vec3 xyz(direction);
+    const float length = glm::length(xyz);
+    return glm::vec4(length > 0.0f ? xyz / length : xyz, 0.0f);
+}
+
+// Skins every vertex against the palette on the CPU, same math as the compute shader: the weighted sum of
+// the bone matrices transforms the position and (renormalized) the direction vectors. Bone ids outside the
+// palette are ignored, vertices without any valid weight keep their bind pose. Used to verify the GPU path
+// and where no GL 4.3 context is available.
+inline void skinVertices(const SkinningInputVertex* input, SkinnedVertex* output, size_t count, const glm::mat4* palette, unsigned int boneCount)
+{
+    for (size_t v = 0; v < count; v++)
+    {
+        const SkinningInputVertex& vertex = input[v];
+        SkinnedVertex& skinned = output[v];
+#ifdef SKINNING_CACHE_SSE
+        __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps(), c2 = _mm_setzero_ps(), c3 = _mm_setzero_ps();
+        float totalWeight = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            const int bone = vertex.boneIds[i];
+            if (bone < 0 || bone >= static_cast<int>(boneCount))
+                continue;
+            const __m128 weight = _mm_set1_ps(vertex.weights[i]);
+            const float* matrix = &palette[bone][0][0];
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(matrix + 0), weight));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(matrix + 4), weight));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(matrix + 8), weight));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(matrix + 12), weight));
+            totalWeight += vertex.weights[i];
+        }
+        if (totalWeight == 0.0f)
+        {
+            skinned.position = vertex.position;
+            skinned.normal = vertex.normal;
+            skinned.tangent = vertex.tangent;
+            skinned.bitangent = vertex.bitangent;
+            continue;
+        }
+
+        // column major: m * v = c0 * v.x + c1 * v.y + c2 * v.z (+ c3 for points)
+        const glm::vec4* directions[4] = { &vertex.position, &vertex.normal, &vertex.tangent, &vertex.bitangent };
+        glm::vec4* results[4] = { &skinned.position, &skinned.normal, &skinned.tangent, &skinned.bitangent };
+        for (int d = 0; d < 4; d++)
+        {
+            const glm::vec4& in = *directions[d];
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in.x)), _mm_mul_ps(c1, _mm_set1_ps(in.y))), _mm_mul_ps(c2, _mm_set1_ps(in.z)));
+            if (d == 0)
+                sum = _mm_add_ps(sum, c3);
+            _mm_storeu_ps(&(*results[d])[0], sum);
+        }
+#else
+        glm::mat4 blended(0.0f);
+        float totalWeight = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            const int bone = vertex.boneIds[i];
+            if (bone < 0 || bone >= static_cast<int>(boneCount))
+                continue;
+            blended += palette[bone] * vertex.weights[i];
+            totalWeight += vertex.weights[i];
+        }
+        if (totalWeight == 0.0f)
+        {
+            skinned.position = vertex.position;
+            skinned.normal = vertex.normal;
+            skinned.tangent = vertex.tangent;
+            skinned.bitangent = vertex.bitangent;
+            continue;
+        }
+        skinned.position = blended * glm::vec4(glm::vec3(vertex.position), 1.0f);
+        skinned.normal = blended * glm::vec4(glm::vec3(vertex.normal), 0.0f);
+        skinned.tangent = blended * glm::vec4(glm::vec3(vertex.tangent), 0.0f);
+        skinned.bitangent = blended * glm::vec4(glm::vec3(vertex.bitangent), 0.0f);
+#endif
+        skinned.position.w = 1.0f;
+        skinned.normal = normalizeDirection(skinned.normal);
+        skinned.tangent = normalizeDirection(skinned.tangent);
+        skinned.bitangent = normalizeDirection(skinned.bitangent);
+    }
+}
+
+// the bind pose of a mesh in the layout the skinning pass reads
+inline std::vector<SkinningInputVertex> createSkinningInput(const Mesh& mesh)
+{
+    std::vector<SkinningInputVertex> input(mesh.vertices.size());
+    for (size_t v = 0; v < mesh.vertices.size(); v++)
+    {
+        const Vertex& vertex = mesh.vertices[v];
+        input[v].position = glm::vec4(vertex.Position, 1.0f);
+        input[v].normal = glm::vec4(vertex.Normal, 0.0f);
+        input[v].tangent = glm::vec4(vertex.Tangent, 0.0f);
+        input[v].bitangent = glm::vec4(vertex.Bitangent, 0.0f);
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            input[v].boneIds[i] = vertex.m_BoneIDs[i];
+            input[v].weights[i] = GetBoneWeight(vertex, i);
+        }
+    }
+    return input;
+}
+
+// Skins a mesh once per frame with a compute shader into a vertex buffer that every following pass (shadow
+// faces, depth prepass, G-buffer, forward) draws like a static mesh, instead of skinning again in each of
+// their vertex shaders. Those passes use plain vertex shaders reading attributes 0-4 like Vertex.
+class SkinningCache
+{
+public:
+    // skinShaderPath is the compute shader (skinning.cs), maxBones the largest palette update() receives
+    SkinningCache(const char* skinShaderPath, const Mesh& mesh, unsigned int maxBones = 100)
+        : skinShader(skinShaderPath), vertexCount(static_cast<unsigned int>(mesh.vertices.size())),
+          indexCount(static_cast<unsigned int>(mesh.indices.size())), maxBones(maxBones)
+    {
+        input = createSkinningInput(mesh);
+        std::vector<glm::vec2> texCoords(mesh.vertices.size());
+        for (size_t v = 0; v < mesh.vertices.size(); v++)
+            texCoords[v] = mesh.vertices[v].TexCoords;
+
+        glGenBuffers(1, &bindPoseBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, bindPoseBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, input.size() * sizeof(SkinningInputVertex), input.data(), GL_STATIC_DRAW);
+
+        glGenBuffers(1, &paletteBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, paletteBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, maxBones * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &skinnedBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, skinnedBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, vertexCount * sizeof(SkinnedVertex), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // the skinned buffer doubles as the vertex buffer, texture coordinates don't change and come from their own buffer
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &texCoordBuffer);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, skinnedBuffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, normal));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, bitangent));
+        glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+        glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    ~SkinningCache()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &bindPoseBuffer);
+        glDeleteBuffers(1, &paletteBuffer);
+        glDeleteBuffers(1, &skinnedBuffer);
+        glDeleteBuffers(1, &texCoordBuffer);
+        glDeleteBuffers(1, &EBO);
+        glDeleteProgram(skinShader.ID);
+    }
+
+    SkinningCache(const SkinningCache&) = delete;
+    SkinningCache& operator=(const SkinningCache&) = delete;
+
+    // skins the mesh with this frame's bone matrices (e.g. Animator::GetFinalBoneMatrices), once before all passes
+    void update(const glm::mat4* palette, unsigned int boneCount)
+    {
+        boneCount = std::min(boneCount, maxBones);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, paletteBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, boneCount * sizeof(glm::mat4), palette);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        skinShader.use();
+        skinShader.setInt("vertexCount", static_cast<int>(vertexCount));
+        skinShader.setInt("boneCount", static_cast<int>(boneCount));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_BIND_POSE_BINDING, bindPoseBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_PALETTE_BINDING, paletteBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_OUTPUT_BINDING, skinnedBuffer);
+        glDispatchCompute((vertexCount + 63) / 64, 1, 1);
+
+        // the passes read the result as vertex attributes
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    }
+
+    // draws the last skinned result, the caller binds the (static) shader and its textures
+    void draw() const
+    {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    // reads the skinned vertices back, waits for the GPU. For verification against skinVertices.
+    std::vector<SkinnedVertex> readBack() const
+    {
+        std::vector<SkinnedVertex> result(vertexCount);
+        // update() only orders the compute writes before vertex fetch, buffer reads need their own bit
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, skinnedBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, result.size() * sizeof(SkinnedVertex), result.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return result;
+    }
+
+    // the bind pose as uploaded, input of skinVertices
+    const std::vector<SkinningInputVertex>& getInput() const { return input; }
+    unsigned int getVertexCount() const { return vertexCount; }
+
+private:
+    ComputeShader skinShader;
+    unsigned int vertexCount, indexCount, maxBones;
+    unsigned int VAO, bindPoseBuffer, paletteBuffer, skinnedBuffer, texCoordBuffer, EBO;
+    std::vector<SkinningInputVertex> input;
+};
+#endif
@@ -0,0 +1,632 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Spatial indices for dynamic objects, keyed on world space boxes (e.g. Entity::getGlobalAABB()).
+// Objects are identified by a caller chosen id (an index into the caller's own entity array), ids are
+// used as array indices internally so keep them dense. Both structures support O(1) amortized
+// insert/update/remove and range, sphere, frustum and ray queries.
+
+// min/max box used internally, cheaper to store and test than the virtual AABB of entity.h
+struct SpatialBox
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    SpatialBox() = default;
+    SpatialBox(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+    SpatialBox(const AABB& aabb) : min(aabb.center - aabb.extents), max(aabb.center + aabb.extents) {}
+
+    bool overlaps(const SpatialBox& other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+            min.y <= other.max.y && max.y >= other.min.y &&
+            min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    bool overlapsSphere(const glm::vec3& center, float radius) const
+    {
+        const glm::vec3 closest = glm::clamp(center, min, max);
+        const glm::vec3 d = closest - center;
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    // same test as AABB::isOnOrForwardPlane, for all six planes
+    bool isOnFrustum(const Frustum& frustum) const
+    {
+        const glm::vec3 center = (min + max) * 0.5f;
+        const glm::vec3 extents = (max - min) * 0.5f;
+        const Plane* planes[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+        for (int i = 0; i < 6; i++)
+        {
+            const glm::vec3& n = planes[i]->normal;
+            const float r = extents.x * std::abs(n.x) + extents.y * std::abs(n.y) + extents.z * std::abs(n.z);
+            if (planes[i]->getSignedDistanceToPlane(center) < -r)
+                return false;
+        }
+        return true;
+    }
+
+    // slab test, returns the entry distance along the ray in tHit
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, float& tHit) const
+    {
+        const glm::vec3 t0 = (min - origin) * invDirection;
+        const glm::vec3 t1 = (max - origin) * invDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        const float enter = std::max(std::max(std::max(tNear.x, tNear.y), tNear.z), 0.0f);
+        const float exit = std::min(std::min(std::min(tFar.x, tFar.y), tFar.z), maxDistance);
+        tHit = enter;
+        return enter <= exit;
+    }
+};
+
+// avoids inf * 0 = nan in the slab test for axis aligned rays
+inline glm::vec3 spatialInverseDirection(const glm::vec3& direction)
+{
+    const float big = 1e30f;
+    return glm::vec3(direction.x != 0.0f ? 1.0f / direction.x : big,
+        direction.y != 0.0f ? 1.0f / direction.y : big,
+        direction.z != 0.0f ? 1.0f / direction.z : big);
+}
+
+// Uniform grid hashed into a map of occupied cells. An object is stored in every cell its box touches,
+// so keep the cell size around the typical object size. Moving within the same cells only updates the box.
+class SpatialHash
+{
+public:
+    SpatialHash(float cellSize) : cellSize(cellSize), invCellSize(1.0f / cellSize) {}
+
+    void insert(unsigned int id, const SpatialBox& box)
+    {
+        if (id >= objects.size())
+        {
+            objects.resize(id + 1);
+            queryStamps.resize(id + 1, 0);
+        }
+        // inserting a live id again moves it instead of storing it twice
+        if (contains(id))
+        {
+            update(id, box);
+            return;
+        }
+        Object& object = objects[id];
+        object.box = box;
+        object.cellMin = cellOf(box.min);
+        object.cellMax = cellOf(box.max);
+        object.alive = true;
+        forEachCell(object.cellMin, object.cellMax, [&](uint64_t key) { addToCell(key, id); });
+        count++;
+    }
+
+    void insert(unsigned int id, Entity& entity) { insert(id, SpatialBox(entity.getGlobalAABB())); }
+
+    // ids that aren't stored are ignored, an update must not bring a removed object back
+    void update(unsigned int id, const SpatialBox& box)
+    {
+        if (!contains(id))
+            return;
+        Object& object = objects[id];
+        const glm::ivec3 cellMin = cellOf(box.min);
+        const glm::ivec3 cellMax = cellOf(box.max);
+        object.box = box;
+        if (cellMin == object.cellMin && cellMax == object.cellMax)
+            return;
+
+        forEachCell(object.cellMin, object.cellMax, [&](uint64_t key) { removeFromCell(key, id); });
+        object.cellMin = cellMin;
+        object.cellMax = cellMax;
+        forEachCell(cellMin, cellMax, [&](uint64_t key) { addToCell(key, id); });
+    }
+
+    void update(unsigned int id, Entity& entity) { update(id, SpatialBox(entity.getGlobalAABB())); }
+
+    void remove(unsigned int id)
+    {
+        if (!contains(id))
+            return;
+        Object& object = objects[id];
+        forEachCell(object.cellMin, object.cellMax, [&](uint64_t key) { removeFromCell(key, id); });
+        object.alive = false;
+        count--;
+    }
+
+    void queryRange(const SpatialBox& range, std::vector<unsigned int>& result)
+    {
+        nextStamp();
+        forEachCell(cellOf(range.min), cellOf(range.max), [&](uint64_t key) {
+            auto cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+            for (unsigned int id : cell->second)
+            {
+                if (visit(id) && objects[id].box.overlaps(range))
+                    result.push_back(id);
+            }
+        });
+    }
+
+    void querySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& result)
+    {
+        nextStamp();
+        forEachCell(cellOf(center - radius), cellOf(center + radius), [&](uint64_t key) {
+            auto cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+            for (unsigned int id : cell->second)
+            {
+                if (visit(id) && objects[id].box.overlapsSphere(center, radius))
+                    result.push_back(id);
+            }
+        });
+    }
+
+    // walks the blocks of 4x4x4 cells inside the frustum's bounding box, rejecting them against the planes first, and
+    // visits only the occupied cells of each block. When there are fewer occupied blocks than blocks in that box
+    // (far planes, sparse worlds) the occupied blocks are tested instead.
+    void queryFrustum(const Frustum& frustum, std::vector<unsigned int>& result)
+    {
+        nextStamp();
+        glm::ivec3 rangeMin, rangeMax;
+        const bool bounded = frustumCellRange(frustum, rangeMin, rangeMax);
+        const glm::ivec3 blockMin = rangeMin >> 2;
+        const glm::ivec3 blockMax = rangeMax >> 2;
+        const glm::vec3 rangeBlocks = glm::vec3(blockMax - blockMin + 1);
+        if (!bounded || rangeBlocks.x * rangeBlocks.y * rangeBlocks.z > static_cast<float>(blocks.size()))
+        {
+            for (auto&& block : blocks)
+                testBlock(unpackKey(block.first), block.second, frustum, result);
+            return;
+        }
+
+        for (int z = blockMin.z; z <= blockMax.z; z++)
+            for (int y = blockMin.y; y <= blockMax.y; y++)
+                for (int x = blockMin.x; x <= blockMax.x; x++)
+                {
+                    auto block = blocks.find(packKey(glm::ivec3(x, y, z)));
+                    if (block != blocks.end())
+                        testBlock(glm::ivec3(x, y, z), block->second, frustum, result);
+                }
+    }
+
+    // walks the cells along the ray (3D DDA) and returns the nearest hit
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, unsigned int& hitId, float& hitDistance)
+    {
+        nextStamp();
+        const glm::vec3 invDirection = spatialInverseDirection(direction);
+        glm::ivec3 cell = cellOf(origin);
+        const glm::ivec3 step(direction.x >= 0.0f ? 1 : -1, direction.y >= 0.0f ? 1 : -1, direction.z >= 0.0f ? 1 : -1);
+        // distance to the next cell boundary per axis and distance between boundaries
+        glm::vec3 tMax, tDelta;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const float boundary = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * cellSize;
+            tMax[axis] = (boundary - origin[axis]) * invDirection[axis];
+            tDelta[axis] = cellSize * std::abs(invDirection[axis]);
+        }
+
+        bool hit = false;
+        hitDistance = maxDistance;
+        float tCell = 0.0f;
+        while (tCell <= hitDistance)
+        {
+            auto found = cells.find(packKey(cell));
+            if (found != cells.end())
+            {
+                for (unsigned int id : found->second)
+                {
+                    float t;
+                    if (visit(id) && objects[id].box.intersectRay(origin, invDirection, hitDistance, t))
+                    {
+                        hit = true;
+                        hitId = id;
+                        hitDistance = t;
+                    }
+                }
+            }
+            const int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+            tCell = tMax[axis];
+            tMax[axis] += tDelta[axis];
+            cell[axis] += step[axis];
+        }
+        return hit;
+    }
+
+    bool contains(unsigned int id) const { return id < objects.size() && objects[id].alive; }
+    unsigned int size() const { return count; }
+    size_t getCellCount() const { return cells.size(); }
+
+private:
+    struct Object
+    {
+        SpatialBox box;
+        glm::ivec3 cellMin, cellMax;
+        bool alive = false;
+    };
+
+    float cellSize, invCellSize;
+    std::unordered_map<uint64_t, std::vector<unsigned int>> cells;
+    // one bit per occupied cell of each 4x4x4 block, so the frustum walk skips empty cells without looking them up
+    std::unordered_map<uint64_t, uint64_t> blocks;
+    std::vector<Object> objects;
+    unsigned int count = 0;
+
+    // objects spanning several cells are reported once per query
+    std::vector<unsigned int> queryStamps;
+    unsigned int stamp = 0;
+
+    glm::ivec3 cellOf(const glm::vec3& p) const
+    {
+        return glm::ivec3(glm::floor(p * invCellSize));
+    }
+
+    // 21 bits per axis, cells within +-1M of the origin
+    static uint64_t packKey(const glm::ivec3& c)
+    {
+        const uint64_t mask = (1ull << 21) - 1;
+        return ((static_cast<uint64_t>(c.x) & mask) << 42) | ((static_cast<uint64_t>(c.y) & mask) << 21) | (static_cast<uint64_t>(c.z) & mask);
+    }
+
+    static glm::ivec3 unpackKey(uint64_t key)
+    {
+        // shift the 21 bit fields to the top (unsigned, so nothing overflows) and back to sign extend them
+        return glm::ivec3(static_cast<int>(static_cast<int64_t>(key << 1) >> 43), static_cast<int>(static_cast<int64_t>(key << 22) >> 43),
+            static_cast<int>(static_cast<int64_t>(key << 43) >> 43));
+    }
+
+    template<typename TFunc>
+    void forEachCell(const glm::ivec3& cellMin, const glm::ivec3& cellMax, TFunc func)
+    {
+        for (int z = cellMin.z; z <= cellMax.z; z++)
+            for (int y = cellMin.y; y <= cellMax.y; y++)
+                for (int x = cellMin.x; x <= cellMax.x; x++)
+                    func(packKey(glm::ivec3(x, y, z)));
+    }
+
+    SpatialBox cellBox(const glm::ivec3& cellMin, const glm::ivec3& cellMax) const
+    {
+        return SpatialBox(glm::vec3(cellMin) * cellSize, glm::vec3(cellMax + 1) * cellSize);
+    }
+
+    static uint64_t blockKey(uint64_t cellKey)
+    {
+        return packKey(unpackKey(cellKey) >> 2);
+    }
+
+    static uint64_t blockBit(uint64_t cellKey)
+    {
+        const glm::ivec3 local = unpackKey(cellKey) & 3;
+        return 1ull << (local.x | (local.y << 2) | (local.z << 4));
+    }
+
+    void addToCell(uint64_t key, unsigned int id)
+    {
+        std::vector<unsigned int>& ids = cells[key];
+        if (ids.empty())
+            blocks[blockKey(key)] |= blockBit(key);
+        ids.push_back(id);
+    }
+
+    void testBlock(const glm::ivec3& block, uint64_t occupied, const Frustum& frustum, std::vector<unsigned int>& result)
+    {
+        const glm::ivec3 first = block * 4;
+        if (!cellBox(first, first + 3).isOnFrustum(frustum))
+            return;
+        for (int bit = 0; occupied != 0; bit++, occupied >>= 1)
+        {
+            if (occupied & 1)
+                testCell(cells.find(packKey(first + glm::ivec3(bit & 3, (bit >> 2) & 3, bit >> 4)))->second, frustum, result);
+        }
+    }
+
+    void testCell(const std::vector<unsigned int>& ids, const Frustum& frustum, std::vector<unsigned int>& result)
+    {
+        for (unsigned int id : ids)
+        {
+            if (visit(id) && objects[id].box.isOnFrustum(frustum))
+                result.push_back(id);
+        }
+    }
+
+    // cell range of the frustum's corners, each corner is where three of the planes meet
+    bool frustumCellRange(const Frustum& frustum, glm::ivec3& rangeMin, glm::ivec3& rangeMax) const
+    {
+        const Plane* depth[2] = { &frustum.nearFace, &frustum.farFace };
+        const Plane* side[2] = { &frustum.leftFace, &frustum.rightFace };
+        const Plane* height[2] = { &frustum.bottomFace, &frustum.topFace };
+        glm::vec3 lower(std::numeric_limits<float>::max()), upper(-std::numeric_limits<float>::max());
+        for (int i = 0; i < 8; i++)
+        {
+            const Plane& a = *depth[i & 1];
+            const Plane& b = *side[(i >> 1) & 1];
+            const Plane& c = *height[(i >> 2) & 1];
+            const glm::vec3 bc = glm::cross(b.normal, c.normal);
+            const float denominator = glm::dot(a.normal, bc);
+            if (std::abs(denominator) < 1e-6f)
+                return false;
+            const glm::vec3 corner = (a.distance * bc + b.distance * glm::cross(c.normal, a.normal) + c.distance * glm::cross(a.normal, b.normal)) / denominator;
+            lower = glm::min(lower, corner);
+            upper = glm::max(upper, corner);
+        }
+        // keep the cell coordinates inside the 21 bit key range
+        const glm::vec3 limit((1 << 20) - 1);
+        rangeMin = glm::ivec3(glm::clamp(glm::floor(lower * invCellSize), -limit, limit));
+        rangeMax = glm::ivec3(glm::clamp(glm::floor(upper * invCellSize), -limit, limit));
+        return true;
+    }
+
+    void removeFromCell(uint64_t key, unsigned int id)
+    {
+        auto cell = cells.find(key);
+        std::vector<unsigned int>& ids = cell->second;
+        auto it = std::find(ids.begin(), ids.end(), id);
+        *it = ids.back();
+        ids.pop_back();
+        if (ids.empty())
+        {
+            cells.erase(cell);
+            auto block = blocks.find(blockKey(key));
+            block->second &= ~blockBit(key);
+            if (block->second == 0)
+                blocks.erase(block);
+        }
+    }
+
+    void nextStamp()
+    {
+        if (++stamp == 0)
+        {
+            std::fill(queryStamps.begin(), queryStamps.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    bool visit(unsigned int id)
+    {
+        if (queryStamps[id] == stamp)
+            return false;
+        queryStamps[id] = stamp;
+        return true;
+    }
+};
+
+// Loose octree (looseness 2) over a fixed world cube. An object lives in exactly one node: the deepest level
+// whose cells are at least as large as the object, in the cell containing the object's center. That node
+// is computed directly from the box, so insert/update/remove never search the tree.
+// Objects outside the world cube are kept in the root, which is always tested.
+class LooseOctree
+{
+public:
+    LooseOctree(const glm::vec3& center, float halfSize, unsigned int maxDepth = 8)
+        : rootCenter(center), rootHalfSize(halfSize), maxDepth(std::min(maxDepth, 20u))
+    {
+        nodes.push_back(Node());
+    }
+
+    void insert(unsigned int id, const SpatialBox& box)
+    {
+        if (id >= objects.size())
+            objects.resize(id + 1);
+        // inserting a live id again moves it instead of linking it twice
+        if (contains(id))
+        {
+            update(id, box);
+            return;
+        }
+        Object& object = objects[id];
+        object.box = box;
+        object.cell = cellOf(box);
+        link(id, findOrCreateNode(object.cell));
+        count++;
+    }
+
+    void insert(unsigned int id, Entity& entity) { insert(id, SpatialBox(entity.getGlobalAABB())); }
+
+    // ids that aren't stored are ignored, an update must not bring a removed object back
+    void update(unsigned int id, const SpatialBox& box)
+    {
+        if (!contains(id))
+            return;
+        Object& object = objects[id];
+        object.box = box;
+        const glm::ivec4 cell = cellOf(box);
+        if (cell == object.cell)
+            return;
+        unlink(id);
+        object.cell = cell;
+        link(id, findOrCreateNode(cell));
+    }
+
+    void update(unsigned int id, Entity& entity) { update(id, SpatialBox(entity.getGlobalAABB())); }
+
+    void remove(unsigned int id)
+    {
+        if (!contains(id))
+            return;
+        unlink(id);
+        count--;
+    }
+
+    void queryRange(const SpatialBox& range, std::vector<unsigned int>& result) const
+    {
+        query(0, rootCenter, rootHalfSize,
+            [&](const SpatialBox& bounds) { return bounds.overlaps(range); },
+            [&](const SpatialBox& box) { return box.overlaps(range); }, result);
+    }
+
+    void querySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const
+    {
+        query(0, rootCenter, rootHalfSize,
+            [&](const SpatialBox& bounds) { return bounds.overlapsSphere(center, radius); },
+            [&](const SpatialBox& box) { return box.overlapsSphere(center, radius); }, result);
+    }
+
+    void queryFrustum(const Frustum& frustum, std::vector<unsigned int>& result) const
+    {
+        query(0, rootCenter, rootHalfSize,
+            [&](const SpatialBox& bounds) { return bounds.isOnFrustum(frustum); },
+            [&](const SpatialBox& box) { return box.isOnFrustum(frustum); }, result);
+    }
+
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, unsigned int& hitId, float& hitDistance) const
+    {
+        hitDistance = maxDistance;
+        bool hit = false;
+        raycastNode(0, rootCenter, rootHalfSize, origin, spatialInverseDirection(direction), hitId, hitDistance, hit);
+        return hit;
+    }
+
+    bool contains(unsigned int id) const { return id < objects.size() && objects[id].node >= 0; }
+    unsigned int size() const { return count; }
+    size_t getNodeCount() const { return nodes.size(); }
+
+private:
+    struct Node
+    {
+        int children[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+        std::vector<unsigned int> objects;
+        unsigned int subtreeCount = 0; // objects in this node and below, empty branches are skipped by queries
+        int parent = -1;
+    };
+
+    struct Object
+    {
+        SpatialBox box;
+        glm::ivec4 cell; // xyz = cell at depth w
+        int node = -1;
+        unsigned int slot = 0; // index in node.objects
+    };
+
+    glm::vec3 rootCenter;
+    float rootHalfSize;
+    unsigned int maxDepth;
+    std::vector<Node> nodes;
+    std::vector<Object> objects;
+    unsigned int count = 0;
+
+    // depth and cell of the node an object belongs to, depth -1 marks objects outside the world cube
+    glm::ivec4 cellOf(const SpatialBox& box) const
+    {
+        const glm::vec3 center = (box.min + box.max) * 0.5f;
+        const glm::vec3 local = center - (rootCenter - rootHalfSize);
+        if (glm::any(glm::lessThan(local, glm::vec3(0.0f))) || glm::any(glm::greaterThanEqual(local, glm::vec3(rootHalfSize * 2.0f))))
+            return glm::ivec4(0, 0, 0, -1);
+
+        // a node at depth d has half size h / 2^d and loose bounds of twice that, so an object fits
+        // when its largest half extent is at most the node's half size
+        const glm::vec3 extents = (box.max - box.min) * 0.5f;
+        const float largest = std::max(std::max(extents.x, extents.y), extents.z);
+        int depth = static_cast<int>(maxDepth);
+        if (largest > 0.0f)
+            depth = std::min(depth, static_cast<int>(std::floor(std::log2(rootHalfSize / largest))));
+        depth = std::max(depth, 0);
+
+        const float cellSize = rootHalfSize * 2.0f / static_cast<float>(1 << depth);
+        const glm::ivec3 cell = glm::min(glm::ivec3(local / cellSize), glm::ivec3((1 << depth) - 1));
+        return glm::ivec4(cell, depth);
+    }
+
+    int findOrCreateNode(const glm::ivec4& cell)
+    {
+        int node = 0;
+        for (int level = cell.w - 1; level >= 0; level--)
+        {
+            const int child = ((cell.x >> level) & 1) | (((cell.y >> level) & 1) << 1) | (((cell.z >> level) & 1) << 2);
+            if (nodes[node].children[child] < 0)
+            {
+                nodes[node].children[child] = static_cast<int>(nodes.size());
+                Node created;
+                created.parent = node;
+                nodes.push_back(created); // may reallocate, don't hold references across this
+            }
+            node = nodes[node].children[child];
+        }
+        return node;
+    }
+
+    void link(unsigned int id, int node)
+    {
+        Object& object = objects[id];
+        object.node = node;
+        object.slot = static_cast<unsigned int>(nodes[node].objects.size());
+        nodes[node].objects.push_back(id);
+        for (int n = node; n >= 0; n = nodes[n].parent)
+            nodes[n].subtreeCount++;
+    }
+
+    void unlink(unsigned int id)
+    {
+        Object& object = objects[id];
+        std::vector<unsigned int>& list = nodes[object.node].objects;
+        const unsigned int moved = list.back();
+        list[object.slot] = moved;
+        objects[moved].slot = object.slot;
+        list.pop_back();
+        for (int n = object.node; n >= 0; n = nodes[n].parent)
+            nodes[n].subtreeCount--;
+        object.node = -1;
+    }
+
+    template<typename TNodeTest, typename TObjectTest>
+    void query(int node, const glm::vec3& center, float halfSize, const TNodeTest& nodeTest, const TObjectTest& objectTest, std::vector<unsigned int>& result) const
+    {
+        const Node& current = nodes[node];
+        for (unsigned int id : current.objects)
+        {
+            if (objectTest(objects[id].box))
+                result.push_back(id);
+        }
+
+        const float childHalf = halfSize * 0.5f;
+        for (int i = 0; i < 8; i++)
+        {
+            const int child = current.children[i];
+            if (child < 0 || nodes[child].subtreeCount == 0)
+                continue;
+            const glm::vec3 childCenter = center + glm::vec3((i & 1) ? childHalf : -childHalf, (i & 2) ? childHalf : -childHalf, (i & 4) ? childHalf : -childHalf);
+            // loose bounds: twice the cell
+            if (nodeTest(SpatialBox(childCenter - 2.0f * childHalf, childCenter + 2.0f * childHalf)))
+                query(child, childCenter, childHalf, nodeTest, objectTest, result);
+        }
+    }
+
+    void raycastNode(int node, const glm::vec3& center, float halfSize, const glm::vec3& origin, const glm::vec3& invDirection, unsigned int& hitId, float& hitDistance, bool& hit) const
+    {
+        const Node& current = nodes[node];
+        for (unsigned int id : current.objects)
+        {
+            float t;
+            if (objects[id].box.intersectRay(origin, invDirection, hitDistance, t))
+            {
+                hit = true;
+                hitId = id;
+                hitDistance = t;
+            }
+        }
+
+        const float childHalf = halfSize * 0.5f;
+        for (int i = 0; i < 8; i++)
+        {
+            const int child = current.children[i];
+            if (child < 0 || nodes[child].subtreeCount == 0)
+                continue;
+            const glm::vec3 childCenter = center + glm::vec3((i & 1) ? childHalf : -childHalf, (i & 2) ? childHalf : -childHalf, (i & 4) ? childHalf : -childHalf);
+            float t;
+            if (SpatialBox(childCenter - 2.0f * childHalf, childCenter + 2.0f * childHalf).intersectRay(origin, invDirection, hitDistance, t))
+                raycastNode(child, childCenter, childHalf, origin, invDirection, hitId, hitDistance, hit);
+        }
+    }
+};
+#endif